@@ -1,3 +1,4 @@
+#define _XOPEN_SOURCE 600  /* fseeko, posix_memalign, posix_fadvise */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,6 +6,11 @@
 #include <float.h>
 #include <math.h>
 #include <time.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
@@ -37,6 +43,15 @@
 #define byte_rewind   FORTRAN_NAME(byte_rewind,   BYTE_REWIND )
 #define byte_read     FORTRAN_NAME(byte_read,     BYTE_READ   )
 #define byte_write    FORTRAN_NAME(byte_write,    BYTE_WRITE  )
+#define byte_seek     FORTRAN_NAME(byte_seek,     BYTE_SEEK   )
+#define byte_select   FORTRAN_NAME(byte_select,   BYTE_SELECT )
+#define byte_move     FORTRAN_NAME(byte_move,     BYTE_MOVE   )
+#define byte_map      FORTRAN_NAME(byte_map,      BYTE_MAP    )
+#define byte_mread    FORTRAN_NAME(byte_mread,    BYTE_MREAD  )
+#define byte_mlen     FORTRAN_NAME(byte_mlen,     BYTE_MLEN   )
+#define byte_zip      FORTRAN_NAME(byte_zip,      BYTE_ZIP    )
+#define byte_unzip    FORTRAN_NAME(byte_unzip,    BYTE_UNZIP  )
+#define byte_xref     FORTRAN_NAME(byte_xref,     BYTE_XREF   )
 #define set_bytesw_write FORTRAN_NAME(set_bytesw_write,SET_BYTESW_WRITE)
 #define set_bytesw_read  FORTRAN_NAME(set_bytesw_read ,SET_BYTESW_READ )
 #define get_bytesw_write FORTRAN_NAME(get_bytesw_write,GET_BYTESW_WRITE)
@@ -48,9 +63,29 @@
 
 #define SWAP(a,b)       temp=(a); (a)=(b); (b)=temp;
 
-static FILE *fp=NULL;
-static int  flag=0;
-static char name[MAX_NAME+1];
+#ifndef BYTE_BUF
+#define BYTE_BUF (4<<20)   /* i/o buffer per handle, bytes */
+#endif
+#define MAX_HANDLE 4
+
+static struct bfile
+{
+  int fd, flag;
+  char name[MAX_NAME+1];
+  char *buf;               /* BYTE_BUF bytes, allocated on first use */
+  size_t blen, bpos;       /* valid bytes, position within buffer */
+  off_t boff;              /* file offset of buf[0] */
+  char *map;               /* read-only mapping of the file, see byte_map */
+  size_t mlen;
+} bfile[MAX_HANDLE] = {{-1},{-1},{-1},{-1}};
+static int ih=0;           /* current handle */
+
+static unsigned char *zbuf=NULL;  /* byte_zip/byte_unzip scratch */
+static size_t zmax=0;
+
+#define MAX_XREF 16
+static unsigned *xref[MAX_XREF];  /* byte_xref reference fields */
+static size_t xmax[MAX_XREF];
 
 int bytesw_write=0;
 int bytesw_read=0;
@@ -63,10 +98,33 @@ int bytesw_read=0;
   void exitt();
 #endif
 
+/*
+   Byte swapping, word-wise; compilers recognize the shifts as bswap
+   and vectorize the loops into byte shuffles.  out may equal in.
+*/
+#define BSWAP32(x) ( (x)>>24 | ((x)>>8 & 0xff00u) \
+                   | ((x)<<8 & 0xff0000u) | (x)<<24 )
+
+static void swap4(uint32_t *out, const uint32_t *in, size_t n)
+{
+  size_t i;
+  for (i=0;i<n;i++) { uint32_t x=in[i]; out[i]=BSWAP32(x); }
+}
+
+static void swap8(uint64_t *out, const uint64_t *in, size_t n)
+{
+  size_t i;
+  for (i=0;i<n;i++)
+  {
+    uint64_t x=in[i];
+    uint32_t lo=(uint32_t)x, hi=(uint32_t)(x>>32);
+    out[i]=(uint64_t)BSWAP32(lo)<<32 | BSWAP32(hi);
+  }
+}
+
 void byte_reverse(float *buf, int *nn,int *ierr)
 {
-  int n;
-  char temp, *ptr;
+  uint32_t *p=(uint32_t *)buf;
 
   if (*nn<0)
   {
@@ -74,19 +132,14 @@ void byte_reverse(float *buf, int *nn,int *ierr)
     *ierr=1;
     return;
   }
-  
-  for (ptr=(char *)buf,n=*nn; n--; ptr+=4)
-  {
-     SWAP(ptr[0],ptr[3])
-     SWAP(ptr[1],ptr[2])
-  }
+
+  swap4(p,p,*nn);
   *ierr=0;
 }
 
 void byte_reverse8(float *buf, int *nn,int *ierr)
 {
-  int n;
-  char temp, *ptr;
+  uint64_t *p=(uint64_t *)buf;
 
   if (*nn<0)
   {
@@ -101,22 +154,109 @@ void byte_reverse8(float *buf, int *nn,int *ierr)
     return;
   }
 
-  for (ptr=(char *)buf,n=*nn,n=n+2; n-=2; ptr+=8)
+  swap8(p,p,*nn/2);
+  *ierr=0;
+}
+
+/*
+   Files are read and written through a buffer of BYTE_BUF bytes per
+   handle (page aligned), with plain read/write on the descriptor.
+   Transfers larger than the buffer bypass it.  Swapping for
+   bytesw_read/bytesw_write is done while copying through the buffer.
+
+   All routines act on the current handle, see byte_select.
+*/
+static struct bfile *cur(void) { return &bfile[ih]; }
+
+void byte_close(int *ierr);
+void byte_seek(long long *off, int *ierr);
+
+/* write n bytes at the current position of the descriptor */
+static int bwrite(int fd, const char *x, size_t n)
+{
+  size_t p=0;
+  while (p<n)
+  {
+    ssize_t k=write(fd,x+p,n-p);
+    if (k<0) { if (errno==EINTR) continue; return 1; }
+    p+=k;
+  }
+  return 0;
+}
+
+/* write the buffer to the file */
+static int bflush(struct bfile *f)
+{
+  if (bwrite(f->fd,f->buf,f->blen)) return 1;
+  f->boff+=f->blen, f->blen=0, f->bpos=0;
+  return 0;
+}
+
+/* read up to n bytes at the current position of the descriptor */
+static ssize_t bread(int fd, char *x, size_t n)
+{
+  size_t p=0;
+  while (p<n)
   {
-     SWAP(ptr[0],ptr[7])
-     SWAP(ptr[1],ptr[6])
-     SWAP(ptr[2],ptr[5])
-     SWAP(ptr[3],ptr[4])
+    ssize_t k=read(fd,x+p,n-p);
+    if (k<0) { if (errno==EINTR) continue; return -1; }
+    if (k==0) break;
+    p+=k;
   }
-  *ierr=0;
+  return p;
 }
 
+static int bopen(struct bfile *f, int mode)
+{
+  if (!f->buf)
+  {
+    void *p;
+    if (posix_memalign(&p,4096,BYTE_BUF)) return 1;
+    f->buf=p;
+  }
+  if (mode==WRITE)
+    f->fd=open(f->name,O_WRONLY|O_CREAT|O_TRUNC,0644);
+  else
+    f->fd=open(f->name,O_RDONLY);
+  if (f->fd<0) return 1;
+#ifdef POSIX_FADV_SEQUENTIAL
+  if (mode==READ) posix_fadvise(f->fd,0,0,POSIX_FADV_SEQUENTIAL);
+#endif
+  f->flag=mode, f->boff=0, f->blen=0, f->bpos=0;
+  return 0;
+}
+
+/* make handle *ih (1..MAX_HANDLE) the current one */
+void byte_select(int *h)
+{
+  if (*h<1 || *h>MAX_HANDLE)
+  {
+    printf("byte_select() :: invalid handle %d\n",*h);
+    return;
+  }
+  ih=*h-1;
+}
+
+/* hand the open file of the current handle over to handle *h */
+void byte_move(int *h, int *ierr)
+{
+  struct bfile t;
+  if (*h<1 || *h>MAX_HANDLE || bfile[*h-1].fd>=0)
+  {
+    printf("byte_move() :: handle %d not available\n",*h);
+    *ierr=1;
+    return;
+  }
+  t=bfile[*h-1], bfile[*h-1]=bfile[ih], bfile[ih]=t;
+  *ierr=0;
+}
 
 void byte_open(char *n,int *ierr)
 {
   int  i,len,istat;
   char slash;
   char dirname[MAX_NAME+1];
+  struct bfile *f=cur();
 
   len = strlen(n);
   
@@ -134,14 +274,16 @@ void byte_open(char *n,int *ierr)
     return;
   }
 
-  strcpy(name,n);
+  if (f->fd>=0) byte_close(ierr);
+
+  strcpy(f->name,n);
   strcpy(dirname,n);
 
   for (i=1;dirname[i]!='\0';i++)
   {
      if (i>0 && dirname[i]=='/')
      {
-       slash = name[i];
+       slash = f->name[i];
        dirname[i] = '\0';
        istat = mkdir(dirname,0755);
      }
@@ -151,31 +293,40 @@ void byte_open(char *n,int *ierr)
 
 void byte_close(int *ierr)
 {
-  if (!fp) return;
+  struct bfile *f=cur();
+  int err=0;
+
+  if (f->fd<0) return;
 
-  if (fclose(fp))
+  if (f->map) munmap(f->map,f->mlen), f->map=NULL;
+  if (f->flag==WRITE) err=bflush(f);
+  if (close(f->fd) || err)
   {
-    printf("byte_close() :: couldn't fclose file!\n");
+    printf("byte_close() :: couldn't close file!\n");
     *ierr=1;
-    return;
   }
+  else
+    *ierr=0;
 
-  fp=NULL;
-  *ierr=0;
+  f->fd=-1, f->flag=0;
 }
 
 void byte_rewind()
 {
-  if (!fp) return;
+  long long zero=0;
+  int ierr;
 
-  rewind(fp);
+  if (cur()->fd<0) return;
+
+  byte_seek(&zero,&ierr);
 }
 
 
 void byte_write(float *buf, int *n,int *ierr)
 {
-  int flags;
-  mode_t mode;
+  struct bfile *f=cur();
+  const char *x=(const char *)buf;
+  size_t len;
 
   if (*n<0)
   {
@@ -184,78 +335,348 @@ void byte_write(float *buf, int *n,int *ierr)
     return;
   }
 
-  if (!fp)
+  if (f->fd<0)
   {
-    if (!(fp=fopen(name,"wb")))
+    if (bopen(f,WRITE))
     {
-      printf("byte_write() :: fopen failure!\n"); 
+      printf("byte_write() :: open failure!\n"); 
       *ierr=1;
       return;
     }
-    flag=WRITE;
   }
 
-  if (flag==WRITE)
-    {
-      if (bytesw_write == 1)
-        byte_reverse (buf,n,ierr);
-      fwrite(buf,sizeof(float),*n,fp);
-    }
-  else
+  if (f->flag!=WRITE)
   {
-      printf("byte_write() :: can't fwrite after freading!\n"); 
+      printf("byte_write() :: can't write after reading!\n"); 
       *ierr=1;
       return;
   }
+
+  *ierr=1;
+  len=(size_t)*n*sizeof(float);
+  if (!bytesw_write && len>=BYTE_BUF)   /* write directly */
+  {
+    if (bflush(f) || bwrite(f->fd,x,len)) goto err;
+    f->boff+=len;
+  }
+  else while (len>0)
+  {
+    size_t k=BYTE_BUF-f->blen;
+    if (k>len) k=len;
+    if (bytesw_write)
+      swap4((uint32_t *)(f->buf+f->blen),(const uint32_t *)x,k/4);
+    else
+      memcpy(f->buf+f->blen,x,k);
+    f->blen+=k, x+=k, len-=k;
+    if (f->blen==BYTE_BUF && bflush(f)) goto err;
+  }
+  *ierr=0;
+  return;
+
+err:
+  printf("ABORT: Error writing %s\n",f->name);
+}
+
+
+/* position the file at byte offset *off (for out-of-order i/o);
+   a file not yet read or written is opened for reading */
+void byte_seek(long long *off, int *ierr)
+{
+  struct bfile *f=cur();
+
+  if (f->fd<0 && bopen(f,READ))
+  {
+    printf("%s\n",f->name);
+    printf("byte_seek() :: open failure!\n"); 
+    *ierr=1;
+    return;
+  }
+
+  if (f->flag==READ && *off>=f->boff && *off<=f->boff+(off_t)f->blen)
+  {
+    f->bpos=*off-f->boff;                /* within the buffer */
+    *ierr=0;
+    return;
+  }
+
+  if ((f->flag==WRITE && bflush(f)) ||
+      lseek(f->fd,(off_t)*off,SEEK_SET)<0)
+  {
+    printf("byte_seek() :: seek failure!\n"); 
+    *ierr=1;
+    return;
+  }
+  f->boff=*off, f->blen=0, f->bpos=0;
   *ierr=0;
 }
 
 
 void byte_read(float *buf, int *n,int *ierr)
 {
-  int flags;
-  mode_t mode;
+  struct bfile *f=cur();
+  char *x=(char *)buf;
+  size_t len;
 
   if (*n<0)
     {printf("byte_read() :: n must be positive\n"); *ierr=1; return;}
 
-  if (!fp)
+  if (f->fd<0)
   {
-     if (!(fp=fopen(name,"rb")))
+     if (bopen(f,READ))
      {
-        printf("%s\n",name);
-        printf("byte_read() :: fopen failure2!\n"); 
+        printf("%s\n",f->name);
+        printf("byte_read() :: open failure2!\n"); 
         *ierr=1;
         return;
      }
-     flag=READ;
   }
 
-  if (flag==READ)
+  if (f->flag!=READ)
   {
-     if (bytesw_read == 1)
-        byte_reverse (buf,n,ierr);
-     fread(buf,sizeof(float),*n,fp);
-     if (ferror(fp))
-     {
-       printf("ABORT: Error reading %s\n",name);
-       *ierr=1;
-       return;
-     }
-     else if (feof(fp))
-     {
-       printf("ABORT: EOF found while reading %s\n",name);
-       *ierr=1;
-       return;
-     }
+     printf("byte_read() :: can't read after writing!\n"); 
+     *ierr=1;
+     return;
+  }
 
+  *ierr=1;
+  len=(size_t)*n*sizeof(float);
+  while (len>0)
+  {
+    size_t k=f->blen-f->bpos;
+    if (k==0)
+    {
+      ssize_t r;
+      f->boff+=f->blen, f->blen=0, f->bpos=0;
+      if (len>=BYTE_BUF)                  /* read directly */
+      {
+        r=bread(f->fd,x,len);
+        if (r<0) goto err;
+        if ((size_t)r<len) goto eof;
+        f->boff+=len;
+        if (bytesw_read) swap4((uint32_t *)x,(uint32_t *)x,len/4);
+        break;
+      }
+      r=bread(f->fd,f->buf,BYTE_BUF);
+      if (r<0) goto err;
+      if (r==0) goto eof;
+      f->blen=r, k=r;
+    }
+    if (k>len) k=len;
+    if (bytesw_read)
+      swap4((uint32_t *)x,(const uint32_t *)(f->buf+f->bpos),k/4);
+    else
+      memcpy(x,f->buf+f->bpos,k);
+    f->bpos+=k, x+=k, len-=k;
   }
-  else
+  *ierr=0;
+  return;
+
+err:
+  printf("ABORT: Error reading %s\n",f->name);
+  return;
+eof:
+  printf("ABORT: EOF found while reading %s\n",f->name);
+}
+
+/*
+   Map the file of the current handle (opened for reading) into memory,
+   for random access with byte_mread without read calls or buffering.
+*/
+void byte_map(int *ierr)
+{
+  struct bfile *f=cur();
+  struct stat st;
+
+  *ierr=1;
+  if (f->fd<0 && bopen(f,READ))
   {
-     printf("byte_read() :: can't fread after fwriting!\n"); 
-     *ierr=1;
-     return;
+    printf("%s\n",f->name);
+    printf("byte_map() :: open failure!\n");
+    return;
+  }
+  if (f->flag!=READ || fstat(f->fd,&st) || st.st_size==0) return;
+  if (f->map) munmap(f->map,f->mlen);
+
+  f->mlen=st.st_size;
+  f->map=mmap(NULL,f->mlen,PROT_READ,MAP_SHARED,f->fd,0);
+  if (f->map==MAP_FAILED)
+  {
+    f->map=NULL;
+    printf("byte_map() :: mmap failure!\n");
+    return;
+  }
+  *ierr=0;
+}
+
+/* copy the *n words at byte offset *off of the mapped file to buf */
+void byte_mread(float *buf, long long *off, int *n, int *ierr)
+{
+  struct bfile *f=cur();
+  const size_t len=(size_t)*n*sizeof(float);
+
+  if (!f->map || *off<0 || *n<0 || (size_t)*off+len>f->mlen)
+  {
+    printf("ABORT: byte_mread() beyond end of %s\n",f->name);
+    *ierr=1;
+    return;
   }
+  memcpy(buf,f->map+*off,len);
+  *ierr=0;
+}
+
+/* length in bytes of the mapped file (0 if none) */
+void byte_mlen(long long *len)
+{
+  struct bfile *f=cur();
+  *len = f->map ? (long long)f->mlen : 0;
+}
+
+/* make room for n bytes in zbuf */
+static int zbuf_reserve(size_t n)
+{
+  if (n>zmax)
+  {
+    unsigned char *p=realloc(zbuf,n);
+    if (!p) return 1;
+    zbuf=p, zmax=n;
+  }
+  return 0;
+}
+
+/*
+   Compressed blocks (see mfo_outz, mfi_getz).  A block is an int,
+   the payload length in bytes (-1: the n input words follow as is),
+   and the payload, padded to whole 4-byte words.  The payload codes
+   the byte-shuffled input (byte b of all values, b=0..wds-1), with
+   each value XOR'ed with its predecessor if *ixor, as a sequence of
+     c <  128 :  c+1 literal bytes follow
+     c >= 128 :  c-127 zero bytes
+   The n input words hold values of wds = 4 or 8 bytes.  On return,
+   *nb is the length of the block in 4-byte words, at most 1+n.
+*/
+void byte_zip(float *z, int *nb, float *x, int *n, int *wds, int *ixor)
+{
+  const unsigned char *in = (const unsigned char *)x;
+  unsigned char *out = (unsigned char *)(z+1);
+  const size_t s=*wds, len=(size_t)*n*4, nv=len/s;
+  size_t b,i,p,q;
+  int nz;
+
+  if (zbuf_reserve(len)) goto raw;
+  for (p=0,b=0;b<s;b++)                   /* shuffle (and XOR) */
+    for (i=0;i<nv;i++,p++)
+      zbuf[p] = in[i*s+b] ^ (*ixor && i ? in[(i-1)*s+b] : 0);
+
+  for (p=0,q=0;p<len;)
+  {
+    size_t r=0;
+    while (p+r<len && r<128 && zbuf[p+r]==0) r++;
+    if (r>1 || (r==1 && p+1==len))        /* zero run */
+    {
+      if (q+1>len) goto raw;
+      out[q++]=127+r, p+=r;
+    }
+    else                                  /* literal run */
+    {
+      size_t k=0, q0=q++;
+      while (p<len && k<128)
+      {
+        if (zbuf[p]==0 && p+1<len && zbuf[p+1]==0) break;
+        if (q+1>len) goto raw;
+        out[q++]=zbuf[p++], k++;
+      }
+      out[q0]=k-1;
+    }
+  }
+  if ((q+3)/4>=(size_t)*n) goto raw;
+
+  nz=q, memcpy(z,&nz,sizeof(int));
+  *nb=1+(q+3)/4;
+  return;
+
+raw:
+  nz=-1, memcpy(z,&nz,sizeof(int));
+  memcpy(z+1,x,len);
+  *nb=1+*n;
+}
+
+/* decode the block z into the n words x; *iswap: z[0] is byte swapped */
+void byte_unzip(float *x, int *n, float *z, int *wds, int *ixor,
+                int *iswap, int *ierr)
+{
+  const unsigned char *in = (const unsigned char *)(z+1);
+  unsigned char *out = (unsigned char *)x;
+  const size_t s=*wds, len=(size_t)*n*4, nv=len/s;
+  size_t b,i,p,q;
+  int nz;
+  char temp, *ptr=(char *)&nz;
+
+  *ierr=1;
+  memcpy(&nz,z,sizeof(int));
+  if (*iswap) { SWAP(ptr[0],ptr[3]) SWAP(ptr[1],ptr[2]) }
+  if (nz<0) { memcpy(x,z+1,len); *ierr=0; return; }
+  if (zbuf_reserve(len)) return;
+
+  for (p=0,q=0;q<(size_t)nz;)
+  {
+    size_t c=in[q++];
+    if (c>=128)
+    {
+      if (p+c-127>len) return;
+      memset(zbuf+p,0,c-127), p+=c-127;
+    }
+    else
+    {
+      if (p+c+1>len || q+c+1>(size_t)nz) return;
+      memcpy(zbuf+p,in+q,c+1), p+=c+1, q+=c+1;
+    }
+  }
+  if (p!=len) return;
+
+  for (p=0,b=0;b<s;b++)                   /* unshuffle (and XOR) */
+    for (i=0;i<nv;i++,p++)
+      out[i*s+b] = zbuf[p] ^ (*ixor && i ? out[(i-1)*s+b] : 0);
+  *ierr=0;
+}
+
+/*
+   Differential checkpoints (see restart_save).  The n words x at word
+   offset *ioff of reference field *islot (1..MAX_XREF) are
+     *idir =  0 :  stored as the new reference
+     *idir =  1 :  replaced by x XOR reference, and x becomes the reference
+     *idir = -1 :  XOR'ed with the reference, and the result becomes
+                   the reference (undoes *idir = 1)
+   *ierr is set if the slot is out of range, memory runs out, or
+   (*idir = -1) there is no reference to apply.
+*/
+void byte_xref(float *x, int *n, int *islot, int *ioff, int *idir, int *ierr)
+{
+  unsigned *u = (unsigned *)x, *r, t;
+  const size_t k=*islot-1, len=(size_t)*ioff+*n;
+  size_t i;
+
+  *ierr=1;
+  if (*islot<1 || *islot>MAX_XREF || *ioff<0) return;
+  if (len>xmax[k])
+  {
+    if (*idir<0)
+    {
+      printf("byte_xref: no reference, restart from a base checkpoint\n");
+      return;
+    }
+    r=realloc(xref[k],len*sizeof(unsigned));
+    if (!r) { printf("byte_xref: out of memory\n"); return; }
+    memset(r+xmax[k],0,(len-xmax[k])*sizeof(unsigned));
+    xref[k]=r, xmax[k]=len;
+  }
+  r=xref[k]+*ioff;
+
+  if (*idir==0)
+    memcpy(r,u,(size_t)*n*sizeof(unsigned));
+  else if (*idir>0)
+    for (i=0;i<(size_t)*n;i++) t=u[i], u[i]^=r[i], r[i]=t;
+  else
+    for (i=0;i<(size_t)*n;i++) u[i]^=r[i], r[i]=u[i];
   *ierr=0;
 }
 
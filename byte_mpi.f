@@ -20,13 +20,16 @@ C--------------------------------------------------------------------------
 
       if(nid.eq.pid0 .or. nid.eq.pid0r) then
 c        write(*,*) nid, 'call MPI_file_open',fname
+        call byte_info_mpi(info)
         call MPI_file_open(nekcomm_io,fname,
      &                     MPI_MODE_RDWR+MPI_MODE_CREATE,
-     &                     MPI_INFO_NULL,mpi_fh,ierr)
+     &                     info,mpi_fh,ierr)
+        if(info.ne.MPI_INFO_NULL) call MPI_info_free(info,ierr2)
         if(ierr.ne.0) then
           write(6,*) 'ABORT: Error in byte_open_mpi ', ierr
           return
         endif
+        ioff_mpi = 0
       endif
 #else
       write(6,*) 'byte_open_mpi: No MPI-IO support!'
@@ -52,12 +55,13 @@ C--------------------------------------------------------------------------
         if(iorank.ge.0 .and. nid.ne.iorank) iout = 0
 c        write(*,*) 'byte_read_mpi', nid, iout/4
 #ifdef MPIIO_NOCOL
-        call MPI_file_read(mpi_fh,buf,iout,MPI_BYTE,
-     &                     MPI_STATUS_IGNORE,ierr)
+        call MPI_file_read_at(mpi_fh,ioff_mpi,buf,iout,MPI_BYTE,
+     &                        MPI_STATUS_IGNORE,ierr)
 #else
-        call MPI_file_read_all(mpi_fh,buf,iout,MPI_BYTE,
-     &                         MPI_STATUS_IGNORE,ierr)
+        call MPI_file_read_at_all(mpi_fh,ioff_mpi,buf,iout,MPI_BYTE,
+     &                            MPI_STATUS_IGNORE,ierr)
 #endif
+        ioff_mpi = ioff_mpi + iout
         if(ierr.ne.0) then
           write(6,*) 'ABORT: Error in byte_read_mpi ', ierr
           return
@@ -89,12 +93,13 @@ C--------------------------------------------------------------------------
         if(iorank.ge.0 .and. nid.ne.iorank) iout = 0
 c        write(*,*) 'byte_write', nid, iout/4
 #ifdef MPIIO_NOCOL
-        call MPI_file_write(mpi_fh,buf,iout,MPI_BYTE,
-     &                      MPI_STATUS_IGNORE,ierr)
+        call MPI_file_write_at(mpi_fh,ioff_mpi,buf,iout,MPI_BYTE,
+     &                         MPI_STATUS_IGNORE,ierr)
 #else
-        call MPI_file_write_all(mpi_fh,buf,iout,MPI_BYTE,
-     &                          MPI_STATUS_IGNORE,ierr)
+        call MPI_file_write_at_all(mpi_fh,ioff_mpi,buf,iout,MPI_BYTE,
+     &                             MPI_STATUS_IGNORE,ierr)
 #endif
+        ioff_mpi = ioff_mpi + iout
         if(ierr.ne.0) then
           write(6,*) 'ABORT: Error in byte_write_mpi ', ierr
           return
@@ -134,6 +139,13 @@ C--------------------------------------------------------------------------
 C--------------------------------------------------------------------------
       subroutine byte_set_view(ioff_in,mpi_fh)
 
+c     Position this rank at byte ioff_in of the file.  The file keeps
+c     its default (byte) view; reads and writes pass the offset
+c     explicitly (MPI_file_*_at_all), which avoids a collective
+c     MPI_file_set_view for every field.  Each rank's elements are
+c     contiguous in the file (see mfo_write_hdr), so one offset per
+c     field describes the rank's part of the file.
+
       include 'SIZE'
       include 'RESTART'
 
@@ -147,12 +159,43 @@ C--------------------------------------------------------------------------
            call exitt
          endif
 c         write(*,*) 'dataoffset', nid, ioff_in
-         call MPI_file_set_view(mpi_fh,ioff_in,MPI_BYTE,MPI_BYTE,
-     &                          'native',MPI_INFO_NULL,ierr)
-         if(ierr.ne.0) then
-           write(6,*) 'ABORT: Error in byte_set_view ', ierr
-           call exitt
-         endif
+         ioff_mpi = ioff_in
+      endif
+#endif
+
+      return
+      end
+C--------------------------------------------------------------------------
+      subroutine byte_info_mpi(info)
+
+c     Collective buffering hints for MPI_file_open:
+c
+c        p141 > 0  :  cb_nodes       = p141  (# of aggregators)
+c        p142 > 0  :  cb_buffer_size = p142  (MB per aggregator)
+c
+c     Either one also forces two-phase collective writes (ROMIO).
+
+      include 'SIZE'
+      include 'INPUT'
+
+#ifdef MPIIO
+      include 'mpif.h'
+      character*20 str
+      integer*8    ibuf
+
+      info = MPI_INFO_NULL
+      if (param(141).le.0 .and. param(142).le.0) return
+
+      call MPI_info_create(info,ierr)
+      call MPI_info_set(info,'romio_cb_write','enable',ierr)
+      if (param(141).gt.0) then
+         write(str,'(i20)') int(param(141))
+         call MPI_info_set(info,'cb_nodes',str,ierr) ! blanks stripped
+      endif
+      if (param(142).gt.0) then
+         ibuf = param(142)*1024*1024
+         write(str,'(i20)') ibuf
+         call MPI_info_set(info,'cb_buffer_size',str,ierr)
       endif
 #endif
 
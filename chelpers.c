@@ -1,9 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "jl/name.h"
 
 #define print_stack FORTRAN_UNPREFIXED(print_stack, PRINT_STACK)
 #define sizeOfLongInt FORTRAN_UNPREFIXED(sizeoflongint, SIZEOFLONGINT)
+#define buddy_put FORTRAN_UNPREFIXED(buddy_put, BUDDY_PUT)
+#define buddy_get FORTRAN_UNPREFIXED(buddy_get, BUDDY_GET)
+#define buddy_len FORTRAN_UNPREFIXED(buddy_len, BUDDY_LEN)
+#define buddy_free FORTRAN_UNPREFIXED(buddy_free, BUDDY_FREE)
 
 #if defined __GLIBC__
 
@@ -28,3 +33,54 @@ int sizeOfLongInt()
 {
   return sizeof(long int);
 }
+
+/*
+   In-memory checkpoint store (see buddy_save): slot 1 holds this
+   rank's state, slot 2 the copy of its partner's.  Offsets and
+   lengths are in 4-byte words.
+*/
+#define BUDDY_SLOTS 2
+static float *bbuf[BUDDY_SLOTS];
+static size_t bmax[BUDDY_SLOTS], blen[BUDDY_SLOTS];
+
+void buddy_put(int *islot, float *x, int *ioff, int *n, int *ierr)
+{
+  const int k = *islot-1;
+  const size_t len = (size_t)*ioff + *n;
+  *ierr = 1;
+  if(k<0 || k>=BUDDY_SLOTS || *ioff<0 || *n<0) return;
+  if(len>bmax[k]) {
+    size_t max = bmax[k]+bmax[k]/2+1;
+    float *p;
+    if(max<len) max=len;
+    p = realloc(bbuf[k],max*sizeof(float));
+    if(!p) { printf("buddy_put: out of memory\n"); return; }
+    bbuf[k]=p, bmax[k]=max;
+  }
+  memcpy(bbuf[k]+*ioff,x,(size_t)*n*sizeof(float));
+  if(len>blen[k]) blen[k]=len;
+  *ierr = 0;
+}
+
+void buddy_get(int *islot, float *x, int *ioff, int *n, int *ierr)
+{
+  const int k = *islot-1;
+  *ierr = 1;
+  if(k<0 || k>=BUDDY_SLOTS || *ioff<0 || *n<0) return;
+  if((size_t)*ioff + *n > blen[k]) return;
+  memcpy(x,bbuf[k]+*ioff,(size_t)*n*sizeof(float));
+  *ierr = 0;
+}
+
+void buddy_len(int *islot, int *n)
+{
+  const int k = *islot-1;
+  *n = (k<0 || k>=BUDDY_SLOTS) ? 0 : (int)blen[k];
+}
+
+void buddy_free(int *islot)
+{
+  const int k = *islot-1;
+  if(k<0 || k>=BUDDY_SLOTS) return;
+  free(bbuf[k]), bbuf[k]=NULL, bmax[k]=blen[k]=0;
+}
@@ -372,6 +372,50 @@ c
 c
       return
       end
+c-----------------------------------------------------------------------
+      logical function msgtest(imsg)
+c
+c     Non-blocking check for completion of imsg
+c
+      include 'mpif.h'
+      integer status(mpi_status_size)
+      logical ifdone
+c
+      call mpi_test (imsg,ifdone,status,ierr)
+      msgtest = ifdone
+c
+      return
+      end
+c-----------------------------------------------------------------------
+      function isendc(msgtag,x,len,jnid,icomm)
+c
+c     As isend, but on communicator icomm.  Note: len in bytes
+c
+      integer x(1)
+C
+      include 'mpif.h'
+C
+      call mpi_isend (x,len,mpi_byte,jnid,msgtag
+     $       ,icomm,imsg,ierr)
+      isendc = imsg
+c
+      return
+      end
+c-----------------------------------------------------------------------
+      function irecvc(msgtag,x,len,icomm)
+c
+c     As irecv, but on communicator icomm.  Note: len in bytes
+c
+      integer x(1)
+C
+      include 'mpif.h'
+C
+      call mpi_irecv (x,len,mpi_byte,mpi_any_source,msgtag
+     $       ,icomm,imsg,ierr)
+      irecvc = imsg
+c
+      return
+      end
 c-----------------------------------------------------------------------
       subroutine nekgsync()
 
@@ -497,6 +541,7 @@ c
 c     Communicate unhappiness to the other session
       if (ifneknek.and.icall.eq.0) call happy_check(0)
 
+      call mfo_async_wait   ! flush pending asynchronous output
       call nekgsync()
 
 
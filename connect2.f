@@ -148,7 +148,7 @@ c pack into long int array and bcast as that
         call chk_nel  ! make certain sufficient array sizes
 
         if (.not.ifgtp) call mapelpr  ! read .map file, est. gllnid, etc.
-        if (ifre2) then
+   10   if (ifre2) then
           call bin_rd1(ifbswap) ! rank0 will read mesh data + distribute
         else
           maxrd = 32               ! max # procs to read at once
@@ -175,6 +175,20 @@ c pack into long int array and bcast as that
              iread = iread + 1
           enddo
         endif
+
+        if (ifpart) then           ! partition, then read the mesh again
+          call part_mesh
+          call blank(ccurve,12*lelt)  ! readers set curved sides only
+          call rzero(curve ,72*lelt)
+          if (ifre2) then
+             call open_bin_file(ifbswap)
+          elseif (nid.eq.0) then
+             rewind(9)
+             call cscan(string,'MESH DATA',9)
+             read(9,*) string
+          endif
+          goto 10
+        endif
       endif
 
 C     Read Restart options / Initial Conditions / Drive Force
@@ -2209,20 +2223,26 @@ c
       lcbc=18*lelt*(ldimt1 + 1)
       call blank(cbc,lcbc)
 
-      if (nio.eq.0) write(6,*)    '  reading mesh '
-      call bin_rd1_mesh  (ifbswap)   ! version 1 of binary reader
-      if (nio.eq.0) write(6,*) '  reading curved sides '
-      call bin_rd1_curve (ifbswap)
-
-      do ifield = ibc,nfldt
-         if (nio.eq.0) write(6,*) '  reading bc for ifld',ifield
-         call bin_rd1_bc (cbc(1,1,ifield),bc(1,1,1,ifield),ifbswap)
-      enddo
+      if (param(146).eq.1) then
+         call bin_rd1_map(ibc,nfldt,ifbswap) ! all ranks, via mmap
+      elseif (param(146).eq.2) then
+         call bin_rd1_par(ibc,nfldt,ifbswap) ! all ranks, crystal router
+      else
+         if (nio.eq.0) write(6,*)    '  reading mesh '
+         call bin_rd1_mesh  (ifbswap)   ! version 1 of binary reader
+         if (nio.eq.0) write(6,*) '  reading curved sides '
+         call bin_rd1_curve (ifbswap)
+
+         do ifield = ibc,nfldt
+            if (nio.eq.0) write(6,*) '  reading bc for ifld',ifield
+            call bin_rd1_bc (cbc(1,1,ifield),bc(1,1,1,ifield),ifbswap)
+         enddo
+      endif
 
       call nekgsync
       ierr=0
+      if(nid.eq.0 .or. param(146).ge.1) call byte_close(ierr)
       if(nid.eq.0) then
-        call byte_close(ierr)
         write(6,*) 'done :: read .re2 file'
         write(6,*) ' '
       endif
@@ -2597,6 +2617,357 @@ c           write(6,*) nid,' recvbc2',k,buf(1)
 
       call err_chk(ierr,'Error reading boundary data for re2. Abort.$')
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine bin_rd1_map(ibc,nfldt,ifbswap) ! p146 = 1 .re2 reader
+
+c     Every rank maps the .re2 file (byte_map) and copies the records
+c     of its own elements: mesh records are at fixed offsets, curve
+c     and bc records are found by binary search on the element number
+c     (see bin_rd1_sect).  No data passes through rank 0.
+
+      include 'SIZE'
+      include 'TOTAL'
+      logical ifbswap
+
+      integer e,eg,buf(55)
+      integer*8 ioff
+
+      integer fnami (33)
+      character*132 fname
+      equivalence (fname,fnami)
+
+      ierr = 0
+      if (nid.ne.0) then                     ! rank 0: see open_bin_file
+         call izero(fnami,33)
+         m = indx2(re2fle,132,' ',1)-1
+         call chcopy(fname,re2fle,m)
+         call byte_open(fname,ierr)
+      endif
+      if (ierr.eq.0) call byte_map(ierr)
+      call err_chk(ierr,'Error mapping .re2 file. Abort. $')
+
+      if (nio.eq.0) write(6,*)    '  reading mesh '
+      nwds = (1 + ndim*(2**ndim))*(wdsizi/4) ! group + 2x4 for 2d, 3x8 for 3d
+      ioff = 84                              ! header + test pattern
+      do e=1,nelt
+         eg = lglel(e)
+         if (ierr.eq.0)
+     $      call byte_mread(buf,ioff+4*nwds*(eg-1),nwds,ierr)
+         if (ierr.eq.0) call buf_to_xyz(buf,e,ifbswap,ierr)
+      enddo
+      ioff = ioff + 4*nwds*nelgt
+      call err_chk(ierr,'Error reading .re2 mesh. Abort. $')
+
+      if (nio.eq.0) write(6,*) '  reading curved sides '
+      call bin_rd1_sect(ioff,cbc,bc,.true.,ifbswap)
+
+      do ifield = ibc,nfldt
+         if (nio.eq.0) write(6,*) '  reading bc for ifld',ifield
+         call bin_rd1_sect(ioff,cbc(1,1,ifield),bc(1,1,1,ifield)
+     $                    ,.false.,ifbswap)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine bin_rd1_sect(ioff,cbl,bl,ifcrv,ifbswap) ! curve/bc data
+
+c     Read the curve (ifcrv) or bc section at byte ioff of the mapped
+c     .re2 and advance ioff past it.  The records are normally sorted
+c     by element; if the records found by binary search do not add up
+c     to the section count, every rank scans the whole section.
+
+      include 'SIZE'
+      include 'TOTAL'
+      logical ifcrv,ifbswap
+
+      character*3 cbl(6,lelt)
+      real         bl(5,6,lelt)
+
+      integer e,eg
+      integer*8 ioff,ioffr
+      real rn
+
+      nw   = wdsizi/4
+      nwds = (2 + 1 + 5)*nw                  ! eg+iside+5 reals+char
+
+      if (.not.ifcrv) then                   ! fill up cbc w/ default
+         do e=1,nelt
+         do k=1,6
+            cbl(k,e) = 'E  '
+         enddo
+         enddo
+      endif
+
+      ierr = 0
+      if (nw.eq.2) then
+         call byte_mread(rn,ioff,2,ierr)
+         if (ifbswap) call byte_reverse8(rn,2,ierr)
+         n = rn
+      else
+         call byte_mread(n,ioff,1,ierr)
+         if (ifbswap) call byte_reverse(n,1,ierr)
+      endif
+      call err_chk(ierr,'Error reading .re2 section. Abort. $')
+      ioffr = ioff + 4*nw                    ! record 1
+      ioff  = ioffr + 4*nwds*n               ! next section
+
+      nfound = 0
+      do e=1,nelt
+         eg  = lglel(e)
+         klo = 1                             ! first record >= eg
+         khi = n+1
+         do while (klo.lt.khi)
+            k = (klo+khi)/2
+            if (ire2_eg(ioffr,k,nwds,ifbswap).lt.eg) then
+               klo = k+1
+            else
+               khi = k
+            endif
+         enddo
+         do k=klo,n
+            if (ire2_eg(ioffr,k,nwds,ifbswap).ne.eg) goto 10
+            call bin_rd1_rec(ioffr,k,nwds,cbl,bl,ifcrv,ifbswap,ierr)
+            nfound = nfound + 1
+         enddo
+   10    continue
+      enddo
+
+      if (iglsum(nfound,1).ne.n) then        ! not sorted by element
+         if (nio.eq.0) write(6,*) '  unsorted section, scanning'
+         do k=1,n
+            eg = ire2_eg(ioffr,k,nwds,ifbswap)
+            if (gllnid(eg).eq.nid)
+     $         call bin_rd1_rec(ioffr,k,nwds,cbl,bl,ifcrv,ifbswap,ierr)
+         enddo
+      endif
+      call err_chk(ierr,'Error reading .re2 curve/bc data. Abort. $')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine bin_rd1_rec(ioffr,k,nwds,cbl,bl,ifcrv,ifbswap,ierr)
+
+c     Copy curve/bc record k of the section starting at ioffr
+
+      include 'SIZE'
+      include 'TOTAL'
+      logical ifcrv,ifbswap
+
+      character*3 cbl(6,lelt)
+      real         bl(5,6,lelt)
+
+      integer buf(55)
+      integer*8 ioffr
+
+      if (ierr.ne.0) return
+      call byte_mread(buf,ioffr+4*nwds*(k-1),nwds,ierr)
+      if (ifbswap .and. wdsizi.eq.8) call byte_reverse8(buf,nwds-2,ierr)
+      if (ifbswap .and. wdsizi.eq.4) call byte_reverse (buf,nwds-1,ierr)
+      if (ierr.ne.0) return
+
+      if (ifcrv) then
+         call buf_to_curve(buf)
+      else
+         call buf_to_bc(cbl,bl,buf)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      integer function ire2_eg(ioffr,k,nwds,ifbswap) ! element of record
+
+      include 'SIZE'
+      include 'PARALLEL'
+      logical ifbswap
+
+      integer*8 ioffr
+      integer buf(2)
+
+      nw = wdsizi/4
+      call byte_mread(buf,ioffr+4*nwds*(k-1),nw,ierr)
+      if (ifbswap .and. nw.eq.2) call byte_reverse8(buf,2,ierr)
+      if (ifbswap .and. nw.eq.1) call byte_reverse (buf,1,ierr)
+      if (nw.eq.2) then
+         call copyi4(ire2_eg,buf,1)
+      else
+         ire2_eg = buf(1)
+      endif
+      if (ierr.ne.0) ire2_eg = 0
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine bin_rd1_par(ibc,nfldt,ifbswap) ! p146 = 2 .re2 reader
+
+c     Every rank reads an equal, contiguous slab of the records of each
+c     section and sends each record to the owner of its element,
+c     gllnid(eg), with one crystal_ituple_transfer per section.
+
+      include 'SIZE'
+      include 'TOTAL'
+      logical ifbswap
+
+      parameter (lvi=7*lx1*ly1*lz1*lelt)
+      common /scrns/ vi(lvi)
+      integer vi
+
+      integer*8 ioff
+
+      integer fnami (33)
+      character*132 fname
+      equivalence (fname,fnami)
+
+      ierr = 0
+      if (nid.ne.0) then                     ! rank 0: see open_bin_file
+         call izero(fnami,33)
+         m = indx2(re2fle,132,' ',1)-1
+         call chcopy(fname,re2fle,m)
+         call byte_open(fname,ierr)
+      endif
+      call err_chk(ierr,'Error opening .re2 file. Abort. $')
+
+      if (nio.eq.0) write(6,*)    '  reading mesh '
+      nwds = (1 + ndim*(2**ndim))*(wdsizi/4) ! group + 2x4 for 2d, 3x8 for 3d
+      ioff = 84                              ! header + test pattern
+      call bin_rd1_pmesh(ioff,vi,nwds+2,lvi/(nwds+2),ifbswap)
+      ioff = ioff + 4*nwds*nelgt
+
+      if (nio.eq.0) write(6,*) '  reading curved sides '
+      nwds = (2 + 1 + 5)*(wdsizi/4)          ! eg+iside+5 reals+char
+      call bin_rd1_psect(ioff,cbc,bc,.true.,ifbswap
+     $                  ,vi,nwds+1,lvi/(nwds+1))
+
+      do ifield = ibc,nfldt
+         if (nio.eq.0) write(6,*) '  reading bc for ifld',ifield
+         call bin_rd1_psect(ioff,cbc(1,1,ifield),bc(1,1,1,ifield)
+     $                     ,.false.,ifbswap,vi,nwds+1,lvi/(nwds+1))
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine bin_rd1_pmesh(ioff,vi,m,mmax,ifbswap)
+
+c     Slab read of the mesh records at byte ioff; vi(1,:) is the
+c     destination rank, vi(2,:) the element, vi(3:m,:) the record.
+
+      include 'SIZE'
+      include 'TOTAL'
+      logical ifbswap
+
+      integer vi(m,mmax)
+      integer e,eg
+      integer*8 ioff,i0,i1
+
+      nwds = m-2
+      i0   = (nid*int(nelgt,8))/np           ! elements i0+1 ... i1
+      i1   = ((nid+1)*int(nelgt,8))/np
+      n    = i1-i0
+
+      ierr = 0
+      if (n.gt.mmax) ierr = 1
+      if (ierr.eq.0 .and. n.gt.0) call byte_seek(ioff+4*nwds*i0,ierr)
+      do k=1,n
+         eg = i0+k
+         vi(1,k) = gllnid(eg)
+         vi(2,k) = eg
+         if (ierr.eq.0) call byte_read(vi(3,k),nwds,ierr)
+      enddo
+      call err_chk(ierr,'Error reading .re2 mesh. Abort. $')
+
+      call crystal_ituple_transfer(cr_h,vi,m,n,mmax,1)
+      if (n.ne.nelt) ierr = 1
+      call err_chk(ierr,'Error routing .re2 mesh. Abort. $')
+
+      do k=1,n
+         e = gllel(vi(2,k))
+         if (ierr.eq.0) call buf_to_xyz(vi(3,k),e,ifbswap,ierr)
+      enddo
+      call err_chk(ierr,'Error reading .re2 mesh. Abort. $')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine bin_rd1_psect(ioff,cbl,bl,ifcrv,ifbswap,vi,m,mmax)
+
+c     Slab read of the curve (ifcrv) or bc section at byte ioff, which
+c     is advanced past the section; vi(1,:) is the destination rank,
+c     vi(2:m,:) the (swapped) record.
+
+      include 'SIZE'
+      include 'TOTAL'
+      logical ifcrv,ifbswap
+
+      character*3 cbl(6,lelt)
+      real         bl(5,6,lelt)
+
+      integer vi(m,mmax)
+      integer e,eg
+      integer*8 ioff,i0,i1
+      real rn
+
+      nw   = wdsizi/4
+      nwds = m-1
+
+      if (.not.ifcrv) then                   ! fill up cbc w/ default
+         do e=1,nelt
+         do k=1,6
+            cbl(k,e) = 'E  '
+         enddo
+         enddo
+      endif
+
+      ierr = 0
+      call byte_seek(ioff,ierr)
+      if (nw.eq.2) then
+         if (ierr.eq.0) call byte_read(rn,2,ierr)
+         if (ifbswap) call byte_reverse8(rn,2,ierr)
+         nrec = rn
+      else
+         if (ierr.eq.0) call byte_read(nrec,1,ierr)
+         if (ifbswap) call byte_reverse(nrec,1,ierr)
+      endif
+      call err_chk(ierr,'Error reading .re2 section. Abort. $')
+
+      i0   = (nid*int(nrec,8))/np            ! records i0+1 ... i1
+      i1   = ((nid+1)*int(nrec,8))/np
+      n    = i1-i0
+
+      if (n.gt.mmax) ierr = 1
+      if (ierr.eq.0 .and. n.gt.0)
+     $   call byte_seek(ioff+4*(nw+nwds*i0),ierr)
+      ioff = ioff + 4*(nw+nwds*int(nrec,8))  ! next section
+      do k=1,n
+         if (ierr.eq.0) call byte_read(vi(2,k),nwds,ierr)
+         if (ifbswap .and. nw.eq.2)
+     $      call byte_reverse8(vi(2,k),nwds-2,ierr)
+         if (ifbswap .and. nw.eq.1)
+     $      call byte_reverse (vi(2,k),nwds-1,ierr) ! last is char
+         if (nw.eq.2) then
+            call copyi4(eg,vi(2,k),1)
+         else
+            eg = vi(2,k)
+         endif
+         if (eg.lt.1 .or. eg.gt.nelgt) ierr = 1
+         if (ierr.eq.0) vi(1,k) = gllnid(eg)
+      enddo
+      call err_chk(ierr,'Error reading .re2 curve/bc data. Abort. $')
+
+      call crystal_ituple_transfer(cr_h,vi,m,n,mmax,1)
+      if (n.gt.mmax) ierr = 1
+      call err_chk(ierr,'Error routing .re2 curve/bc data. Abort. $')
+
+      do k=1,n
+         if (ifcrv) then
+            call buf_to_curve(vi(2,k))
+         else
+            call buf_to_bc(cbl,bl,vi(2,k))
+         endif
+      enddo
+
       return
       end
 c-----------------------------------------------------------------------
@@ -66,6 +66,8 @@ c      COMMON /SCRCG/ DUMM10(LX1,LY1,LZ1,LELT,1)
       call genwz           ! Compute GLL points, weights, etc.
 
       call io_init         ! Initalize io unit
+      call lpt_init        ! Lagrangian particles, see particle.f
+      call hpts_init       ! history points, see postpro.f
 
       if (ifcvode.and.nsteps.gt.0) 
      $   call cv_setsize(0,nfield) !Set size for CVODE solver
@@ -200,7 +202,12 @@ c-----------------------------------------------------------------------
          call nek__multi_advance(kstep,msteps)
          call userchk
          call prepost (.false.,'his')
+         call mfo_async_poll
+         call part_rebal
+         call buddy_save
          call in_situ_check()
+         if (ifneknek) call bcopy        ! wait for the exchange posted
+         if (ifneknek) call chk_outflow  ! after the step, see below
          if (lastep .eq. 1) goto 1001
       enddo
  1001 lastep=1
@@ -263,7 +270,10 @@ c-----------------------------------------------------------------------
          call setprop
          do igeom=1,ngeom
 
-            if (igeom.gt.2) call userchk_set_xfer
+            if (igeom.gt.2) then   ! corrector: fresh interface values
+               call userchk_set_xfer
+               call get_values_wait
+            endif
 
             if (ifgeom) then
                call gengeom (igeom)
@@ -304,6 +314,8 @@ c-----------------------------------------------------------------------
       include 'PARALLEL'
       include 'OPCTR'
 
+      call mfo_async_wait
+      call hpts_close
       if(instep.ne.0)  call runstat
       if(xxth(1).gt.0) call crs_stats(xxth(1))
 
@@ -317,13 +329,19 @@ c-----------------------------------------------------------------------
       include 'SIZE'
       include 'TOTAL'
 
+c     The interface exchange of neknek is posted here and completed by
+c     bcopy once userchk and the output of this step are done, which
+c     do not depend on it (the next step is the first to use ubc)
+
       do i=1,msteps
          istep = istep+i
          call nek_advance
 
          if (ifneknek) call userchk_set_xfer
-         if (ifneknek) call bcopy
-         if (ifneknek) call chk_outflow
+         if (ifneknek.and.i.lt.msteps) then
+            call bcopy
+            call chk_outflow
+         endif
 
       enddo
 
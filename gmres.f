@@ -27,15 +27,16 @@ c     intype = -1  (implicit)
       integer j,m
 c
       logical iflag
-      save    iflag
+      save    iflag,irebal
       data    iflag /.false./
       real    norm_fac
       save    norm_fac
 c
       real*8 etime1,dnekclock
 c
-      if(.not.iflag) then
+      if(.not.iflag .or. irebal.ne.nrebal) then   ! new distribution
          iflag=.true.
+         irebal=nrebal
          call uzawa_gmres_split0(ml,mu,bm2,bm2inv,nx2*ny2*nz2*nelv)
          norm_fac = 1./sqrt(volvm2)
       endif
@@ -323,7 +324,7 @@ c     GMRES iteration.
       integer outer
 
       logical iflag,if_hyb
-      save    iflag,if_hyb
+      save    iflag,if_hyb,irebal
 c     data    iflag,if_hyb  /.false. , .true. /
       data    iflag,if_hyb  /.false. , .false. /
       real    norm_fac
@@ -340,8 +341,9 @@ c     data    iflag,if_hyb  /.false. , .true. /
       iter  = 0
       m     = lgmres
 
-      if(.not.iflag) then
+      if(.not.iflag .or. irebal.ne.nrebal) then   ! new distribution
          iflag=.true.
+         irebal=nrebal
          call uzawa_gmres_split(ml,mu,bm1,binvm1,nx1*ny1*nz1*nelv)
          norm_fac = 1./sqrt(volvm1)
       endif
@@ -35,6 +35,23 @@ c param(44):   fast3d.f, navier6.f
 c     0 - base top-level additive Schwarz on restrictions of E
 c     1 - base top-level additive Schwarz on restrictions of A
 c
+c param(136):  hsmg.f
+c     0 - default level ladder (2 or 3 levels)
+c     n - use n levels, halving the order per level: lx1-1, .., 3, 2, 1
+c
+c param(137):  hsmg.f (h1mg only)
+c     0 - additive Schwarz smoothing
+c     1 - Chebyshev-accelerated Schwarz smoothing
+c     2 - Chebyshev-accelerated Jacobi smoothing
+c
+c param(138):  hsmg.f
+c     degree of the Chebyshev smoother (default 2 for p137=1, 6 for
+c     p137=2)
+c
+c param(139):  hsmg.f
+c     0 - additive Schwarz, overlap solutions summed back to neighbors
+c     1 - restricted additive Schwarz, no outbound overlap exchange
+c
 c----------------------------------------------------------------------
       subroutine hsmg_setup()
       include 'SIZE'
@@ -166,9 +183,54 @@ c++   write(6,*) mg_fld,' mgfld in hsmg_setup_dssum'
          ny=ny+2
          nz=nz+2
          if(.not.if3d) nz=1
-         call setupds(mg_gsh_schwarz_handle(l,mg_fld),nx,ny,nz
-     $                ,nelv,nelgv,vertex,glo_num)
+         call setupds_face(mg_gsh_schwarz_handle(l,mg_fld),nx,ny,nz
+     $                    ,nelv,nelgv,vertex,glo_num)
+      enddo
+      end
+c----------------------------------------------------------------------
+      subroutine setupds_face(gs_h,nx,ny,nz,nel,melg,vertex,glo_num)
+c
+c     As setupds, but only face-interior nodes are exchanged.  Edges and
+c     vertices of the extended Schwarz arrays never carry data (see
+c     hsmg_extrude), so they get id 0 and each element talks to its
+c     face neighbors only.
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      integer   gs_h,vertex(1),e
+      integer*8 ngv,glo_num(nx,ny,nz,nel)
+
+      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
+
+      t0 = dnekclock()
+
+      call set_vert(glo_num,ngv,nx,nel,vertex,.false.)
+
+      do e=1,nel
+      do k=1,nz
+      do j=1,ny
+      do i=1,nx
+         nb = 0
+         if (i.eq.1 .or. i.eq.nx) nb = nb+1
+         if (j.eq.1 .or. j.eq.ny) nb = nb+1
+         if (if3d .and. (k.eq.1 .or. k.eq.nz)) nb = nb+1
+         if (nb.gt.1) glo_num(i,j,k,e) = 0
+      enddo
       enddo
+      enddo
+      enddo
+
+      ntot = nx*ny*nz*nel
+      call gs_setup(gs_h,glo_num,ntot,nekcomm,mp)
+
+      t1 = dnekclock() - t0
+      if (nio.eq.0) then
+         write(6,1) t1,gs_h,nx,ngv,melg
+    1    format('   setupds_face time',1pe11.4,' seconds ',2i3,2i12)
+      endif
+
+      return
       end
 c----------------------------------------------------------------------
       subroutine h1mg_setup_wtmask
@@ -492,11 +554,13 @@ c     exchange interior nodes
 
       call hsmg_fdm(mg_work(i),mg_work,l) ! Do the local solves
 
-c     Sum overlap region (border excluded)
-      call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work(i),l)
-      call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
-      call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+c     Sum overlap region (border excluded), unless restricted (p139)
+      if (param(139).eq.0) then
+       call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
+       call hsmg_schwarz_dssum(mg_work(i),l)
+       call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
+       call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+      endif
 
       if(.not.if3d) then ! Go back to regular size array
          call hsmg_schwarz_toreg2d(e,mg_work(i),mg_nh(l))
@@ -549,11 +613,13 @@ c     exchange interior nodes
 
 c     do the local solves
       call hsmg_fdm(mg_work(i),mg_work,l)
-c     sum overlap region (border excluded)
-      call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work(i),l)
-      call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
-      call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+c     sum overlap region (border excluded), unless restricted (p139)
+      if (param(139).eq.0) then
+       call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
+       call hsmg_schwarz_dssum(mg_work(i),l)
+       call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
+       call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+      endif
 c     go back to regular size array
       if(.not.if3d) then
          call hsmg_schwarz_toreg2d(e,mg_work(i),mg_nh(l))
@@ -652,20 +718,22 @@ c----------------------------------------------------------------------
       include 'INPUT'
       include 'HSMG'
       
-      integer l,i,j,nl
+      integer l,i,j,nl,ng
       i = mg_fast_s_index(mg_lmax,mg_fld-1)
       j = mg_fast_d_index(mg_lmax,mg_fld-1)
+      call hsmg_setup_fast_groups(mg_work)
+      ng = mg_fast_ng(mg_fld)
       do l=2,mg_lmax
          mg_fast_s_index(l,mg_fld)=i
          nl = mg_nh(l)+2
-         i=i+nl*nl*2*ndim*nelv
+         i=i+nl*nl*2*ndim*ng
          if(i .gt. lmg_fasts*2*ldim*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fasts too small',i,itmp,lmg_fasts,l
             call exitt
          endif
          mg_fast_d_index(l,mg_fld)=j
-         j=j+(nl**ndim)*nelv
+         j=j+(nl**ndim)*ng
          if(j .gt. lmg_fastd*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fastd too small',i,itmp,lmg_fastd,l
@@ -686,20 +754,22 @@ c----------------------------------------------------------------------
       include 'INPUT'
       include 'HSMG'
       
-      integer l,i,j,nl
+      integer l,i,j,nl,ng
       i = mg_fast_s_index(mg_lmax,mg_fld-1)
       j = mg_fast_d_index(mg_lmax,mg_fld-1)
+      call hsmg_setup_fast_groups(mg_work)
+      ng = mg_fast_ng(mg_fld)
       do l=2,mg_lmax-1
          mg_fast_s_index(l,mg_fld)=i
          nl = mg_nh(l)+2
-         i=i+nl*nl*2*ndim*nelv
+         i=i+nl*nl*2*ndim*ng
          if(i .gt. lmg_fasts*2*ldim*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fasts too small',i,itmp,lmg_fasts,l
             call exitt
          endif
          mg_fast_d_index(l,mg_fld)=j
-         j=j+(nl**ndim)*nelv
+         j=j+(nl**ndim)*ng
          if(j .gt. lmg_fastd*lelv) then
             itmp = i/(2*ldim*lelv)
             write(6,*) 'lmg_fastd too small',i,itmp,lmg_fastd,l
@@ -715,12 +785,100 @@ c----------------------------------------------------------------------
       return
       end
 c----------------------------------------------------------------------
+c     Sort the elements into groups that have identical FDM operators,
+c     i.e., the same b.c. types and 1D spacings (ll,lm,lr) in each
+c     direction.  S and D are stored once per group, and hsmg_do_fast
+c     applies them to all elements of a group in one batched sweep.
+c     Spacings are compared to a relative tolerance of 1e-8.
+      subroutine hsmg_setup_fast_groups(tkey)
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+      parameter (lkey=5*ldim)
+      real tkey(lkey,nelv)
+      common /ctmpf/  lr(2*lx1+4),ls(2*lx1+4),lt(2*lx1+4)
+     $              , llr(lelt),lls(lelt),llt(lelt)
+     $              , lmr(lelt),lms(lelt),lmt(lelt)
+     $              , lrr(lelt),lrs(lelt),lrt(lelt)
+      real lr ,ls ,lt
+      real llr,lls,llt
+      real lmr,lms,lmt
+      real lrr,lrs,lrt
+
+      integer ikey(lkey),ie,ig,i,k,nkey
+      integer lbr,rbr,lbs,rbs,lbt,rbt,two
+      real wk(lkey),h
+      logical ifnew
+
+      two  = 2
+      ierr = 0
+      nkey = 5*ndim
+
+      h = max(vlmax(lmr,nelv),vlmax(lms,nelv))
+      if (if3d) h = max(h,vlmax(lmt,nelv))
+      h = 1.e-8*h
+      if (h.le.0) h = 1.
+
+      do ie=1,nelv
+         call get_fast_bc(lbr,rbr,lbs,rbs,lbt,rbt,ie,two,ierr)
+         tkey( 1,ie) = lbr
+         tkey( 2,ie) = rbr
+         tkey( 3,ie) = anint(llr(ie)/h)
+         tkey( 4,ie) = anint(lmr(ie)/h)
+         tkey( 5,ie) = anint(lrr(ie)/h)
+         tkey( 6,ie) = lbs
+         tkey( 7,ie) = rbs
+         tkey( 8,ie) = anint(lls(ie)/h)
+         tkey( 9,ie) = anint(lms(ie)/h)
+         tkey(10,ie) = anint(lrs(ie)/h)
+         if (if3d) then
+            tkey(11,ie) = lbt
+            tkey(12,ie) = rbt
+            tkey(13,ie) = anint(llt(ie)/h)
+            tkey(14,ie) = anint(lmt(ie)/h)
+            tkey(15,ie) = anint(lrt(ie)/h)
+         endif
+      enddo
+
+      ierrmx = iglmax(ierr,1)
+      if (ierrmx.gt.0) then
+         if (ierr.gt.0) write(6,*) nid,ierr,' BC FAIL'
+         call exitti('A INVALID BC FOUND in genfast$',ierrmx)
+      endif
+
+      do k=1,nkey
+         ikey(k) = k
+      enddo
+      call tuple_sort(tkey,lkey,nelv,ikey,nkey,mg_fast_e(1,mg_fld),wk)
+
+      ig = 0
+      do i=1,nelv
+         ifnew = (i.eq.1)
+         do k=1,nkey
+            if (i.gt.1) ifnew = ifnew .or. tkey(k,i).ne.tkey(k,i-1)
+         enddo
+         if (ifnew) then
+            ig = ig+1
+            mg_fast_go(ig,mg_fld) = i
+         endif
+      enddo
+      mg_fast_go(ig+1,mg_fld) = nelv+1
+      mg_fast_ng(mg_fld) = ig
+
+      ngmx = iglmax(ig,1)
+      nemx = iglmax(nelv,1)
+      if (nio.eq.0) write(6,1) ngmx,nemx
+    1 format('   hsmg fdm groups:',i9,' for',i9,' elements (max/proc)')
+
+      return
+      end
+c----------------------------------------------------------------------
       subroutine hsmg_setup_fast(s,d,nl,ah,bh,n)
       include 'SIZE'
       include 'INPUT'
       include 'HSMG'
-      real s(nl*nl,2,ndim,nelv)
-      real d(nl**ndim,nelv)
+      real s(nl*nl,2,ndim,1)
+      real d(nl**ndim,1)
       real ah(1),bh(1)
       common /ctmpf/  lr(2*lx1+4),ls(2*lx1+4),lt(2*lx1+4)
      $              , llr(lelt),lls(lelt),llt(lelt)
@@ -732,22 +890,22 @@ c----------------------------------------------------------------------
       real lrr,lrs,lrt
       
       integer i,j,k
-      integer ie,il,nr,ns,nt
+      integer ie,ig,il,nr,ns,nt
       integer lbr,rbr,lbs,rbs,lbt,rbt,two
       real eps,diag
       
       two  = 2
-      ierr = 0
-      do ie=1,nelv
+      do ig=1,mg_fast_ng(mg_fld)         ! one S, D per element group
+         ie = mg_fast_e(mg_fast_go(ig,mg_fld),mg_fld)
          call get_fast_bc(lbr,rbr,lbs,rbs,lbt,rbt,ie,two,ierr)
          nr=nl
          ns=nl
          nt=nl
-         call hsmg_setup_fast1d(s(1,1,1,ie),lr,nr,lbr,rbr
+         call hsmg_setup_fast1d(s(1,1,1,ig),lr,nr,lbr,rbr
      $            ,llr(ie),lmr(ie),lrr(ie),ah,bh,n,ie)
-         call hsmg_setup_fast1d(s(1,1,2,ie),ls,ns,lbs,rbs
+         call hsmg_setup_fast1d(s(1,1,2,ig),ls,ns,lbs,rbs
      $            ,lls(ie),lms(ie),lrs(ie),ah,bh,n,ie)
-         if(if3d) call hsmg_setup_fast1d(s(1,1,3,ie),lt,nt,lbt,rbt
+         if(if3d) call hsmg_setup_fast1d(s(1,1,3,ig),lt,nt,lbt,rbt
      $                     ,llt(ie),lmt(ie),lrt(ie),ah,bh,n,ie)
          il=1
          if(.not.if3d) then
@@ -756,12 +914,12 @@ c----------------------------------------------------------------------
             do i=1,nr
                diag = lr(i)+ls(j)
                if (diag.gt.eps) then
-                  d(il,ie) = 1.0/diag
+                  d(il,ig) = 1.0/diag
                else
 c                 write(6,2) ie,'Reset Eig in hsmg setup fast:',i,j,l
 c    $                         ,eps,diag,lr(i),ls(j)
     2             format(i6,1x,a21,3i5,1p4e12.4)
-                  d(il,ie) = 0.0
+                  d(il,ig) = 0.0
                endif
                il=il+1
             enddo
@@ -774,12 +932,12 @@ c    $                         ,eps,diag,lr(i),ls(j)
             do i=1,nr
                diag = lr(i)+ls(j)+lt(k)
                if (diag.gt.eps) then
-                  d(il,ie) = 1.0/diag
+                  d(il,ig) = 1.0/diag
                else
 c                 write(6,3) ie,'Reset Eig in hsmg setup fast:',i,j,k,l
 c    $                         ,eps,diag,lr(i),ls(j),lt(k)
     3             format(i6,1x,a21,4i5,1p5e12.4)
-                  d(il,ie) = 0.0
+                  d(il,ig) = 0.0
                endif
                il=il+1
             enddo
@@ -788,12 +946,6 @@ c    $                         ,eps,diag,lr(i),ls(j),lt(k)
          endif
       enddo
 
-      ierrmx = iglmax(ierr,1)
-      if (ierrmx.gt.0) then
-         if (ierr.gt.0) write(6,*) nid,ierr,' BC FAIL'
-         call exitti('A INVALID BC FOUND in genfast$',ierrmx)
-      endif
-
       return
       end
 c----------------------------------------------------------------------
@@ -911,37 +1063,126 @@ c     clobbers r
       end
 c----------------------------------------------------------------------
 c     clobbers r
+c
+c     Elements of a group (see hsmg_setup_fast_groups) share S and D.
+c     They are gathered lbat at a time into an element-interleaved
+c     array so that each 1D contraction is one mxm over the batch.
       subroutine hsmg_do_fast(e,r,s,d,nl)
       include 'SIZE'
       include 'INPUT'
+      include 'HSMG'
       real e(nl**ndim,nelv)
       real r(nl**ndim,nelv)
-      real s(nl*nl,2,ndim,nelv)
-      real d(nl**ndim,nelv)
+      real s(nl*nl,2,ndim,1)
+      real d(nl**ndim,1)
+
+      parameter (lbat=16)
+      parameter (lwk=(lx1+2)*(ly1+2)*(lz1+2))
+      common /hsmgb/ wb(lbat*lwk),wb2(lbat*lwk),wb3(lbat*lwk)
       
-      integer ie,nn,i
+      integer ie,ig,nn,i,k0,k1,kb,nb,b,ib
       nn=nl**ndim
-      if(.not.if3d) then
-         do ie=1,nelv
-            call hsmg_tnsr2d_el(e(1,ie),nl,r(1,ie),nl
-     $                         ,s(1,2,1,ie),s(1,1,2,ie))
-            do i=1,nn
-               r(i,ie)=d(i,ie)*e(i,ie)
-            enddo
-            call hsmg_tnsr2d_el(e(1,ie),nl,r(1,ie),nl
-     $                         ,s(1,1,1,ie),s(1,2,2,ie))
-         enddo
-      else
-         do ie=1,nelv
-            call hsmg_tnsr3d_el(e(1,ie),nl,r(1,ie),nl
-     $                         ,s(1,2,1,ie),s(1,1,2,ie),s(1,1,3,ie))
-            do i=1,nn
-               r(i,ie)=d(i,ie)*e(i,ie)
+      do ig=1,mg_fast_ng(mg_fld)
+         k0 = mg_fast_go(ig  ,mg_fld)
+         k1 = mg_fast_go(ig+1,mg_fld)
+         if (k1-k0.eq.1) then
+            ie = mg_fast_e(k0,mg_fld)
+            if(.not.if3d) then
+               call hsmg_tnsr2d_el(e(1,ie),nl,r(1,ie),nl
+     $                            ,s(1,2,1,ig),s(1,1,2,ig))
+               do i=1,nn
+                  r(i,ie)=d(i,ig)*e(i,ie)
+               enddo
+               call hsmg_tnsr2d_el(e(1,ie),nl,r(1,ie),nl
+     $                            ,s(1,1,1,ig),s(1,2,2,ig))
+            else
+               call hsmg_tnsr3d_el(e(1,ie),nl,r(1,ie),nl
+     $                         ,s(1,2,1,ig),s(1,1,2,ig),s(1,1,3,ig))
+               do i=1,nn
+                  r(i,ie)=d(i,ig)*e(i,ie)
+               enddo
+               call hsmg_tnsr3d_el(e(1,ie),nl,r(1,ie),nl
+     $                         ,s(1,1,1,ig),s(1,2,2,ig),s(1,2,3,ig))
+            endif
+         else
+            do kb=k0,k1-1,lbat
+               nb = min(lbat,k1-kb)
+               do i=1,nn                                ! gather
+                  ib = (i-1)*nb
+                  do b=1,nb
+                     wb(ib+b) = r(i,mg_fast_e(kb+b-1,mg_fld))
+                  enddo
+               enddo
+               if(.not.if3d) then
+                  call hsmg_tnsr2d_bat(wb2,wb,nl,nb
+     $                                ,s(1,1,1,ig),s(1,1,2,ig),wb3)
+               else
+                  call hsmg_tnsr3d_bat(wb2,wb,nl,nb
+     $                        ,s(1,1,1,ig),s(1,1,2,ig),s(1,1,3,ig),wb3)
+               endif
+               do i=1,nn
+                  ib = (i-1)*nb
+                  do b=1,nb
+                     wb2(ib+b) = d(i,ig)*wb2(ib+b)
+                  enddo
+               enddo
+               if(.not.if3d) then
+                  call hsmg_tnsr2d_bat(wb,wb2,nl,nb
+     $                                ,s(1,2,1,ig),s(1,2,2,ig),wb3)
+               else
+                  call hsmg_tnsr3d_bat(wb,wb2,nl,nb
+     $                        ,s(1,2,1,ig),s(1,2,2,ig),s(1,2,3,ig),wb3)
+               endif
+               do i=1,nn                                ! scatter
+                  ib = (i-1)*nb
+                  do b=1,nb
+                     e(i,mg_fast_e(kb+b-1,mg_fld)) = wb(ib+b)
+                  enddo
+               enddo
             enddo
-            call hsmg_tnsr3d_el(e(1,ie),nl,r(1,ie),nl
-     $                         ,s(1,1,1,ie),s(1,2,2,ie),s(1,2,3,ie))
-         enddo
-      endif
+         endif
+      enddo
+      return
+      end
+c----------------------------------------------------------------------
+c     computes
+c                                       T       T
+c     v = [B (x) A] u,  for At = A ,  Bt = B ,
+c
+c     on nb element-interleaved arrays u(nb,n,n), v(nb,n,n)
+      subroutine hsmg_tnsr2d_bat(v,u,n,nb,At,Bt,w)
+      integer n,nb
+      real v(nb*n,n),u(nb*n,n),At(n,n),Bt(n,n),w(nb*n,n)
+      integer j
+c
+      do j=1,n
+         call mxm(u(1,j),nb,At,n,w(1,j),n)
+      enddo
+      call mxm(w,nb*n,Bt,n,v,n)
+c
+      return
+      end
+c----------------------------------------------------------------------
+c     computes
+c                                                T       T       T
+c     v = [C (x) B (x) A] u,  for At = A ,  Bt = B ,  Ct = C ,
+c
+c     on nb element-interleaved arrays u(nb,n,n,n), v(nb,n,n,n)
+      subroutine hsmg_tnsr3d_bat(v,u,n,nb,At,Bt,Ct,w)
+      integer n,nb
+      real v(nb*n,n,n),u(nb*n,n,n),At(n,n),Bt(n,n),Ct(n,n),w(nb*n*n,n)
+      integer j,k
+c
+      do k=1,n
+      do j=1,n
+         call mxm(u(1,j,k),nb,At,n,v(1,j,k),n)
+      enddo
+      enddo
+      do k=1,n
+         call mxm(v(1,1,k),nb*n,Bt,n,w(1,k),n)
+      enddo
+      call mxm(w,nb*n*n,Ct,n,v,n)
+c
       return
       end
 c----------------------------------------------------------------------
@@ -1672,10 +1913,43 @@ c     mgnx2 = min(3,mgnx2)
       mg_ny(mg_lmax) = ly1-1
       mg_nz(mg_lmax) = lz1-1
 
+      if (param(136).gt.0) call hsmg_set_ladder(mg_lmax,param(136))
+
       if (nio.eq.0) write(*,*) 'mg_nx:',(mg_nx(i),i=1,mg_lmax)
       if (nio.eq.0) write(*,*) 'mg_ny:',(mg_ny(i),i=1,mg_lmax)
       if (nio.eq.0) write(*,*) 'mg_nz:',(mg_nz(i),i=1,mg_lmax)
 
+      return
+      end
+c----------------------------------------------------------------------
+      subroutine hsmg_set_ladder(lmax,p136) ! p136 levels, top = lx1-1
+c
+c     Halve the order from one level to the next, keeping at least
+c     order l on level l so that all levels stay distinct, e.g.,
+c
+c        lx1 = 12, p136 = 5  ==>  mg_nx = 1, 2, 3, 5, 11
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+      integer lmax
+
+      lmax = p136
+      lmax = max(lmax,2)
+      lmax = min(lmax,lmgn,lx1-1)
+
+      mg_nx(lmax) = lx1-1
+      do l=lmax-1,2,-1
+         mg_nx(l) = min(mg_nx(l+1)-1,max(l,mg_nx(l+1)/2))
+      enddo
+      mg_nx(1) = 1
+
+      do l=1,lmax
+         mg_ny(l) = mg_nx(l)
+         mg_nz(l) = mg_nx(l)
+         if (.not.if3d) mg_nz(l) = 0
+      enddo
+
       return
       end
 c----------------------------------------------------------------------
@@ -1893,11 +2167,13 @@ c     Assumes that preprocessing has been completed via h1mg_setup()
       parameter (lt=lx1*ly1*lz1*lelt)
       common /scrmg/ e(2*lt),w(lt),r(lt)
       integer p_msk,p_b
-      logical if_hybrid
+      logical if_hybrid,ifcheb
 
 c     if_hybrid = .true.    ! Control this from gmres, according
 c     if_hybrid = .false.   ! to convergence efficiency
 
+      ifcheb = param(137).gt.0                        ! Chebyshev smoothing
+
       nel   = nelfld(ifield)
 
       op    =  1.                                     ! Coefficients for h1mg_ax
@@ -1909,11 +2185,15 @@ c     if_hybrid = .false.   ! to convergence efficiency
       n     = mg_h1_n(l,mg_fld)
       is    = 1                                       ! solve index
 
-      call h1mg_schwarz(z,rhs,sigma,l)                ! z := sigma W M       rhs
+      if (ifcheb) then
+         call copy(r,rhs,n)                           ! r  := rhs
+         call h1mg_cheby(z,r,l)                       ! z := p(MA) M rhs
+      else                                            ! r := rhs - A z
+         call h1mg_schwarz(z,rhs,sigma,l)             ! z := sigma W M   rhs
                                                       !               Schwarz
-      call copy(r,rhs,n)                              ! r  := rhs
-      if (if_hybrid) call h1mg_axm(r,z,op,om,l,w)     ! r  := rhs - A z
-                                                      !  l
+         call copy(r,rhs,n)                           ! r  := rhs
+         if (if_hybrid) call h1mg_axm(r,z,op,om,l,w)  ! r  := rhs - A z
+      endif                                           !  l
 
       do l = mg_h1_lmax-1,2,-1                        ! DOWNWARD Leg of V-cycle
          is = is + n
@@ -1921,12 +2201,15 @@ c     if_hybrid = .false.   ! to convergence efficiency
                                                       !          T
          call h1mg_rstr(r,l,.true.)                   ! r   :=  J r
                                                       !  l         l+1
-!        OVERLAPPING Schwarz exchange and solve:
-         call h1mg_schwarz(e(is),r,sigma,l)           ! e := sigma W M       r
-                                                      !  l            Schwarz l
-
-         if(if_hybrid)call h1mg_axm(r,e(is),op,om,l,w)! r  := r - A e
-                                                      !  l           l
+         if (ifcheb) then
+            call h1mg_cheby(e(is),r,l)                ! e := p(MA) M r
+         else                                         ! r := r - A e
+!           OVERLAPPING Schwarz exchange and solve:
+            call h1mg_schwarz(e(is),r,sigma,l)        ! e := sigma W M   r
+                                                      !  l        Schwarz l
+            if (if_hybrid)
+     $         call h1mg_axm(r,e(is),op,om,l,w)       ! r  := r - A e
+         endif                                        !  l           l
       enddo
       is = is+n
                                                       !         T
@@ -1945,8 +2228,8 @@ c     call exitt
 
       do l = 2,mg_h1_lmax-1                           ! UNWIND.  No smoothing.
          im = is
-         is = is - n
          n  = mg_h1_n(l,mg_fld)
+         is = is - n
          call hsmg_intp (w,e(im),l-1)                 ! w   :=  J e
          i1=is-1                                      !            l-1
          do i=1,n
@@ -1964,6 +2247,190 @@ c     call exitt
 
       call dsavg(z) ! Emergency hack --- to ensure continuous z!
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine h1mg_cheby(e,r,l)
+c
+c     Chebyshev-accelerated smoothing on level l, starting from e = 0:
+c
+c        e := p(M A) M r,     r := r - A e
+c
+c     M is W M_Schwarz (p137=1) or the inverse diagonal of A (p137=2).
+c     p has degree p138 and targets [0.3*lam,1.1*lam], where lam is a
+c     power-iteration estimate of the largest eigenvalue of M A; the
+c     lower part of the spectrum is left to the coarser levels.
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+
+      real e(1),r(1)
+
+      parameter (lt=lx1*ly1*lz1*lelt)
+      common /scrcb/ d(lt),s(lt),wk(lt)
+
+      if (mg_lam(l,mg_fld).eq.0) call h1mg_eig_est(l)
+
+      n     = mg_h1_n(l,mg_fld)
+      op    =  1.
+      om    = -1.
+
+      k     = param(138)
+      if (k.le.0) k = 2
+      if (param(138).le.0 .and. param(137).eq.2) k = 6  ! weaker smoother
+
+      bmax  = 1.1*mg_lam(l,mg_fld)
+      bmin  = 0.3*mg_lam(l,mg_fld)
+      theta = 0.5*(bmax+bmin)
+      delta = 0.5*(bmax-bmin)
+      sigma = theta/delta
+      rho   = 1./sigma
+
+      call h1mg_smooth (s,r,l)                 ! s := M r
+      call cmult2      (d,s,1./theta,n)        ! d := s / theta
+      call copy        (e,d,n)
+      call h1mg_axm    (r,d,op,om,l,wk)        ! r := r - A d
+
+      do i=2,k
+         rhon = 1./(2.*sigma-rho)
+         call h1mg_smooth (s,r,l)
+         call add2sxy     (d,rhon*rho,s,2.*rhon/delta,n)
+         call add2        (e,d,n)
+         call h1mg_axm    (r,d,op,om,l,wk)
+         rho  = rhon
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine h1mg_smooth(s,r,l) ! s := M r, M = Schwarz or Jacobi
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+
+      real s(1),r(1)
+
+      if (param(137).eq.2) then
+         n = mg_h1_n(l,mg_fld)
+         call col3(s,mg_jac(mg_solve_index(l,mg_fld)),r,n)
+      else
+         one = 1.
+         call h1mg_schwarz(s,r,one,l)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine h1mg_eig_est(l)  ! power iteration for lam_max(M A)
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+
+      parameter (lt=lx1*ly1*lz1*lelt)
+      common /scrcb/ x(lt),y(lt),wk(lt)
+
+      if (param(137).eq.2) call h1mg_setup_jac(l)
+
+      n    = mg_h1_n(l,mg_fld)
+      zero = 0.
+      one  = 1.
+
+      do i=1,n
+         y(i) = sin(real(i))
+      enddo
+      call hsmg_dssum (y,l)
+      call h1mg_smooth(x,y,l)
+
+c     The ratio of the top eigenvalues of M A is close to 1, so the
+c     estimate converges slowly from below; 10 iterations were 30% low
+c     and p(M A) then amplified the top of the spectrum.
+
+      rlam = 0.
+      do iter=1,40
+         xx = glsc2(x,x,n)
+         if (xx.eq.0) goto 10
+         call h1mg_axm   (y,x,zero,one,l,wk)  ! y := A x
+         call h1mg_smooth(x,y,l)              ! x := M y
+         xn   = glsc2(x,x,n)
+         rlam = sqrt(xn/xx)
+         if (xn.gt.0) call cmult(x,1./sqrt(xn),n)
+      enddo
+   10 continue
+
+      if (rlam.eq.0) rlam = 1.
+      mg_lam(l,mg_fld) = rlam
+      if (nio.eq.0) write(6,1) l,mg_fld,rlam
+    1 format(' h1mg eig. est. (level,fld):',2i3,1p1e13.4)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine h1mg_setup_jac(l)  ! inverse diagonal of A on level l
+      include 'SIZE'
+      include 'INPUT'
+      include 'HSMG'
+      include 'TSTEP'  ! nelfld
+
+      integer p_h1,p_g,p_b,p_msk,e
+
+      p_h1  = p_mg_h1  (l,mg_fld)
+      p_g   = p_mg_g   (l,mg_fld)
+      p_msk = p_mg_msk (l,mg_fld)
+
+      if (p_h1 .eq.0) call mg_set_h1  (p_h1 ,l)
+      if (p_g  .eq.0) call mg_set_gb  (p_g,p_b,l)
+      if (p_msk.eq.0) call mg_set_msk (p_msk,l)
+
+      nx   = mg_nh(l)
+      nz   = mg_nhz(l)
+      nxyz = nx*nx*nz
+      ng   = 3*ndim-3
+      nel  = nelfld(ifield)
+      n    = nxyz*nel
+      i0   = mg_solve_index(l,mg_fld)
+
+      do e=1,nel
+         call h1mg_diag_e(mg_jac(i0+nxyz*(e-1)),mg_g(p_g+ng*nxyz*(e-1))
+     $                   ,mg_h1(p_h1+nxyz*(e-1)),mg_dh(1,l),ng,nx,nz)
+      enddo
+
+      call hsmg_dssum(mg_jac(i0),l)
+      call invcol1   (mg_jac(i0),n)
+      call h1mg_mask (mg_jac(i0),mg_imask(p_msk),nel)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine h1mg_diag_e(dg,g,h1,dh,ng,nx,nz) ! diagonal of axe
+      include 'SIZE'
+      include 'INPUT'  ! if3d
+
+      real dg(nx,nx,nz),g(ng,nx,nx,nz),h1(nx,nx,nz),dh(nx,nx)
+
+      do k=1,nz
+      do j=1,nx
+      do i=1,nx
+         s = 0.
+         do m=1,nx
+            s = s + h1(m,j,k)*g(1,m,j,k)*dh(m,i)**2
+     $            + h1(i,m,k)*g(2,i,m,k)*dh(m,j)**2
+         enddo
+         if (if3d) then
+            do m=1,nz
+               s = s + h1(i,j,m)*g(3,i,j,m)*dh(m,k)**2
+            enddo
+            s = s + 2.*h1(i,j,k)*( g(4,i,j,k)*dh(i,i)*dh(j,j)
+     $                           + g(5,i,j,k)*dh(i,i)*dh(k,k)
+     $                           + g(6,i,j,k)*dh(j,j)*dh(k,k) )
+         else
+            s = s + 2.*h1(i,j,k)*g(3,i,j,k)*dh(i,i)*dh(j,j)
+         endif
+         dg(i,j,k) = s
+      enddo
+      enddo
+      enddo
+
       return
       end
 c-----------------------------------------------------------------------
@@ -2261,6 +2728,10 @@ c----------------------------------------------------------------------
 
       integer p_h1,p_h2,p_g,p_b,p_msk
 
+      do l=1,mg_lmax-1                ! replaces the handles of hsmg_setup
+         call gs_free(mg_gsh_handle        (l,mg_fld))
+         call gs_free(mg_gsh_schwarz_handle(l,mg_fld))
+      enddo
 
       param(59) = 1
       call geom_reset(1)  ! Recompute g1m1 etc. with deformed only
@@ -2278,6 +2749,7 @@ c----------------------------------------------------------------------
       call h1mg_setup_fdm    ! set up fast diagonalization method
       call h1mg_setup_schwarz_wt(.false.)
       call hsmg_setup_solve  ! set up the solver
+      call rzero(mg_lam(1,mg_fld),lmgx) ! eig. bounds, estimated on use
 
       l=mg_h1_lmax
       call mg_set_h1  (p_h1 ,l)
@@ -2340,6 +2812,8 @@ c     if (lx1.eq.6)  mgnx2 = 3
       mg_ny(mg_h1_lmax) = ly1-1
       mg_nz(mg_h1_lmax) = lz1-1
 
+      if (param(136).gt.0) call hsmg_set_ladder(mg_h1_lmax,param(136))
+
       if (nio.eq.0) write(*,*) 'h1_mg_nx:',(mg_nx(i),i=1,mg_h1_lmax)
       if (nio.eq.0) write(*,*) 'h1_mg_ny:',(mg_ny(i),i=1,mg_h1_lmax)
       if (nio.eq.0) write(*,*) 'h1_mg_nz:',(mg_nz(i),i=1,mg_h1_lmax)
@@ -2404,8 +2878,8 @@ c----------------------------------------------------------------------
          ny=ny+2
          nz=nz+2
          if(.not.if3d) nz=1
-         call setupds(mg_gsh_schwarz_handle(l,mg_fld),nx,ny,nz
-     $                ,nelv,nelgv,vertex,glo_num)
+         call setupds_face(mg_gsh_schwarz_handle(l,mg_fld),nx,ny,nz
+     $                    ,nelv,nelgv,vertex,glo_num)
       enddo
 
       return
@@ -3088,11 +3562,13 @@ c----------------------------------------------------------------------
 
       call rone(mg_work(i),ns)
  
-c     Sum overlap region (border excluded)
-      call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
-      call hsmg_schwarz_dssum(mg_work(i),l)
-      call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
-      call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+c     Sum overlap region (border excluded), unless restricted (p139)
+      if (param(139).eq.0) then
+       call hsmg_extrude(mg_work,0,zero,mg_work(i),0,one ,enx,eny,enz)
+       call hsmg_schwarz_dssum(mg_work(i),l)
+       call hsmg_extrude(mg_work(i),0,one ,mg_work,0,onem,enx,eny,enz)
+       call hsmg_extrude(mg_work(i),2,one,mg_work(i),0,one,enx,eny,enz)
+      endif
 
       if(.not.if3d) then ! Go back to regular size array
          call hsmg_schwarz_toreg2d(mg_work,mg_work(i),mg_nh(l))
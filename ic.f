@@ -1113,6 +1113,7 @@ C
          ifgtps(i)=.false.
   100 continue
       ifgtim=.true.
+      ifintr=.false.
       ndumps=0
 C
 C     Check for default case - just a filename given, no i/o options specified
@@ -1148,6 +1149,11 @@ C           remove the user specified time from the RS options line.
             CALL CHCOPY(RSOPT1(ITO),LINE1(IT1),ITB)
          ENDIF
 
+C        Interpolate from a different mesh (see mfi_int).
+
+         IIO=INDX_CUT(RSOPT,'INT',3)
+         IF (IIO.NE.0) IFINTR=.TRUE.
+
 C        Parse field specifications.
 
          IXO=INDX_CUT(RSOPT,'X',1)
@@ -1208,6 +1214,12 @@ C     If no fields were explicitly specified, assume getting all fields.
             ifgtps(i)=.TRUE.
   410    continue
       ENDIF
+
+C     Interpolation keeps the current mesh.
+      if (ifintr) then
+         ifgetx=.false.
+         ifgetz=.false.
+      endif
 C
       return
       END
@@ -2069,6 +2081,12 @@ c-----------------------------------------------------------------------
 
       call nekgsync() ! clear outstanding message queues.
 
+      if (izipr.ne.0) then             ! compressed field data
+         call mfi_getz(wk,lwk,1,iskip,ierr)
+         if (iskip .or. ierr.ne.0) goto 100
+         goto 50
+      endif
+
       nxyzr = nxr*nyr*nzr   
       len   = nxyzr*wdsizr  ! message length
       if (wdsizr.eq.8) nxyzr = 2*nxyzr
@@ -2079,16 +2097,12 @@ c-----------------------------------------------------------------------
       call lim_chk(num_recv,num_avail,'     ','     ','mfi_gets a')
 
       ! setup read buffer
-      if (nid.eq.pid0r) then
-         nread = nxyzr*nelr/lrbs
-         if(mod(nxyzr*nelr,lrbs).ne.0) nread = nread + 1
+      nelrb = lrbs/nxyzr                  ! elements per read
+      call lim_chk(nxyzr,lrbs,'     ','     ','mfi_gets b')
+      nread = (nelr+nelrb-1)/nelrb
 #ifdef MPIIO 
-         nread = iglmax(nread,1) ! needed because of collective read
+      nread = iglmax(nread,1) ! needed because of collective read
 #endif
-         nelrr = nelr/nread
-      endif
-      call bcast(nelrr,4)
-      call lim_chk(nxyzr*nelrr,lrbs,'     ','     ','mfi_gets b')
 
       ! pre-post recieves
       if (np.gt.1) then
@@ -2105,10 +2119,7 @@ c-----------------------------------------------------------------------
          ! read blocks of size nelrr
          k = 0
          do i = 1,nread
-            if(i.eq.nread) then ! clean-up 
-              nelrr = nelr - (nread-1)*nelrr
-              if(nelrr.lt.0) nelrr = 0
-            endif
+            nelrr = max(0,min(nelrb,nelr-k))
             
             if(ierr.eq.0) then
 #ifdef MPIIO 
@@ -2149,20 +2160,22 @@ c     endif
          goto 100     ! don't use the data
       endif
 
-      nxyzr = nxr*nyr*nzr
+   50 nxyzr = nxr*nyr*nzr
       nxyzv = nxr*nyr*nzr
       nxyzw = nxr*nyr*nzr
       if (wdsizr.eq.8) nxyzw = 2*nxyzw
 
       l = 1
       do e=1,nelt
-         if (np.gt.1) then
+         if (izipr.ne.0) then          ! decoded in place by mfi_getz
+            ei = e
+         elseif (np.gt.1) then
             call msgwait(msg_id(e))
             ei = e
          elseif(np.eq.1) then
             ei = er(e)
          endif
-         if (if_byte_sw) then
+         if (if_byte_sw.and.izipr.eq.0) then
             if(wdsizr.eq.8) then
               call byte_reverse8(wk(l),nxyzv*2,ierr)
             else
@@ -2209,6 +2222,12 @@ c-----------------------------------------------------------------------
 
       call nekgsync() ! clear outstanding message queues.
 
+      if (izipr.ne.0) then             ! compressed field data
+         call mfi_getz(wk,lwk,ndim,iskip,ierr)
+         if (iskip .or. ierr.ne.0) goto 100
+         goto 50
+      endif
+
       nxyzr = ndim*nxr*nyr*nzr
       len   = nxyzr*wdsizr             ! message length in bytes
       if (wdsizr.eq.8) nxyzr = 2*nxyzr
@@ -2219,16 +2238,12 @@ c-----------------------------------------------------------------------
       call lim_chk(num_recv,num_avail,'     ','     ','mfi_getv a')
 
       ! setup read buffer
-      if(nid.eq.pid0r) then
-         nread = nxyzr*nelr/lrbs
-         if(mod(nxyzr*nelr,lrbs).ne.0) nread = nread + 1
+      nelrb = lrbs/nxyzr                  ! elements per read
+      call lim_chk(nxyzr,lrbs,'     ','     ','mfi_getv b')
+      nread = (nelr+nelrb-1)/nelrb
 #ifdef MPIIO 
-         nread = iglmax(nread,1) ! needed because of collective read
+      nread = iglmax(nread,1) ! needed because of collective read
 #endif
-         nelrr = nelr/nread
-      endif
-      call bcast(nelrr,4)
-      call lim_chk(nxyzr*nelrr,lrbs,'     ','     ','mfi_getv b')
 
       ! pre-post recieves (one mesg per element)
       ! this assumes we never pre post more messages than supported
@@ -2245,10 +2260,7 @@ c-----------------------------------------------------------------------
       if (nid.eq.pid0r .and. np.gt.1) then ! only i/o nodes
          k = 0
          do i = 1,nread
-            if(i.eq.nread) then ! clean-up 
-              nelrr = nelr - (nread-1)*nelrr
-              if(nelrr.lt.0) nelrr = 0
-            endif
+            nelrr = max(0,min(nelrb,nelr-k))
 
             if(ierr.eq.0) then
 #ifdef MPIIO 
@@ -2288,20 +2300,22 @@ c     endif
          goto 100     ! don't assign the data we just read
       endif
 
-      nxyzr = nxr*nyr*nzr
+   50 nxyzr = nxr*nyr*nzr
       nxyzv = ndim*nxr*nyr*nzr
       nxyzw = nxr*nyr*nzr
       if (wdsizr.eq.8) nxyzw = 2*nxyzw
 
       l = 1
       do e=1,nelt
-         if (np.gt.1) then
+         if (izipr.ne.0) then          ! decoded in place by mfi_getz
+            ei = e
+         else if (np.gt.1) then
             call msgwait(msg_id(e))
             ei = e
          else if(np.eq.1) then
             ei = er(e) 
          endif
-         if (if_byte_sw) then
+         if (if_byte_sw.and.izipr.eq.0) then
             if(wdsizr.eq.8) then
                call byte_reverse8(wk(l),nxyzv*2,ierr)
             else
@@ -2337,6 +2351,196 @@ c     endif
       enddo
 
  100  call err_chk(ierr,'Error reading restart data, in getv.$')
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_seek(ioff) ! position the readers at byte ioff
+
+c     Each reader's slice of a field is contiguous in its file,
+c     starting at ioff (see mfi_prepare).  Compressed fields are
+c     located by mfi_getz.
+
+      include 'SIZE'
+      include 'RESTART'
+
+      integer*8 ioff
+
+#ifdef MPIIO
+      call byte_set_view(ioff,ifh_mbyte)
+#else
+      ierr = 0
+      if (izipr.eq.0 .and. nelr.gt.0) call byte_seek(ioff,ierr)
+      call err_chk(ierr,'Error seeking in restart file.$')
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_getz(wk,lwk,ncomp,iskip,ierr) ! compressed field
+
+c     Read a field written by mfo_outz, starting at byte ioffzr of the
+c     file: each reader reads the block lengths of all nelfr elements
+c     of its file, and then the blocks of its slice (nelBr+1..nelBr+
+c     nelr), which are sent to the ranks owning the elements, where
+c     they are decoded.  On return, the nwv words of element e (byte
+c     order of this machine, nodal values) are in wk(1+(e-1)*nwv), as
+c     for the raw format.  izipr = 3/4 (restart base/delta, see
+c     restart_save): the decoded words are kept as reference for the
+c     next file, which is why fields are decoded even if skipped.  A
+c     delta records the step and time of its base (mfo_write_hdr),
+c     which must be the previous reference file read.
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real*4 wk(lwk) ! message buffer
+      logical iskip
+
+      parameter(lrbs=20*lx1*ly1*lz1*lelt)
+      common /vrthov/ w2(lrbs) ! read buffer
+      real*4 w2
+
+      parameter (lxm=lx1+6)             ! as in mapab
+      common /zipr/ zb(2+2*ldim*lxm*lxm*lxm),nbz(lelr)
+      real*4 zb
+
+      integer e,e0,e1,msg_id(lelt)
+      integer*8 nskip,ntot
+
+      if (nzslot.eq.0 .and. izipr.ge.3) then ! new reference file
+         if (izipr.eq.4 .and. (izbsr.ne.izstr .or. tzbsr.ne.tzstr)) then
+            if (nid.eq.0) write(6,1) istpr,izbsr,tzbsr,izstr,tzstr
+    1       format(' ERROR: delta of step',i10,' is based on step',i10,
+     $             1pe14.6,', but the previous file is step',i10,e14.6)
+            ierr = 1
+            return
+         endif
+         izstr = istpr
+         tzstr = timer
+      endif
+
+      nxyz = nxr*nyr*nzr
+      nwv  = ncomp*nxyz*wdsizr/4        ! words per element
+      lmsg = 1 + nwv                    ! max. words per block
+      call lim_chk(nelt*lmsg,lwk*wdsize/4,'     ','     ','mfi_getz a')
+      call lim_chk(lmsg,lrbs,'     ','     ','mfi_getz b')
+      if (nxr.gt.lxm) call exitti('ABORT: mfi_getz, nxr too large$',nxr)
+
+      if (np.gt.1) then                 ! pre-post receives
+         l = 1
+         do e=1,nelt
+            msg_id(e) = irecv(lglel(e),wk(l),4*lmsg)
+            l = l+lmsg
+         enddo
+      endif
+
+      ierr = 0
+      if (nid.eq.pid0r) then
+         call byte_seek(ioffzr,ierr)
+         if (ierr.eq.0) call byte_read(nbz,nelfr,ierr)
+         if (ierr.eq.0.and.if_byte_sw) call byte_reverse(nbz,nelfr,ierr)
+         nskip = 0
+         ntot  = 0
+         do e=1,nelfr
+            if (nbz(e).lt.1 .or. nbz(e).gt.lmsg) ierr = 1
+            if (e.eq.nelBr+1) nskip = ntot
+            ntot = ntot + nbz(e)
+         enddo
+         if (ierr.ne.0) call ifill(nbz,1,nelfr) ! keep receivers going
+         if (ierr.eq.0) call byte_seek(ioffzr+4*(nelfr+nskip),ierr)
+         ioffzr = ioffzr + 4*(nelfr+ntot)   ! next field
+
+         e1 = 0
+         do while (e1.lt.nelr)          ! read a batch of blocks
+            e0 = e1+1
+            n  = 0
+            do while (e1.lt.nelr)
+               if (n+nbz(nelBr+e1+1).gt.lrbs) goto 10
+               e1 = e1+1
+               n  = n+nbz(nelBr+e1)
+            enddo
+   10       if (ierr.eq.0) call byte_read(w2,n,ierr)
+            if (ierr.ne.0) call rzero4(w2,n)
+
+            l = 1
+            do e=e0,e1
+               nb = nbz(nelBr+e)
+               if (np.gt.1) then
+                  call csend(er(e),w2(l),4*nb,gllnid(er(e)),0)
+               else
+                  call icopy(wk(1+(er(e)-1)*lmsg),w2(l),nb)
+               endif
+               l = l+nb
+            enddo
+         enddo
+      endif
+
+      if (np.gt.1) then
+         do e=1,nelt
+            call msgwait(msg_id(e))
+         enddo
+      endif
+      nzslot = nzslot + 1               ! reference field, see byte_xref
+      if (ierr.ne.0) return
+      if (iskip .and. izipr.lt.3) return
+
+      ixor  = 1
+      if (izipr.eq.2 .or. izipr.eq.4) ixor = 0
+      idir  = 0
+      if (izipr.eq.4) idir = -1
+      iswap = 0
+      if (if_byte_sw) iswap = 1
+
+      do e=1,nelt                       ! decode, in place
+         call icopy(zb,wk(1+(e-1)*lmsg),lmsg)
+         l = 1+(e-1)*nwv
+         call byte_unzip(wk(l),nwv,zb,wdsizr,ixor,iswap,ierr)
+         if (ierr.eq.0 .and. izipr.ge.3)
+     $      call byte_xref(wk(l),nwv,nzslot,(e-1)*nwv,idir,ierr)
+         if (ierr.ne.0) return
+         if (if_byte_sw) then
+            if (wdsizr.eq.8) then
+               call byte_reverse8(wk(l),nwv,ierr)
+            else
+               call byte_reverse(wk(l),nwv,ierr)
+            endif
+         endif
+         if (izipr.eq.2) then           ! Legendre coefficients
+            do k=1,ncomp
+               call mfi_znodal(wk(l),nxr)
+               l = l+nxyz*wdsizr/4
+            enddo
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_znodal(x,n) ! modal coefficients to nodal values
+
+      include 'SIZE'
+      include 'RESTART'
+
+      real*4 x(1)
+
+      parameter (lxm=lx1+6)             ! as in mapab
+      common /ziprw/ uh(lxm*lxm*lxm),uz(lxm*lxm*lxm)
+
+      nxyz = n**ndim
+      if (wdsizr.eq.4) then
+         call copy4r(uh,x,nxyz)
+      else
+         call copy  (uh,x,nxyz)
+      endif
+      call zip_modal(uz,uh,n,-1)
+      if (wdsizr.eq.4) then
+         call copyx4(x,uz,nxyz)
+      else
+         call copy  (x,uz,nxyz)
+      endif
+
       return
       end
 c-----------------------------------------------------------------------
@@ -2345,7 +2549,8 @@ c-----------------------------------------------------------------------
 
       character*132 hdr
 
-      if (indx2(hdr,132,'#std',4).eq.1) then
+      if (indx2(hdr,132,'#std',4).eq.1 .or.
+     $    indx2(hdr,132,'#zip',4).eq.1) then
           call parse_std_hdr(hdr)
       else
          if (nio.eq.0) write(6,80) hdr
@@ -2371,6 +2576,12 @@ c-----------------------------------------------------------------------
      $         ,  ifiler,nfiler
      $         ,  rdcode      ! 74+20=94
 
+      izipr = 0                 ! compressed field data, see mfo_outz
+      if (hdr(1:4).eq.'#zip') read(hdr(95:95),'(i1)') izipr
+      izbsr = -1                ! delta: step/time of its base
+      tzbsr = 0.
+      if (izipr.eq.4) read(hdr(97:127),*,iostat=ios) izbsr,tzbsr
+
 #ifdef MPIIO
       if ((nelr/np + np).gt.lelr) then
         write(6,'(A,I6)') 'ABORT: nelr>lelr on rank',nid
@@ -2451,6 +2662,7 @@ c                4  7  10  13   23    33    53    62     68     74
      $         , ifiler,nfiler
      $         , (rlcode(k),k=1,20)                   ! 74+20=94
     1 format(4x,i2,3i3,2i10,e20.13,i9,2i6,20a1)
+      izipr = 0
 
 
       if (nid.eq.0) write(6,*) 'WARNING: reading depreacted header!'
@@ -2518,18 +2730,25 @@ c
       call mfi_prepare(fname)       ! determine reader nodes +
                                     ! read hdr + element mapping 
 
-      offs0   = iHeadersize + 4 + isize*nelgr
+      offs0   = iHeadersize + 4 + isize*nelfr
       nxyzr8  = nxr*nyr*nzr
       strideB = nelBr* nxyzr8*wdsizr
-      stride  = nelgr* nxyzr8*wdsizr
+      stride  = nelfr* nxyzr8*wdsizr
+      ioffzr  = offs0
+      nzslot  = 0
 
       if_full_pres_tmp = if_full_pres
       if (wdsizr.eq.8) if_full_pres = .true. !Preserve mesh 2 pressure
 
       iofldsr = 0
+      if (ifintr .or. nelgr.ne.nelgt) then   ! different mesh
+         call mfi_int(iofldsr,pm1,ifile)
+         goto 100
+      endif
+
       if (ifgetxr) then      ! if available
          offs = offs0 + ndim*strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_seek(offs)
          if (ifgetx) then
 c            if(nid.eq.0) write(6,*) 'Reading mesh'
             call mfi_getv(xm1,ym1,zm1,wk,lwk,.false.)
@@ -2541,7 +2760,7 @@ c            if(nid.eq.0) write(6,*) 'Reading mesh'
 
       if (ifgetur) then
          offs = offs0 + iofldsr*stride + ndim*strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_seek(offs)
          if (ifgetu) then
             if (ifmhd.and.ifile.eq.2) then
 c               if(nid.eq.0) write(6,*) 'Reading B field'
@@ -2558,7 +2777,7 @@ c               if(nid.eq.0) write(6,*) 'Reading velocity field'
 
       if (ifgetpr) then
          offs = offs0 + iofldsr*stride + strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_seek(offs)
          if (ifgetp) then
 c           if(nid.eq.0) write(6,*) 'Reading pressure field'
             call mfi_gets(pm1,wk,lwk,.false.)
@@ -2570,7 +2789,7 @@ c           if(nid.eq.0) write(6,*) 'Reading pressure field'
 
       if (ifgettr) then
          offs = offs0 + iofldsr*stride + strideB
-         call byte_set_view(offs,ifh_mbyte)
+         call mfi_seek(offs)
          if (ifgett) then
 c            if(nid.eq.0) write(6,*) 'Reading temperature field'
             call mfi_gets(t,wk,lwk,.false.)
@@ -2584,7 +2803,7 @@ c            if(nid.eq.0) write(6,*) 'Reading temperature field'
       do k=1,ldimt-1
          if (ifgtpsr(k)) then
             offs = offs0 + iofldsr*stride + strideB
-            call byte_set_view(offs,ifh_mbyte)
+            call mfi_seek(offs)
             if (ifgtps(k)) then
 c               if(nid.eq.0) write(6,'(A,I2,A)') ' Reading ps',k,' field'
                call mfi_gets(t(1,1,1,1,k+1),wk,lwk,.false.)
@@ -2594,7 +2813,7 @@ c               if(nid.eq.0) write(6,'(A,I2,A)') ' Reading ps',k,' field'
             iofldsr = iofldsr + 1
          endif
       enddo
-      nbyte = 0
+  100 nbyte = 0
       if(nid.eq.pid0r) nbyte = iofldsr*nelr*wdsizr*nxr*nyr*nzr
 
       if (ifgtim) time = timer
@@ -2647,6 +2866,10 @@ c-----------------------------------------------------------------------
       integer      iname(33)
       equivalence (iname,fname)
 
+c     Wait for pending asynchronous output (p140): the file opened may
+c     be the one still in flight, and only its i/o node knows when it
+c     is complete.  Reads are thus serialized behind async output.
+      call mfo_async_wait
       call izero  (iname,33)
       len = ltrunc(hname,132)
       call chcopy (fname,hname,len)
@@ -2685,7 +2908,6 @@ c-----------------------------------------------------------------------
       include 'PARALLEL'
       include 'RESTART'
 
-      integer stride
       character*132 hdr
       logical if_byte_swap_test
       real*4 bytetest
@@ -2718,29 +2940,39 @@ c-----------------------------------------------------------------------
       call bcast(hdr,iHeaderSize)  
       if(nid.ne.0) call mfi_parse_hdr(hdr,ierr)
 
-      stride = np / nfiler
-      if (stride.lt.1) then
+      if (np.lt.nfiler) then
          write(6,*) nfiler,np,'  TOO MANY FILES, mfi_prepare'
          call exitt
       endif
 
-      if (mod(nid,stride).eq.0) then ! i/o clients
-         pid0r = nid
-         pid1r = nid + stride
-         fid0r = nid / stride
-         if (nid.ne.0) then ! don't do it again for rank0
-            call blank     (hdr,iHeaderSize)
-            call mbyte_open(hname,fid0r,ierr) ! open  blah000.fldnn
-            if(ierr.ne.0) goto 102
-            call byte_read (hdr, iHeaderSize/4,ierr)  
-            if(ierr.ne.0) goto 102
-            call byte_read (bytetest,1,ierr) 
-            if(ierr.ne.0) goto 102
-            call mfi_parse_hdr (hdr,ierr)  ! replace hdr with correct one 
-         endif
-         call byte_read (er,nelr,ierr)     ! get element mapping
-         if (if_byte_sw) call byte_reverse(er,nelr,ierr)
+      ! every rank reads a contiguous slice of the elements of file
+      ! fid0r, which is shared by ranks (fid0r*np)/nfiler and up
+      fid0r = ((nid+1)*nfiler-1)/np
+      ig0   = (fid0r*np)/nfiler
+      ng    = ((fid0r+1)*np)/nfiler - ig0
+      pid0r = nid
+      pid1r = nid
+      if (nid.ne.0) then ! don't do it again for rank0
+         call blank     (hdr,iHeaderSize)
+         call mbyte_open(hname,fid0r,ierr) ! open  blah000.fldnn
+         if(ierr.ne.0) goto 102
+         call byte_read (hdr, iHeaderSize/4,ierr)  
+         if(ierr.ne.0) goto 102
+         call byte_read (bytetest,1,ierr) 
+         if(ierr.ne.0) goto 102
+         call mfi_parse_hdr (hdr,ierr)  ! replace hdr with correct one 
       endif
+      nelfr = nelr
+      i     = nid - ig0
+      nelr  = nelfr/ng
+      nelBr = i*nelr + min(i,mod(nelfr,ng))
+      if (i.lt.mod(nelfr,ng)) nelr = nelr + 1
+
+      offs = iHeaderSize + 4 + isize*nelBr
+      call byte_seek (offs,ierr)
+      if(ierr.ne.0) goto 102
+      call byte_read (er,nelr,ierr)     ! get element mapping
+      if (if_byte_sw) call byte_reverse(er,nelr,ierr)
 #else
       pid0r = nid
       pid1r = nid
@@ -2763,6 +2995,10 @@ c-----------------------------------------------------------------------
 
       if_byte_sw = if_byte_swap_test(bytetest,ierr) ! determine endianess
       call mfi_parse_hdr(hdr,ierr)
+      if(izipr.ne.0) then
+        if(nid.eq.0) write(6,*) 'ABORT: compressed file needs byte i/o!'
+        call exitt
+      endif
       if(nfiler.ne.1) then
         if(nid.eq.0) write(6,*) 'ABORT: too many restart files!'
         call exitt
@@ -2775,6 +3011,7 @@ c-----------------------------------------------------------------------
          if(i.eq.nid) nelr = nelr + 1
       enddo
       nelBr = igl_running_sum(nelr) - nelr 
+      nelfr = nelgr
       offs = offs0 + nelBr*isize
 
       call byte_set_view(offs,ifh_mbyte)
@@ -2882,6 +3119,7 @@ c-----------------------------------------------------------------------
       character*80 s80(n_restart)
 
       ifile = istep+1  ! istep=0,1,...
+                       ! delta files (p144) need the preceding ones
 
       if (ifile.le.n_restart) then
          p67 = param(67)
@@ -2895,3 +3133,287 @@ c-----------------------------------------------------------------------
       return
       end
 c-----------------------------------------------------------------------
+      subroutine mfi_int(iofldsr,pm1,ifile)
+
+c     Read a restart file written on a different mesh (restart option
+c     INT, implied if the number of elements differs).  The old
+c     elements eg are read to ranks (eg-1)*np/nelgr and mapped to lx1
+c     points, and a findpts handle is set up on the old geometry.  The
+c     GLL points of this mesh are then located and evaluated in batches
+c     of lbe elements.  Points just outside the old mesh get the value
+c     at the nearest point of its boundary; points not found at all
+c     keep their initial values.
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+
+      real pm1(lx1*ly1*lz1,lelv)
+
+      parameter (lxyz=lx1*ly1*lz1,lfo=10)
+      common /vrthov/ wo(lxyz*lelt,lfo)      ! old geometry and fields
+
+      parameter (lbe=(lelt+7)/8,lbat=lxyz*lbe)
+      common /scrns/ fb(lbat,lfo),rst(ldim*lbat),dist(lbat)
+     $             , icode(lbat),iproc(lbat),iel(lbat)
+
+      common /nekmpi/ nidd,npp,nekcomm,nekgroup,nekreal
+
+      integer e0
+      integer*8 offs0,offs,stride,strideB,nxyzr8,i8
+
+      if (.not.ifgetxr .or. izipr.ne.0) then
+         if (nio.eq.0) write(6,*) 'ABORT: mfi_int needs uncompressed',
+     $                            ' restart data with coordinates'
+         call exitt
+      endif
+
+      i8   = nelgr
+      ieo  = (nid*i8+np-1)/np                ! old elements ieo+1,...
+      nelo = ((nid+1)*i8+np-1)/np - ieo
+      call lim_chk(nelo,lelt,'nelo ','lelt ','mfi_int   ')
+
+      nc = ndim
+      if (ifgetur.and.ifgetu) nc = nc+ndim
+      if (ifgetpr.and.ifgetp) nc = nc+1
+      if (ifgettr.and.ifgett) nc = nc+1
+      do k=1,ldimt-1
+         if (ifgtpsr(k).and.ifgtps(k)) nc = nc+1
+      enddo
+      call lim_chk(nc,lfo,'nfld ','lfo  ','mfi_int   ')
+
+      offs0   = iHeadersize + 4 + isize*nelfr
+      nxyzr8  = nxr*nyr*nzr
+      strideB = nelBr* nxyzr8*wdsizr
+      stride  = nelfr* nxyzr8*wdsizr
+
+      call mfi_seek(offs0 + ndim*strideB)
+      call mfi_int_get(wo,ndim,ieo,nelo)
+      iofldsr = ndim
+      j       = ndim+1
+
+      if (ifgetur) then
+         if (ifgetu) then
+            offs = offs0 + iofldsr*stride + ndim*strideB
+            call mfi_seek(offs)
+            call mfi_int_get(wo(1,j),ndim,ieo,nelo)
+            j = j+ndim
+         endif
+         iofldsr = iofldsr + ndim
+      endif
+      if (ifgetpr) then
+         if (ifgetp) then
+            offs = offs0 + iofldsr*stride + strideB
+            call mfi_seek(offs)
+            call mfi_int_get(wo(1,j),1,ieo,nelo)
+            j = j+1
+         endif
+         iofldsr = iofldsr + 1
+      endif
+      if (ifgettr) then
+         if (ifgett) then
+            offs = offs0 + iofldsr*stride + strideB
+            call mfi_seek(offs)
+            call mfi_int_get(wo(1,j),1,ieo,nelo)
+            j = j+1
+         endif
+         iofldsr = iofldsr + 1
+      endif
+      do k=1,ldimt-1
+         if (ifgtpsr(k)) then
+            if (ifgtps(k)) then
+               offs = offs0 + iofldsr*stride + strideB
+               call mfi_seek(offs)
+               call mfi_int_get(wo(1,j),1,ieo,nelo)
+               j = j+1
+            endif
+            iofldsr = iofldsr + 1
+         endif
+      enddo
+
+      tol  = 1e-13
+      bb_t = 0.1
+      n    = lxyz*lelt
+      call set_findpts_cache
+      call findpts_setup(ih,nekcomm,np,ndim,
+     $                   wo(1,1),wo(1,2),wo(1,ndim),nx1,ny1,nz1,
+     $                   nelo,2*nx1,2*ny1,2*nz1,bb_t,n,n,256,tol)
+
+      nfld = nc-ndim
+      nb   = iglmax((nelt+lbe-1)/lbe,1)      ! findpts is collective
+      nout = 0
+      do ib=1,nb
+         e0 = (ib-1)*lbe+1
+         ne = max(0,min(lbe,nelt-e0+1))
+         e0 = min(e0,lelt)
+         n  = ne*lxyz
+         call findpts(ih,icode,1,iproc,1,iel,1,rst,ndim,dist,1,
+     $                xm1(1,1,1,e0),1,ym1(1,1,1,e0),1,
+     $                zm1(1,1,1,e0),1,n)
+         do i=1,n
+            if (icode(i).eq.2) nout = nout+1
+         enddo
+         call findpts_eval_n(ih,fb,1,lbat,icode,1,iproc,1,iel,1,
+     $                       rst,ndim,n,nfld,wo(1,ndim+1),lxyz*lelt)
+
+         j = 1
+         if (ifgetur.and.ifgetu) then
+            if (ifmhd.and.ifile.eq.2) then
+               call mfi_int_put(bx,nelv,fb(1,j  ),icode,e0,ne)
+               call mfi_int_put(by,nelv,fb(1,j+1),icode,e0,ne)
+               if (if3d)
+     $         call mfi_int_put(bz,nelv,fb(1,j+2),icode,e0,ne)
+            else
+               call mfi_int_put(vx,nelv,fb(1,j  ),icode,e0,ne)
+               call mfi_int_put(vy,nelv,fb(1,j+1),icode,e0,ne)
+               if (if3d)
+     $         call mfi_int_put(vz,nelv,fb(1,j+2),icode,e0,ne)
+            endif
+            j = j+ndim
+         endif
+         if (ifgetpr.and.ifgetp) then
+            call mfi_int_put(pm1,nelv,fb(1,j),icode,e0,ne)
+            j = j+1
+         endif
+         if (ifgettr.and.ifgett) then
+            call mfi_int_put(t,nelt,fb(1,j),icode,e0,ne)
+            j = j+1
+         endif
+         do k=1,ldimt-1
+            if (ifgtpsr(k).and.ifgtps(k)) then
+               call mfi_int_put(t(1,1,1,1,k+1),nelt,fb(1,j),icode,e0,ne)
+               j = j+1
+            endif
+         enddo
+      enddo
+      call findpts_free(ih)
+
+      nout = iglsum(nout,1)
+      if (nio.eq.0) write(6,1) nelgr,nxr,nout
+    1 format(' mfi_int: interpolated from',i9,' elements, N=',i3,
+     $       ',',i9,' points not found')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_int_get(u,nc,ieo,nelo)
+
+c     Read nc components of a field from the current position of the
+c     readers into u(:,e,1..nc), e = eg-ieo, for the old elements eg
+c     of this rank (see mfi_int)
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real u(1)
+
+      parameter (lwk=7*lx1*ly1*lz1*lelt)
+      common /scrns/ wk(lwk)
+
+      nw4  = nc*nxr*nyr*nzr*wdsizr/4         ! 4-byte words per element
+      mw   = (4*nw4+wdsize-1)/wdsize          ! reals per record
+      mrec = lwk/(2*mw+1)
+      call lim_chk(nelo,mrec,'nelo ','mrec ','mfi_int_ge')
+
+      call mfi_int_xfer(u,nc,ieo,wk,wk(1+mw*mrec),wk(1+2*mw*mrec)
+     $                 ,mw,mw*wdsize/4,nw4,mrec)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_int_xfer(u,nc,ieo,vr,r4,vi,mw,lw4,nw4,mrec)
+
+c     mfi_int_get: read rounds of mrec elements into r4 and send them
+c     as records vr(:,i), vi(:,i) = (proc,eg) to their new owners
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real u(lx1*ly1*lz1,lelt,nc)
+      real*4 vr(lw4,mrec),r4(nw4,mrec)
+      integer vi(2,mrec),e,eg,c
+      integer*8 vl,i8
+
+      nxyzr = nxr*nyr*nzr
+      i8    = np
+      nread = iglmax((nelr+mrec-1)/mrec,1)   ! the transfer is collective
+
+      ierr = 0
+      k    = 0
+      do i=1,nread
+         nelrr = max(0,min(mrec,nelr-k))
+         if (ierr.eq.0) then
+#ifdef MPIIO
+            call byte_read_mpi(r4,nw4*nelrr,-1,ifh_mbyte,ierr)
+#else
+            call byte_read (r4,nw4*nelrr,ierr)
+#endif
+         endif
+         do j=1,nelrr
+            eg      = er(k+j)
+            vi(1,j) = ((eg-1)*i8)/nelgr
+            vi(2,j) = eg
+            do l=1,nw4
+               vr(l,j) = r4(l,j)
+            enddo
+         enddo
+         k = k+nelrr
+
+         n = nelrr
+         call crystal_tuple_transfer(cr_h,n,mrec,vi,2,vl,0,vr,mw,1)
+
+         do j=1,n
+            e = vi(2,j)-ieo
+            if (if_byte_sw) then
+               if (wdsizr.eq.8) then
+                  call byte_reverse8(vr(1,j),nw4,ierr)
+               else
+                  call byte_reverse (vr(1,j),nw4,ierr)
+               endif
+            endif
+            l = 1
+            do c=1,nc
+               if (nxr.eq.nx1.and.nyr.eq.ny1.and.nzr.eq.nz1) then
+                  if (wdsizr.eq.4) then
+                     call copy4r(u(1,e,c),vr(l,j),nxyzr)
+                  else
+                     call copy  (u(1,e,c),vr(l,j),nxyzr)
+                  endif
+               else
+                  if (wdsizr.eq.4) then
+                     call mapab4r(u(1,e,c),vr(l,j),nxr,1)
+                  else
+                     call mapab  (u(1,e,c),vr(l,j),nxr,1)
+                  endif
+               endif
+               l = l + nxyzr*wdsizr/4
+            enddo
+         enddo
+      enddo
+
+      call err_chk(ierr,'Error reading restart data, in mfi_int.$')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfi_int_put(u,nel,f,icode,e0,ne)
+
+c     u(:,e0+e-1) = f(:,e), e=1,...,ne, at the points found by findpts;
+c     u has nel elements
+
+      include 'SIZE'
+
+      real u(lx1*ly1*lz1,1),f(lx1*ly1*lz1,1)
+      integer icode(lx1*ly1*lz1,1),e0,e
+
+      do e=1,min(ne,nel-e0+1)
+         do i=1,lx1*ly1*lz1
+            if (icode(i,e).ne.2) u(i,e0+e-1) = f(i,e)
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
@@ -1522,14 +1522,17 @@ C
       include 'INPUT'
       include 'GEOM'
       include 'TSTEP' ! for istep
+      include 'PARALLEL'
 
       common /dealias1/ zd(lxd),wd(lxd)
       integer e
 
-      integer ilstep
-      save    ilstep
-      data    ilstep /-1/
+      integer ilstep,ilrbal
+      save    ilstep,ilrbal
+      data    ilstep,ilrbal /-1,0/
 
+      if (nrebal.ne.ilrbal) ilstep = -1        ! elements have moved
+      ilrbal = nrebal
       if (.not.ifgeom.and.ilstep.gt.1) return  ! already computed
       if (ifgeom.and.ilstep.eq.istep)  return  ! already computed
       ilstep = istep
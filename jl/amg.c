@@ -20,6 +20,7 @@
 #define crs_solve PREFIXED_NAME(crs_solve)
 #define crs_stats PREFIXED_NAME(crs_stats)
 #define crs_free  PREFIXED_NAME(crs_free )
+#define crs_cache PREFIXED_NAME(crs_cache)
 
 #ifndef AMG_BLOCK_ROWS
 #  define AMG_BLOCK_ROWS 1200
@@ -585,6 +586,11 @@ void crs_free(struct crs_data *data)
   free(data);
 }
 
+/* the AMG setup is already read from files (see amg_setup_aux) */
+void crs_cache(const char *prefix)
+{
+}
+
 /*==========================================================================
 
   Find ID
@@ -9,6 +9,7 @@
 #define crs_solve PREFIXED_NAME(crs_solve)
 #define crs_stats PREFIXED_NAME(crs_stats)
 #define crs_free  PREFIXED_NAME(crs_free )
+#define crs_cache PREFIXED_NAME(crs_cache)
 
 struct crs_data;
 
@@ -20,5 +21,10 @@ void crs_solve(double *x, struct crs_data *data, double *b);
 void crs_stats(struct crs_data *data);
 void crs_free(struct crs_data *data);
 
+/* subsequent setups save their result in, and try to load it from,
+   per-proc files whose names start with the given prefix;
+   an empty prefix turns caching off (the default) */
+void crs_cache(const char *prefix);
+
 #endif
 
@@ -18,15 +18,18 @@
 #undef crs_solve
 #undef crs_stats
 #undef crs_free
+#undef crs_cache
 #define ccrs_setup   PREFIXED_NAME(crs_setup)
 #define ccrs_solve   PREFIXED_NAME(crs_solve)
 #define ccrs_stats   PREFIXED_NAME(crs_stats)
 #define ccrs_free    PREFIXED_NAME(crs_free )
+#define ccrs_cache   PREFIXED_NAME(crs_cache)
 
 #define fcrs_setup   FORTRAN_NAME(crs_setup,CRS_SETUP)
 #define fcrs_solve   FORTRAN_NAME(crs_solve,CRS_SOLVE)
 #define fcrs_stats   FORTRAN_NAME(crs_stats,CRS_STATS)
 #define fcrs_free    FORTRAN_NAME(crs_free ,CRS_FREE)
+#define fcrs_cache   FORTRAN_NAME(crs_cache,CRS_CACHE)
 
 static struct crs_data **handle_array = 0;
 static int handle_max = 0;
@@ -73,4 +76,9 @@ void fcrs_free(sint *handle)
   handle_array[*handle] = 0;
 }
 
+/* prefix must be null terminated (e.g., a zero-filled character buffer) */
+void fcrs_cache(const char *prefix)
+{
+  ccrs_cache(prefix);
+}
 
@@ -1,5 +1,6 @@
 #include <stddef.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <limits.h>
 #include <math.h>
@@ -21,9 +22,6 @@
 /*
 #define DIAGNOSTICS
 */
-#ifdef DIAGNOSTICS
-#include <stdio.h>
-#endif
 
 #define CODE_INTERNAL 0
 #define CODE_BORDER 1
@@ -69,6 +67,55 @@ static uint count_bits(unsigned char *p, uint n)
   return sum;
 }
 
+/*--------------------------------------------------------------------------
+
+  Setup Cache
+
+  once a file name prefix has been given with findpts_cache, findpts_setup
+  looks for the file "<prefix>fpts_<key>.<id>" written by an earlier setup;
+  the key is a hash of the proc count and id, the setup parameters and the
+  element geometry.  the file holds the bounding boxes and the local and
+  global hash tables; since the global table is built collectively, the
+  cache is used only when every proc loads a valid file, otherwise the
+  tables are rebuilt and each proc (re)writes its file
+
+  --------------------------------------------------------------------------*/
+
+#define CACHE_MAGIC   0x46505453u /* "FPTS" */
+#define CACHE_VERSION 1u
+#define CACHE_MAX_NAME 256
+
+static char cache_prefix[CACHE_MAX_NAME] = "";
+
+void PREFIXED_NAME(findpts_cache)(const char *prefix)
+{
+  size_t len = prefix ? strlen(prefix) : 0;
+  if(len>=CACHE_MAX_NAME)
+    fail(1,__FILE__,__LINE__,"findpts_cache: prefix too long");
+  memcpy(cache_prefix,prefix,len), cache_prefix[len]='\0';
+}
+
+/* two independent 32-bit FNV-1a lanes, as for the XXT cache */
+static void hash_bytes(unsigned long h[2], const void *p, size_t n)
+{
+  const unsigned char *c = p;
+  unsigned long h0=h[0], h1=h[1];
+  for(;n;--n,++c) {
+    h0 = ((h0^*c)*0x01000193ul) & 0xfffffffful;
+    h1 = ((h1^*c)*0x01000193ul + 0x9e3779b9ul) & 0xfffffffful;
+  }
+  h[0]=h0, h[1]=h1;
+}
+
+static void cache_name(char *name, const unsigned long key[2], uint id)
+{
+  sprintf(name,"%sfpts_%08lx%08lx.%u",cache_prefix,key[0],key[1],
+          (unsigned)id);
+}
+
+#define CACHE_WRITE(p,n) (fwrite(p,sizeof(*(p)),n,f)!=(size_t)(n))
+#define CACHE_READ(p,n)  (fread (p,sizeof(*(p)),n,f)!=(size_t)(n))
+
 #define D 2
 #define WHEN_3D(a)
 #include "findpts_imp.h"
@@ -81,6 +128,9 @@ static uint count_bits(unsigned char *p, uint n)
 #undef WHEN_3D
 #undef D
 
+#undef CACHE_READ
+#undef CACHE_WRITE
+
 /*--------------------------------------------------------------------------
 
   FORTRAN Interface
@@ -132,6 +182,18 @@ static uint count_bits(unsigned char *p, uint n)
                 or the objective (dist^2) increases while the predicted (model)
                   decrease is smaller than newt_tol * (the objective)
 
+    a setup whose geometry (the same xm,ym,zm arrays, holding the same
+    values) and parameters match those of a live handle on every proc
+    returns that handle; it is then freed by the last matching free
+
+  --------------------------------------------------------------------------
+  call findpts_cache(prefix)
+
+    prefix: null terminated (e.g., a zero-filled character buffer)
+    later setups keep their bounding boxes and hash tables in, and read
+      them back from, per-proc files whose names start with prefix
+      (see "Setup Cache" above); an empty prefix turns this off (default)
+
   --------------------------------------------------------------------------
   call findpts_free(h)
   
@@ -168,6 +230,18 @@ static uint count_bits(unsigned char *p, uint n)
       (consequently, r_stride must be at least ndim)
 
 
+  --------------------------------------------------------------------------
+  call findpts_update(h, ... same arguments as findpts ...)
+
+    like findpts, but code, proc, el, r, dist2 are input as well:
+      the result of an earlier findpts or findpts_update call with h
+      (e.g., before the points moved)
+    a point with code 0 or 1 is first tried in its previous element,
+      then among the other elements of its previous proc;
+      only the points not found inside an element there
+      are searched for again as in findpts
+    previous locations that are out of range are ignored
+
   --------------------------------------------------------------------------
   call findpts_eval(h,  out_base,  out_stride,
                        code_base, code_stride,
@@ -198,19 +272,51 @@ static uint count_bits(unsigned char *p, uint n)
     and does no communication. will use matrix-matrix products if
     points are grouped by element.
 
+
+  --------------------------------------------------------------------------
+  call findpts_eval_n(h,  out_base,  out_stride, out_fld_stride,
+                         code_base, code_stride,
+                         proc_base, proc_stride,
+                           el_base,   el_stride,
+                            r_base,    r_stride, npt,
+                      nfld, input_fields, in_stride)
+
+  call findpts_eval_local_n(h, out_base, out_stride, out_fld_stride,
+                                el_base,   el_stride,
+                                 r_base,    r_stride, npt,
+                            nfld, input_fields, in_stride)
+
+    evaluate nfld fields at once, field k (1..nfld) starting at
+      input_fields(1+in_stride*(k-1)), the value for point i going to
+      out_base(1+out_stride*(i-1)+out_fld_stride*(k-1));
+    the points are sent, and their basis weights computed, only once
+
   --------------------------------------------------------------------------*/
 
 #define ffindpts_setup      FORTRAN_NAME(findpts_setup     ,FINDPTS_SETUP     )
+#define ffindpts_cache      FORTRAN_NAME(findpts_cache     ,FINDPTS_CACHE     )
 #define ffindpts_free       FORTRAN_NAME(findpts_free      ,FINDPTS_FREE      )
 #define ffindpts            FORTRAN_NAME(findpts           ,FINDPTS           )
+#define ffindpts_update     FORTRAN_NAME(findpts_update    ,FINDPTS_UPDATE    )
 #define ffindpts_eval       FORTRAN_NAME(findpts_eval      ,FINDPTS_EVAL      )
 #define ffindpts_eval_local FORTRAN_NAME(findpts_eval_local,FINDPTS_EVAL_LOCAL)
-
-struct handle { void *data; unsigned ndim; };
+#define ffindpts_eval_n     FORTRAN_NAME(findpts_eval_n    ,FINDPTS_EVAL_N    )
+#define ffindpts_eval_local_n \
+  FORTRAN_NAME(findpts_eval_local_n,FINDPTS_EVAL_LOCAL_N)
+
+struct handle {
+  void *data; unsigned ndim, ref;
+  MPI_Fint comm; unsigned long key[2]; const double *x[3];
+};
 static struct handle *handle_array = 0;
 static int handle_max = 0;
 static int handle_n = 0;
 
+void ffindpts_cache(const char *const prefix)
+{
+  PREFIXED_NAME(findpts_cache)(prefix);
+}
+
 void ffindpts_setup(sint *const handle,
   const MPI_Fint *const comm, const sint *const np,
   const sint *ndim,
@@ -224,40 +330,66 @@ void ffindpts_setup(sint *const handle,
   const double *const newt_tol)
 {
   struct handle *h;
+  struct comm c;
+  unsigned long key[2];
+  const double *elx[3];
+  uint n[3], m[3];
+  int i, match[2], buf[2];
+  if(*ndim!=2 && *ndim!=3)
+    fail(1,__FILE__,__LINE__,
+         "findpts_setup: ndim must be 2 or 3; given ndim=%u",(unsigned)*ndim);
+  elx[0]=xm,elx[1]=ym,elx[2]=*ndim==3?zm:0;
+  n[0]=*nr,n[1]=*ns,n[2]=*nt;
+  m[0]=*mr,m[1]=*ms,m[2]=*mt;
+  comm_init_check(&c, *comm, *np);
+  if(*ndim==2)
+    setup_key_2(key,&c,elx,n,*nel,m,*bbox_tol,
+                *loc_hash_size,*gbl_hash_size, *npt_max, *newt_tol);
+  else
+    setup_key_3(key,&c,elx,n,*nel,m,*bbox_tol,
+                *loc_hash_size,*gbl_hash_size, *npt_max, *newt_tol);
+  /* share a live handle when all procs find the same one */
+  match[0]=-1;
+  for(i=0;i<handle_n;++i) {
+    h = &handle_array[i];
+    if(h->data && h->ndim==(unsigned)*ndim && h->comm==*comm
+       && h->key[0]==key[0] && h->key[1]==key[1]
+       && h->x[0]==elx[0] && h->x[1]==elx[1] && h->x[2]==elx[2]) {
+      match[0]=i; break;
+    }
+  }
+  match[1]=-match[0];
+  comm_allreduce(&c,gs_int,gs_max,match,2,buf);
+  if(match[0]>=0 && match[0]==-match[1]) {
+    comm_free(&c);
+    ++handle_array[match[0]].ref;
+    *handle = match[0];
+    return;
+  }
   if(handle_n==handle_max)
     handle_max+=handle_max/2+1,
     handle_array=trealloc(struct handle,handle_array,handle_max);
   h = &handle_array[handle_n];
-  h->ndim = *ndim;
+  h->ndim = *ndim, h->ref = 1, h->comm = *comm;
+  h->key[0]=key[0], h->key[1]=key[1];
+  for(i=0;i<3;++i) h->x[i]=elx[i];
   if(h->ndim==2) {
     struct findpts_data_2 *const fd = tmalloc(struct findpts_data_2,1);
-    const double *elx[2];
-    uint n[2], m[2];
-    elx[0]=xm,elx[1]=ym;
-    n[0]=*nr,n[1]=*ns;
-    m[0]=*mr,m[1]=*ms;
     h->data = fd;
-    comm_init_check(&fd->cr.comm, *comm, *np);
+    fd->cr.comm = c;
     buffer_init(&fd->cr.data,1000);
     buffer_init(&fd->cr.work,1000);
-    setup_aux_2(fd, elx,n,*nel,m,*bbox_tol,
+    setup_aux_2(fd, key, elx,n,*nel,m,*bbox_tol,
                 *loc_hash_size,*gbl_hash_size, *npt_max, *newt_tol);
-  } else if(h->ndim==3) {
+  } else {
     struct findpts_data_3 *const fd = tmalloc(struct findpts_data_3,1);
-    const double *elx[3];
-    uint n[3], m[3];
-    elx[0]=xm,elx[1]=ym,elx[2]=zm;
-    n[0]=*nr,n[1]=*ns,n[2]=*nt;
-    m[0]=*mr,m[1]=*ms,m[2]=*mt;
     h->data = fd;
-    comm_init_check(&fd->cr.comm, *comm, *np);
+    fd->cr.comm = c;
     buffer_init(&fd->cr.data,1000);
     buffer_init(&fd->cr.work,1000);
-    setup_aux_3(fd, elx,n,*nel,m,*bbox_tol,
+    setup_aux_3(fd, key, elx,n,*nel,m,*bbox_tol,
                 *loc_hash_size,*gbl_hash_size, *npt_max, *newt_tol);
-  } else
-    fail(1,__FILE__,__LINE__,
-         "findpts_setup: ndim must be 2 or 3; given ndim=%u",(unsigned)h->ndim);
+  }
   *handle = handle_n++;
 }
 
@@ -269,6 +401,7 @@ void ffindpts_setup(sint *const handle,
 void ffindpts_free(const sint *const handle)
 {
   CHECK_HANDLE("findpts_free");
+  if(--h->ref) return;
   if(h->ndim==2)
     PREFIXED_NAME(findpts_free_2)(h->data);
   else
@@ -320,6 +453,50 @@ void ffindpts(const sint *const handle,
   }
 }
 
+void ffindpts_update(const sint *const handle,
+          sint *const  code_base, const sint *const  code_stride,
+          sint *const  proc_base, const sint *const  proc_stride,
+          sint *const    el_base, const sint *const    el_stride,
+        double *const     r_base, const sint *const     r_stride,
+        double *const dist2_base, const sint *const dist2_stride,
+  const double *const     x_base, const sint *const     x_stride,
+  const double *const     y_base, const sint *const     y_stride,
+  const double *const     z_base, const sint *const     z_stride,
+  const sint *const npt)
+{
+  CHECK_HANDLE("findpts_update");
+  if(h->ndim==2) {
+    const double *xv_base[2];
+    unsigned xv_stride[2];
+    xv_base[0]=x_base, xv_base[1]=y_base;
+    xv_stride[0] = *x_stride*sizeof(double),
+    xv_stride[1] = *y_stride*sizeof(double);
+    PREFIXED_NAME(findpts_update_2)(
+      (uint*)code_base,(* code_stride)*sizeof(sint  ),
+      (uint*)proc_base,(* proc_stride)*sizeof(sint  ),
+      (uint*)  el_base,(*   el_stride)*sizeof(sint  ),
+                r_base,(*    r_stride)*sizeof(double),
+            dist2_base,(*dist2_stride)*sizeof(double),
+               xv_base,     xv_stride,
+      *npt, h->data);
+  } else {
+    const double *xv_base[3];
+    unsigned xv_stride[3];
+    xv_base[0]=x_base, xv_base[1]=y_base, xv_base[2]=z_base;
+    xv_stride[0] = *x_stride*sizeof(double),
+    xv_stride[1] = *y_stride*sizeof(double),
+    xv_stride[2] = *z_stride*sizeof(double);
+    PREFIXED_NAME(findpts_update_3)(
+      (uint*)code_base,(* code_stride)*sizeof(sint  ),
+      (uint*)proc_base,(* proc_stride)*sizeof(sint  ),
+      (uint*)  el_base,(*   el_stride)*sizeof(sint  ),
+                r_base,(*    r_stride)*sizeof(double),
+            dist2_base,(*dist2_stride)*sizeof(double),
+               xv_base,     xv_stride,
+      *npt, h->data);
+  }
+}
+
 void ffindpts_eval(const sint *const handle,
         double *const  out_base, const sint *const  out_stride,
   const   sint *const code_base, const sint *const code_stride,
@@ -367,3 +544,61 @@ void ffindpts_eval_local(const sint *const handle,
                 r_base,(*   r_stride)*sizeof(double),
       *npt, in, &((struct findpts_data_3 *)h->data)->local);
 }
+
+void ffindpts_eval_n(const sint *const handle,
+        double *const  out_base, const sint *const  out_stride,
+                                 const sint *const  out_fld_stride,
+  const   sint *const code_base, const sint *const code_stride,
+  const   sint *const proc_base, const sint *const proc_stride,
+  const   sint *const   el_base, const sint *const   el_stride,
+  const double *const    r_base, const sint *const    r_stride,
+  const sint *const npt,
+  const sint *const nfld, const double *const in, const sint *const in_stride)
+{
+  CHECK_HANDLE("findpts_eval_n");
+  if(h->ndim==2)
+    PREFIXED_NAME(findpts_eval_n_2)(
+              out_base,(* out_stride)*sizeof(double),
+                       (*out_fld_stride)*sizeof(double),
+      (uint*)code_base,(*code_stride)*sizeof(sint  ),
+      (uint*)proc_base,(*proc_stride)*sizeof(sint  ),
+      (uint*)  el_base,(*  el_stride)*sizeof(sint  ),
+                r_base,(*   r_stride)*sizeof(double),
+      *npt, in,*in_stride,*nfld, h->data);
+  else
+    PREFIXED_NAME(findpts_eval_n_3)(
+              out_base,(* out_stride)*sizeof(double),
+                       (*out_fld_stride)*sizeof(double),
+      (uint*)code_base,(*code_stride)*sizeof(sint  ),
+      (uint*)proc_base,(*proc_stride)*sizeof(sint  ),
+      (uint*)  el_base,(*  el_stride)*sizeof(sint  ),
+                r_base,(*   r_stride)*sizeof(double),
+      *npt, in,*in_stride,*nfld, h->data);
+}
+
+void ffindpts_eval_local_n(const sint *const handle,
+        double *const  out_base, const sint *const  out_stride,
+                                 const sint *const  out_fld_stride,
+  const   sint *const   el_base, const sint *const   el_stride,
+  const double *const    r_base, const sint *const    r_stride,
+  const sint *const npt,
+  const sint *const nfld, const double *const in, const sint *const in_stride)
+{
+  CHECK_HANDLE("findpts_eval_local_n");
+  if(h->ndim==2)
+    findpts_local_eval_n_2(
+              out_base,(* out_stride)*sizeof(double),
+                       (*out_fld_stride)*sizeof(double),
+      (uint*)  el_base,(*  el_stride)*sizeof(sint  ),
+                r_base,(*   r_stride)*sizeof(double),
+      *npt, in,*in_stride,*nfld,
+      &((struct findpts_data_2 *)h->data)->local);
+  else
+    findpts_local_eval_n_3(
+              out_base,(* out_stride)*sizeof(double),
+                       (*out_fld_stride)*sizeof(double),
+      (uint*)  el_base,(*  el_stride)*sizeof(sint  ),
+                r_base,(*   r_stride)*sizeof(double),
+      *npt, in,*in_stride,*nfld,
+      &((struct findpts_data_3 *)h->data)->local);
+}
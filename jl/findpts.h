@@ -9,10 +9,15 @@
 #define findpts_free_2    PREFIXED_NAME(findpts_free_2 )
 #define findpts_2         PREFIXED_NAME(findpts_2      )
 #define findpts_eval_2    PREFIXED_NAME(findpts_eval_2 )
+#define findpts_eval_n_2  PREFIXED_NAME(findpts_eval_n_2)
+#define findpts_update_2  PREFIXED_NAME(findpts_update_2)
 #define findpts_setup_3   PREFIXED_NAME(findpts_setup_3)
 #define findpts_free_3    PREFIXED_NAME(findpts_free_3 )
 #define findpts_3         PREFIXED_NAME(findpts_3      )
 #define findpts_eval_3    PREFIXED_NAME(findpts_eval_3 )
+#define findpts_eval_n_3  PREFIXED_NAME(findpts_eval_n_3)
+#define findpts_update_3  PREFIXED_NAME(findpts_update_3)
+#define findpts_cache     PREFIXED_NAME(findpts_cache  )
 
 struct findpts_data_2;
 struct findpts_data_3;
@@ -33,6 +38,11 @@ struct findpts_data_3 *findpts_setup_3(
   const uint local_hash_size, const uint global_hash_size,
   const unsigned npt_max, const double newt_tol);
 
+/* subsequent setups save their hash tables in, and try to load them from,
+   per-proc files whose names start with the given prefix;
+   an empty prefix turns caching off (the default) */
+void findpts_cache(const char *prefix);
+
 void findpts_free_2(struct findpts_data_2 *fd);
 void findpts_free_3(struct findpts_data_3 *fd);
 
@@ -52,6 +62,24 @@ void findpts_3(    uint   *const  code_base   , const unsigned  code_stride   ,
              const double *const     x_base[3], const unsigned     x_stride[3],
              const uint npt, struct findpts_data_3 *const fd);
 
+void findpts_update_2(
+                   uint   *const  code_base   , const unsigned  code_stride   ,
+                   uint   *const  proc_base   , const unsigned  proc_stride   ,
+                   uint   *const    el_base   , const unsigned    el_stride   ,
+                   double *const     r_base   , const unsigned     r_stride   ,
+                   double *const dist2_base   , const unsigned dist2_stride   ,
+             const double *const     x_base[2], const unsigned     x_stride[2],
+             const uint npt, struct findpts_data_2 *const fd);
+
+void findpts_update_3(
+                   uint   *const  code_base   , const unsigned  code_stride   ,
+                   uint   *const  proc_base   , const unsigned  proc_stride   ,
+                   uint   *const    el_base   , const unsigned    el_stride   ,
+                   double *const     r_base   , const unsigned     r_stride   ,
+                   double *const dist2_base   , const unsigned dist2_stride   ,
+             const double *const     x_base[3], const unsigned     x_stride[3],
+             const uint npt, struct findpts_data_3 *const fd);
+
 void findpts_eval_2(
         double *const  out_base, const unsigned  out_stride,
   const uint   *const code_base, const unsigned code_stride,
@@ -60,6 +88,17 @@ void findpts_eval_2(
   const double *const    r_base, const unsigned    r_stride,
   const uint npt,
   const double *const in, struct findpts_data_2 *const fd);
+
+void findpts_eval_n_2(
+        double *const  out_base, const unsigned  out_stride,
+                                 const unsigned  out_fld_stride,
+  const uint   *const code_base, const unsigned code_stride,
+  const uint   *const proc_base, const unsigned proc_stride,
+  const uint   *const   el_base, const unsigned   el_stride,
+  const double *const    r_base, const unsigned    r_stride,
+  const uint npt,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_data_2 *const fd);
  
 void findpts_eval_3(
         double *const  out_base, const unsigned  out_stride,
@@ -70,4 +109,15 @@ void findpts_eval_3(
   const uint npt,
   const double *const in, struct findpts_data_3 *const fd);
 
+void findpts_eval_n_3(
+        double *const  out_base, const unsigned  out_stride,
+                                 const unsigned  out_fld_stride,
+  const uint   *const code_base, const unsigned code_stride,
+  const uint   *const proc_base, const unsigned proc_stride,
+  const uint   *const   el_base, const unsigned   el_stride,
+  const double *const    r_base, const unsigned    r_stride,
+  const uint npt,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_data_3 *const fd);
+
 #endif
@@ -9,6 +9,7 @@
 #define findpts_el_free_2    PREFIXED_NAME(findpts_el_free_2 )
 #define findpts_el_2         PREFIXED_NAME(findpts_el_2      )
 #define findpts_el_eval_2    PREFIXED_NAME(findpts_el_eval_2 )
+#define findpts_el_eval_n_2  PREFIXED_NAME(findpts_el_eval_n_2)
 
 struct findpts_el_pt_2 {
   double x[2],r[2],oldr[2],dist2,dist2p,tr;
@@ -47,6 +48,12 @@ void findpts_el_eval_2(
         double *const out_base, const unsigned out_stride,
   const double *const   r_base, const unsigned   r_stride, const unsigned pn,
   const double *const in, struct findpts_el_data_2 *const fd);
+void findpts_el_eval_n_2(
+        double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
+  const double *const   r_base, const unsigned   r_stride, const unsigned pn,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_el_data_2 *const fd);
 
 static void findpts_el_start_2(struct findpts_el_data_2 *const fd,
                                const double *const x[2])
@@ -64,6 +71,7 @@ static struct findpts_el_pt_2 *findpts_el_points_2(
 #define findpts_el_free_3    PREFIXED_NAME(findpts_el_free_3 )
 #define findpts_el_3         PREFIXED_NAME(findpts_el_3      )
 #define findpts_el_eval_3    PREFIXED_NAME(findpts_el_eval_3 )
+#define findpts_el_eval_n_3  PREFIXED_NAME(findpts_el_eval_n_3)
 
 struct findpts_el_pt_3 {
   double x[3],r[3],oldr[3],dist2,dist2p,tr;
@@ -106,6 +114,12 @@ void findpts_el_eval_3(
         double *const out_base, const unsigned out_stride,
   const double *const   r_base, const unsigned   r_stride, const unsigned pn,
   const double *const in, struct findpts_el_data_3 *const fd);
+void findpts_el_eval_n_3(
+        double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
+  const double *const   r_base, const unsigned   r_stride, const unsigned pn,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_el_data_3 *const fd);
 
 static void findpts_el_start_3(struct findpts_el_data_3 *const fd,
                                const double *const x[3])
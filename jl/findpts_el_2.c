@@ -17,6 +17,7 @@
 #define findpts_el_free_2    PREFIXED_NAME(findpts_el_free_2 )
 #define findpts_el_2         PREFIXED_NAME(findpts_el_2      )
 #define findpts_el_eval_2    PREFIXED_NAME(findpts_el_eval_2 )
+#define findpts_el_eval_n_2  PREFIXED_NAME(findpts_el_eval_n_2)
 /*
 #define DIAGNOSTICS_1
 #define DIAGNOSTICS_2
@@ -334,7 +335,15 @@ static int reject_prior_step_q(struct findpts_el_pt_2 *const out,
     out->r[0]=p->oldr[0],out->r[1]=p->oldr[1];
     out->flags=p->flags>>5;
     out->dist2p=-DBL_MAX;
-    if(pred < dist2*tol) out->flags|=CONVERGED_FLAG;
+    if(pred < dist2*tol) {
+      /* stalled: keep the faces the restored r lies on as constraints,
+         else a point outside the element is reported as inside */
+      unsigned d;
+      for(d=0;d<2;++d)
+        if(out->r[d]==-1) out->flags|=1u<<(2*d);
+        else if(out->r[d]==1) out->flags|=2u<<(2*d);
+      out->flags|=CONVERGED_FLAG;
+    }
     return 1;
   }
 }
@@ -795,25 +804,40 @@ void findpts_el_2(struct findpts_el_data_2 *const fd, const unsigned npt,
 #endif
 }
 
-void findpts_el_eval_2(
+/* evaluate nfld fields, in + k*in_stride for field k, at pn points;
+   the basis weights are computed once per point */
+void findpts_el_eval_n_2(
         double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
   const double *const   r_base, const unsigned   r_stride, const unsigned pn,
-  const double *const in, struct findpts_el_data_2 *const fd)
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_el_data_2 *const fd)
 {
   const unsigned nr=fd->n[0],ns=fd->n[1];
   double *const wtr = fd->work, *const wts = wtr+nr*pn,
          *const slice = wts+ns*pn;
-  unsigned i; const double *r; double *out;
+  unsigned i,k; const double *r, *in_k; double *out, *out_k;
   for(i=0,r=r_base;i<pn;++i) {
     fd->lag[0](wtr+i*nr, fd->lag_data[0], nr, 0, r[0]);
     fd->lag[1](wts+i*ns, fd->lag_data[1], ns, 0, r[1]);
     r = (const double*)((const char*)r + r_stride);
   }
   
-  tensor_mxm(slice,nr, in,ns, wts,pn);
-  for(i=0,out=out_base;i<pn;++i) {
-    const double *const wtr_i = wtr+i*nr, *const slice_i = slice+i*nr;
-    *out = tensor_i1(wtr_i,nr, slice_i);
-    out = (double*)((char*)out + out_stride);
+  for(k=0,in_k=in,out_k=out_base;k<nfld;++k) {
+    tensor_mxm(slice,nr, in_k,ns, wts,pn);
+    for(i=0,out=out_k;i<pn;++i) {
+      const double *const wtr_i = wtr+i*nr, *const slice_i = slice+i*nr;
+      *out = tensor_i1(wtr_i,nr, slice_i);
+      out = (double*)((char*)out + out_stride);
+    }
+    in_k += in_stride, out_k = (double*)((char*)out_k + out_fld_stride);
   }
 }
+
+void findpts_el_eval_2(
+        double *const out_base, const unsigned out_stride,
+  const double *const   r_base, const unsigned   r_stride, const unsigned pn,
+  const double *const in, struct findpts_el_data_2 *const fd)
+{
+  findpts_el_eval_n_2(out_base,out_stride,0, r_base,r_stride,pn, in,0,1, fd);
+}
@@ -15,6 +15,7 @@
 #define findpts_el_free_3    PREFIXED_NAME(findpts_el_free_3 )
 #define findpts_el_3         PREFIXED_NAME(findpts_el_3      )
 #define findpts_el_eval_3    PREFIXED_NAME(findpts_el_eval_3 )
+#define findpts_el_eval_n_3  PREFIXED_NAME(findpts_el_eval_n_3)
 /*
 #define DIAGNOSTICS_1
 #define DIAGNOSTICS_2
@@ -524,7 +525,15 @@ static int reject_prior_step_q(struct findpts_el_pt_3 *const out,
     out->r[0]=p->oldr[0],out->r[1]=p->oldr[1],out->r[2]=p->oldr[2];
     out->flags=p->flags>>7;
     out->dist2p=-DBL_MAX;
-    if(pred < dist2*tol) out->flags|=CONVERGED_FLAG;
+    if(pred < dist2*tol) {
+      /* stalled: keep the faces the restored r lies on as constraints,
+         else a point outside the element is reported as inside */
+      unsigned d;
+      for(d=0;d<3;++d)
+        if(out->r[d]==-1) out->flags|=1u<<(2*d);
+        else if(out->r[d]==1) out->flags|=2u<<(2*d);
+      out->flags|=CONVERGED_FLAG;
+    }
     return 1;
   }
 }
@@ -1291,16 +1300,20 @@ void findpts_el_3(struct findpts_el_data_3 *const fd, const unsigned npt,
 #endif
 }
 
-void findpts_el_eval_3(
+/* evaluate nfld fields, in + k*in_stride for field k, at pn points;
+   the basis weights are computed once per point */
+void findpts_el_eval_n_3(
         double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
   const double *const   r_base, const unsigned   r_stride, const unsigned pn,
-  const double *const in, struct findpts_el_data_3 *const fd)
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_el_data_3 *const fd)
 {
   const unsigned nr=fd->n[0],ns=fd->n[1],nt=fd->n[2],
                  nrs=nr*ns;
   double *const wtrs = fd->work, *const wtt = wtrs+(nr+ns)*pn,
          *const slice = wtt+nt*pn, *const temp = slice + pn*nrs;
-  unsigned i; const double *r; double *out;
+  unsigned i,k; const double *r, *in_k; double *out, *out_k;
   for(i=0,r=r_base;i<pn;++i) {
     fd->lag[0](wtrs+i*(nr+ns)   , fd->lag_data[0], nr, 0, r[0]);
     fd->lag[1](wtrs+i*(nr+ns)+nr, fd->lag_data[1], ns, 0, r[1]);
@@ -1308,11 +1321,23 @@ void findpts_el_eval_3(
     r = (const double*)((const char*)r + r_stride);
   }
   
-  tensor_mxm(slice,nrs, in,nt, wtt,pn);
-  for(i=0,out=out_base;i<pn;++i) {
-    const double *const wtrs_i = wtrs+i*(nr+ns), *const slice_i = slice+i*nrs;
-    *out = tensor_i2(wtrs_i,nr, wtrs_i+nr,ns, slice_i, temp);
-    out = (double*)((char*)out + out_stride);
+  for(k=0,in_k=in,out_k=out_base;k<nfld;++k) {
+    tensor_mxm(slice,nrs, in_k,nt, wtt,pn);
+    for(i=0,out=out_k;i<pn;++i) {
+      const double *const wtrs_i = wtrs+i*(nr+ns),
+                   *const slice_i = slice+i*nrs;
+      *out = tensor_i2(wtrs_i,nr, wtrs_i+nr,ns, slice_i, temp);
+      out = (double*)((char*)out + out_stride);
+    }
+    in_k += in_stride, out_k = (double*)((char*)out_k + out_fld_stride);
   }
 }
 
+void findpts_el_eval_3(
+        double *const out_base, const unsigned out_stride,
+  const double *const   r_base, const unsigned   r_stride, const unsigned pn,
+  const double *const in, struct findpts_el_data_3 *const fd)
+{
+  findpts_el_eval_n_3(out_base,out_stride,0, r_base,r_stride,pn, in,0,1, fd);
+}
+
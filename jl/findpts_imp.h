@@ -16,17 +16,28 @@
 #define findpts_local_setup TOKEN_PASTE(PREFIXED_NAME(findpts_local_setup_),D)
 #define findpts_local_free  TOKEN_PASTE(PREFIXED_NAME(findpts_local_free_ ),D)
 #define findpts_local       TOKEN_PASTE(PREFIXED_NAME(findpts_local_      ),D)
+#define findpts_local_el    TOKEN_PASTE(PREFIXED_NAME(findpts_local_el_   ),D)
 #define findpts_local_eval  TOKEN_PASTE(PREFIXED_NAME(findpts_local_eval_ ),D)
+#define findpts_local_eval_n TOKEN_PASTE(PREFIXED_NAME(findpts_local_eval_n_),D)
 #define findpts_data        TOKEN_PASTE(findpts_data_,D)
 #define src_pt              TOKEN_PASTE(src_pt_      ,D)
 #define out_pt              TOKEN_PASTE(out_pt_      ,D)
 #define eval_src_pt         TOKEN_PASTE(eval_src_pt_ ,D)
 #define eval_out_pt         TOKEN_PASTE(eval_out_pt_ ,D)
+#define eval_outn_pt        TOKEN_PASTE(eval_outn_pt_,D)
+#define upd_pt              TOKEN_PASTE(upd_pt_      ,D)
+#define upd_miss            TOKEN_PASTE(upd_miss_    ,D)
 #define setup_aux           TOKEN_PASTE(setup_aux_,D)
+#define setup_key           TOKEN_PASTE(setup_key_,D)
+#define cache_write         TOKEN_PASTE(cache_write_,D)
+#define cache_read          TOKEN_PASTE(cache_read_,D)
+#define findpts_el_setup    TOKEN_PASTE(PREFIXED_NAME(findpts_el_setup_),D)
 #define findpts_setup       TOKEN_PASTE(PREFIXED_NAME(findpts_setup_),D)
 #define findpts_free        TOKEN_PASTE(PREFIXED_NAME(findpts_free_ ),D)
 #define findpts             TOKEN_PASTE(PREFIXED_NAME(findpts_      ),D)
 #define findpts_eval        TOKEN_PASTE(PREFIXED_NAME(findpts_eval_ ),D)
+#define findpts_eval_n      TOKEN_PASTE(PREFIXED_NAME(findpts_eval_n_),D)
+#define findpts_update      TOKEN_PASTE(PREFIXED_NAME(findpts_update_),D)
 
 struct hash_data {
   ulong hash_n;
@@ -202,18 +213,131 @@ struct findpts_data {
   struct hash_data hash;
 };
 
+/* setup cache (see findpts_cache): the key hashes the proc count and id,
+   the setup parameters and the element geometry; the file holds the
+   bounding boxes and the local and global hash tables */
+
+static void setup_key(
+  unsigned long key[2], const struct comm *const comm,
+  const double *const elx[D],
+  const unsigned n[D], const uint nel,
+  const unsigned m[D], const double bbox_tol,
+  const uint local_hash_size, const uint global_hash_size,
+  const unsigned npt_max, const double newt_tol)
+{
+  uint head[6+2*D];
+  const double tol[2] = { bbox_tol, newt_tol };
+  uint ntot=nel; unsigned d;
+  head[0]=comm->np, head[1]=comm->id, head[2]=nel;
+  head[3]=local_hash_size, head[4]=global_hash_size, head[5]=npt_max;
+  for(d=0;d<D;++d) head[6+d]=n[d], head[6+D+d]=m[d], ntot*=n[d];
+  key[0]=0x811c9dc5ul, key[1]=0x050c5d1ful;
+  hash_bytes(key,head,sizeof head);
+  hash_bytes(key,tol,sizeof tol);
+  for(d=0;d<D;++d) hash_bytes(key,elx[d],ntot*sizeof(double));
+}
+
+static void cache_write(const struct findpts_data *const fd,
+                        const unsigned long key[2])
+{
+  char name[CACHE_MAX_NAME+40];
+  const struct findpts_local_data *const lp = &fd->local;
+  const struct local_hash_data *const lh = &lp->hd;
+  const struct hash_data *const gh = &fd->hash;
+  uint lhnd = lh->hash_n*lh->hash_n;
+  ulong ghnd = gh->hash_n*gh->hash_n;
+  uint head[5];
+  FILE *f;
+  int err;
+  WHEN_3D(lhnd*=lh->hash_n; ghnd*=gh->hash_n;)
+  head[0]=CACHE_MAGIC, head[1]=CACHE_VERSION, head[2]=D;
+  head[3]=lh->offset[lhnd], head[4]=gh->offset[(ghnd-1)/fd->cr.comm.np+1];
+  cache_name(name,key,fd->cr.comm.id);
+  if(!(f = fopen(name,"wb"))) {
+    diagnostic("WARNING ",__FILE__,__LINE__,
+               "findpts_cache: could not open %s for writing",name);
+    return;
+  }
+  err = CACHE_WRITE(key,2) || CACHE_WRITE(head,5)
+     || CACHE_WRITE(lp->obb,lp->nel)
+     || CACHE_WRITE(&lh->hash_n,1) || CACHE_WRITE(lh->bnd,D)
+     || CACHE_WRITE(lh->fac,D) || CACHE_WRITE(&lh->max,1)
+     || CACHE_WRITE(lh->offset,head[3])
+     || CACHE_WRITE(&gh->hash_n,1) || CACHE_WRITE(gh->bnd,D)
+     || CACHE_WRITE(gh->fac,D)
+     || CACHE_WRITE(gh->offset,head[4]);
+  if(fclose(f) || err) {
+    diagnostic("WARNING ",__FILE__,__LINE__,
+               "findpts_cache: error writing %s",name);
+    remove(name);
+  }
+}
+
+/* returns 1 on success, with fd->local complete;
+   on failure nothing is left allocated */
+static int cache_read(struct findpts_data *const fd,
+                      const unsigned long key[2],
+                      const double *const elx[D],
+                      const unsigned n[D], const uint nel,
+                      const unsigned npt_max, const double newt_tol)
+{
+  char name[CACHE_MAX_NAME+40];
+  struct findpts_local_data *const lp = &fd->local;
+  struct local_hash_data *const lh = &lp->hd;
+  struct hash_data *const gh = &fd->hash;
+  unsigned long fkey[2];
+  uint head[5];
+  unsigned d;
+  FILE *f;
+  cache_name(name,key,fd->cr.comm.id);
+  if(!(f = fopen(name,"rb"))) return 0;
+  if(CACHE_READ(fkey,2) || fkey[0]!=key[0] || fkey[1]!=key[1]
+     || CACHE_READ(head,5)
+     || head[0]!=CACHE_MAGIC || head[1]!=CACHE_VERSION
+     || head[2]!=D) { fclose(f); return 0; }
+  lp->obb = tmalloc(struct obbox,nel);
+  lh->offset = tmalloc(uint,head[3]);
+  gh->offset = tmalloc(uint,head[4]);
+  if(CACHE_READ(lp->obb,nel)
+     || CACHE_READ(&lh->hash_n,1) || CACHE_READ(lh->bnd,D)
+     || CACHE_READ(lh->fac,D) || CACHE_READ(&lh->max,1)
+     || CACHE_READ(lh->offset,head[3])
+     || CACHE_READ(&gh->hash_n,1) || CACHE_READ(gh->bnd,D)
+     || CACHE_READ(gh->fac,D)
+     || CACHE_READ(gh->offset,head[4]) || fgetc(f)!=EOF) {
+    fclose(f);
+    free(lp->obb), free(lh->offset), free(gh->offset);
+    return 0;
+  }
+  fclose(f);
+  lp->ntot=n[0]; for(d=1;d<D;++d) lp->ntot*=n[d];
+  lp->nel=nel;
+  for(d=0;d<D;++d) lp->elx[d]=elx[d];
+  findpts_el_setup(&lp->fed,n,npt_max);
+  lp->tol=newt_tol;
+  return 1;
+}
+
+/* key is only used when a cache prefix is set */
 static void setup_aux(
-  struct findpts_data *const fd,
+  struct findpts_data *const fd, const unsigned long key[2],
   const double *const elx[D],
   const unsigned n[D], const uint nel,
   const unsigned m[D], const double bbox_tol,
   const uint local_hash_size, const uint global_hash_size,
   const unsigned npt_max, const double newt_tol)
 {
+  if(cache_prefix[0]) {
+    int ok = cache_read(fd,key,elx,n,nel,npt_max,newt_tol);
+    /* the global hash is built collectively: all procs read, or none */
+    if(comm_reduce_int(&fd->cr.comm,gs_min,&ok,1)) return;
+    if(ok) hash_free(&fd->hash), findpts_local_free(&fd->local);
+  }
   findpts_local_setup(&fd->local,elx,n,nel,m,bbox_tol,local_hash_size,
                       npt_max, newt_tol);
   hash_build(&fd->hash,&fd->local.hd,fd->local.obb,nel,
              global_hash_size,&fd->cr);
+  if(cache_prefix[0]) cache_write(fd,key);
 }
 
 struct findpts_data *findpts_setup(
@@ -225,8 +349,12 @@ struct findpts_data *findpts_setup(
   const unsigned npt_max, const double newt_tol)
 {
   struct findpts_data *const fd = tmalloc(struct findpts_data, 1);
+  unsigned long key[2];
   crystal_init(&fd->cr,comm);
-  setup_aux(fd,elx,n,nel,m,bbox_tol,
+  if(cache_prefix[0])
+    setup_key(key,&fd->cr.comm,elx,n,nel,m,bbox_tol,
+              local_hash_size,global_hash_size,npt_max,newt_tol);
+  setup_aux(fd,key,elx,n,nel,m,bbox_tol,
             local_hash_size,global_hash_size,npt_max,newt_tol);
   return fd;
 }
@@ -374,6 +502,156 @@ void findpts(      uint   *const  code_base   , const unsigned  code_stride   ,
   }
 }
 
+/* Incremental search: code, proc, el, r, dist2 hold the result of an
+   earlier findpts (or findpts_update) call on the same handle, and x the
+   new (e.g., moved) coordinates.  Each point with a previous location is
+   sent to that proc and tried first in its previous element, then in the
+   proc's local hash (which covers the element's neighbors there); only
+   points that are not found inside an element this way go through the
+   global hash search of findpts. */
+
+struct upd_pt { double x[D]; uint index, proc, el; };
+struct upd_miss { double x[D], r[D], dist2; uint index, code, proc, el; };
+
+void findpts_update(
+                   uint   *const  code_base   , const unsigned  code_stride   ,
+                   uint   *const  proc_base   , const unsigned  proc_stride   ,
+                   uint   *const    el_base   , const unsigned    el_stride   ,
+                   double *const     r_base   , const unsigned     r_stride   ,
+                   double *const dist2_base   , const unsigned dist2_stride   ,
+             const double *const     x_base[D], const unsigned     x_stride[D],
+             const uint npt, struct findpts_data *const fd)
+{
+  #define  AT(T,var,i) (T*)((char*)var##_base+(i)*var##_stride)
+  const uint np = fd->cr.comm.np;
+  struct array upd, out_pt, miss;
+  /* send points with a previous location to the proc that had them */
+  {
+    uint index;
+    struct upd_pt *pt;
+    array_init(struct upd_pt, &upd, npt), pt=upd.ptr;
+    for(index=0;index<npt;++index) {
+      uint *code = AT(uint,code,index);
+      const uint proc = *AT(uint,proc,index);
+      if(*code!=CODE_NOT_FOUND && proc<np) {
+        unsigned d;
+        for(d=0;d<D;++d) pt->x[d]=*(const double*)((const char*)x_base[d]
+                                                   +index*x_stride[d]);
+        pt->index=index;
+        pt->proc=proc;
+        pt->el=*AT(uint,el,index);
+        ++pt;
+      }
+      *code = CODE_NOT_FOUND;
+    }
+    upd.n = pt - (struct upd_pt*)upd.ptr;
+    sarray_transfer(struct upd_pt,&upd,proc,1,&fd->cr);
+  }
+  /* previous element first, then the local hash; send back the hits */
+  {
+    uint n=upd.n, nm=0;
+    struct upd_pt *spt;
+    struct out_pt *opt;
+    sarray_sort(struct upd_pt,upd.ptr,n, el,0, &fd->cr.data);
+    spt=upd.ptr;
+    while(n && spt[n-1].el>=fd->local.nel) --n; /* stale element ids */
+    array_init(struct out_pt,&out_pt,n), out_pt.n=n;
+    opt=out_pt.ptr;
+    for(;n;--n,++spt,++opt)
+      opt->index=spt->index,opt->proc=spt->proc,opt->el=spt->el;
+    spt=upd.ptr, opt=out_pt.ptr;
+    if(out_pt.n) {
+      const double *spt_x_base[D]; unsigned spt_x_stride[D];
+      unsigned d; for(d=0;d<D;++d) spt_x_base[d] = spt[0].x+d,
+                                   spt_x_stride[d] = sizeof(struct upd_pt);
+      findpts_local_el(&opt[0].code ,sizeof(struct out_pt),
+                       &opt[0].el   ,sizeof(struct out_pt),
+                        opt[0].r    ,sizeof(struct out_pt),
+                       &opt[0].dist2,sizeof(struct out_pt),
+                        spt_x_base  ,spt_x_stride,
+                       out_pt.n,&fd->local);
+    }
+    /* gather the escaped points at the front of upd */
+    for(n=0;n<out_pt.n;++n) if(opt[n].code!=CODE_INTERNAL) {
+      spt[nm]=spt[n], spt[nm].index=n, ++nm;
+    }
+    if(nm) {
+      struct out_pt *const lpt = tmalloc(struct out_pt,nm);
+      const double *spt_x_base[D]; unsigned spt_x_stride[D];
+      unsigned d; for(d=0;d<D;++d) spt_x_base[d] = spt[0].x+d,
+                                   spt_x_stride[d] = sizeof(struct upd_pt);
+      findpts_local(&lpt[0].code ,sizeof(struct out_pt),
+                    &lpt[0].el   ,sizeof(struct out_pt),
+                     lpt[0].r    ,sizeof(struct out_pt),
+                    &lpt[0].dist2,sizeof(struct out_pt),
+                     spt_x_base  ,spt_x_stride,
+                    nm,&fd->local,&fd->cr.data);
+      for(n=0;n<nm;++n) {
+        struct out_pt *const q = &opt[spt[n].index];
+        q->code=lpt[n].code, q->el=lpt[n].el, q->dist2=lpt[n].dist2;
+        for(d=0;d<D;++d) q->r[d]=lpt[n].r[d];
+      }
+      free(lpt);
+    }
+    array_free(&upd);
+    for(n=0,nm=0;n<out_pt.n;++n) if(opt[n].code==CODE_INTERNAL)
+      opt[nm++]=opt[n];
+    out_pt.n=nm;
+    sarray_transfer(struct out_pt,&out_pt,proc,1,&fd->cr);
+  }
+  /* accept the hits */
+  {
+    uint n=out_pt.n;
+    struct out_pt *opt;
+    for(opt=out_pt.ptr;n;--n,++opt) {
+      const uint index = opt->index;
+      double *r = AT(double,r,index);
+      unsigned d; for(d=0;d<D;++d) r[d]=opt->r[d];
+      *AT(double,dist2,index) = opt->dist2;
+      *AT(uint,proc,index) = opt->proc;
+      *AT(uint,el,index) = opt->el;
+      *AT(uint,code,index) = opt->code;
+    }
+    array_free(&out_pt);
+  }
+  /* full search for the rest */
+  {
+    uint index;
+    struct upd_miss *pt;
+    const double *mx_base[D]; unsigned mx_stride[D];
+    unsigned d;
+    array_init(struct upd_miss, &miss, npt), pt=miss.ptr;
+    for(index=0;index<npt;++index) {
+      if(*AT(uint,code,index)==CODE_INTERNAL) continue;
+      for(d=0;d<D;++d) pt->x[d]=*(const double*)((const char*)x_base[d]
+                                                 +index*x_stride[d]);
+      pt->index=index;
+      ++pt;
+    }
+    miss.n = pt - (struct upd_miss*)miss.ptr;
+    pt = miss.ptr;
+    for(d=0;d<D;++d) mx_base[d] = pt[0].x+d,
+                     mx_stride[d] = sizeof(struct upd_miss);
+    findpts(&pt[0].code ,sizeof(struct upd_miss),
+            &pt[0].proc ,sizeof(struct upd_miss),
+            &pt[0].el   ,sizeof(struct upd_miss),
+             pt[0].r    ,sizeof(struct upd_miss),
+            &pt[0].dist2,sizeof(struct upd_miss),
+             mx_base    ,mx_stride, miss.n, fd);
+    for(index=miss.n;index;--index,++pt) {
+      const uint i = pt->index;
+      double *r = AT(double,r,i);
+      for(d=0;d<D;++d) r[d]=pt->r[d];
+      *AT(double,dist2,i) = pt->dist2;
+      *AT(uint,proc,i) = pt->proc;
+      *AT(uint,el,i) = pt->el;
+      *AT(uint,code,i) = pt->code;
+    }
+    array_free(&miss);
+  }
+  #undef AT
+}
+
 struct eval_src_pt { double r[D]; uint index, proc, el; };
 struct eval_out_pt { double out; uint index, proc; };
 
@@ -440,17 +718,111 @@ void findpts_eval(
   }
 }
 
+#undef findpts_update
+/* Evaluate nfld fields at once: field k is in + k*in_stride, its value
+   for point i goes to out_base + i*out_stride + k*out_fld_stride.
+   The (el,r) records are sent once, and the basis weights computed once
+   per point, for all the fields. */
+
+struct eval_outn_pt { uint index, proc; double out[1]; };
+
+void findpts_eval_n(
+        double *const  out_base, const unsigned  out_stride,
+                                 const unsigned  out_fld_stride,
+  const uint   *const code_base, const unsigned code_stride,
+  const uint   *const proc_base, const unsigned proc_stride,
+  const uint   *const   el_base, const unsigned   el_stride,
+  const double *const    r_base, const unsigned    r_stride,
+  const uint npt,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_data *const fd)
+{
+  const size_t size = sizeof(struct eval_outn_pt)+(nfld-1)*sizeof(double);
+  struct array src, outpt;
+  if(nfld==0) return; /* size above wraps around */
+  /* copy user data, weed out unfound points, send out */
+  {
+    uint index;
+    const uint *code=code_base, *proc=proc_base, *el=el_base;
+    const double *r=r_base;
+    struct eval_src_pt *pt;
+    array_init(struct eval_src_pt, &src, npt), pt=src.ptr;
+    for(index=0;index<npt;++index) {
+      if(*code!=CODE_NOT_FOUND) {
+        unsigned d;
+        for(d=0;d<D;++d) pt->r[d]=r[d];
+        pt->index=index;
+        pt->proc=*proc;
+        pt->el=*el;
+        ++pt;
+      }
+      r    = (const double*)((const char*)r   +   r_stride);
+      code = (const   uint*)((const char*)code+code_stride);
+      proc = (const   uint*)((const char*)proc+proc_stride);
+      el   = (const   uint*)((const char*)el  +  el_stride);
+    }
+    src.n = pt - (struct eval_src_pt*)src.ptr;
+    sarray_transfer(struct eval_src_pt,&src,proc,1,&fd->cr);
+  }
+  /* evaluate points, send back */
+  {
+    uint n=src.n;
+    const struct eval_src_pt *spt;
+    char *opt;
+    /* group points by element */
+    sarray_sort(struct eval_src_pt,src.ptr,n, el,0, &fd->cr.data);
+    array_init_(&outpt,n,size,__FILE__,__LINE__), outpt.n=n;
+    spt=src.ptr, opt=outpt.ptr;
+    for(;n;--n,++spt,opt+=size) {
+      struct eval_outn_pt *const o = (struct eval_outn_pt*)opt;
+      o->index=spt->index,o->proc=spt->proc;
+    }
+    spt=src.ptr, opt=outpt.ptr;
+    if(src.n)
+      findpts_local_eval_n(((struct eval_outn_pt*)opt)->out,size,
+                           sizeof(double),
+                           &spt->el  ,sizeof(struct eval_src_pt),
+                            spt->r   ,sizeof(struct eval_src_pt),
+                           src.n, in,in_stride,nfld, &fd->local);
+    array_free(&src);
+    sarray_transfer_(&outpt,size,offsetof(struct eval_outn_pt,proc),1,
+                     &fd->cr);
+  }
+  /* copy results to user data */
+  {
+    uint n=outpt.n;
+    const char *opt;
+    for(opt=outpt.ptr;n;--n,opt+=size) {
+      const struct eval_outn_pt *const o = (const struct eval_outn_pt*)opt;
+      char *out = (char*)out_base + o->index*out_stride;
+      unsigned k;
+      for(k=0;k<nfld;++k,out+=out_fld_stride) *(double*)out = o->out[k];
+    }
+    array_free(&outpt);
+  }
+}
+
+#undef findpts_eval_n
 #undef findpts_eval
 #undef findpts
 #undef findpts_free
 #undef findpts_setup
+#undef findpts_el_setup
+#undef cache_read
+#undef cache_write
+#undef setup_key
 #undef setup_aux
+#undef upd_miss
+#undef upd_pt
+#undef eval_outn_pt
 #undef eval_out_pt
 #undef eval_src_pt
 #undef out_pt
 #undef src_pt
 #undef findpts_data
+#undef findpts_local_eval_n
 #undef findpts_local_eval
+#undef findpts_local_el
 #undef findpts_local
 #undef findpts_local_free
 #undef findpts_local_setup
@@ -8,7 +8,9 @@
 #define findpts_local_setup_2   PREFIXED_NAME(findpts_local_setup_2)
 #define findpts_local_free_2    PREFIXED_NAME(findpts_local_free_2 )
 #define findpts_local_2         PREFIXED_NAME(findpts_local_2      )
+#define findpts_local_el_2      PREFIXED_NAME(findpts_local_el_2   )
 #define findpts_local_eval_2    PREFIXED_NAME(findpts_local_eval_2 )
+#define findpts_local_eval_n_2  PREFIXED_NAME(findpts_local_eval_n_2)
 
 struct findpts_local_hash_data_2 {
   uint hash_n;
@@ -20,6 +22,7 @@ struct findpts_local_hash_data_2 {
 
 struct findpts_local_data_2 {
   unsigned ntot;
+  uint nel;
   const double *elx[2];
   struct obbox_2 *obb;
   struct findpts_local_hash_data_2 hd;
@@ -42,17 +45,34 @@ void findpts_local_2(
   const double *const     x_base[2], const unsigned     x_stride[2],
   const uint npt, struct findpts_local_data_2 *const fd,
   buffer *buf);
+void findpts_local_el_2(
+        uint   *const  code_base   , const unsigned  code_stride   ,
+  const uint   *const    el_base   , const unsigned    el_stride   ,
+        double *const     r_base   , const unsigned     r_stride   ,
+        double *const dist2_base   , const unsigned dist2_stride   ,
+  const double *const     x_base[2], const unsigned     x_stride[2],
+  const uint npt, struct findpts_local_data_2 *const fd);
 void findpts_local_eval_2(
         double *const out_base, const unsigned out_stride,
   const uint   *const  el_base, const unsigned  el_stride,
   const double *const   r_base, const unsigned   r_stride,
   const uint npt,
   const double *const in, struct findpts_local_data_2 *const fd);
+void findpts_local_eval_n_2(
+        double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
+  const uint   *const  el_base, const unsigned  el_stride,
+  const double *const   r_base, const unsigned   r_stride,
+  const uint npt,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_local_data_2 *const fd);
 
 #define findpts_local_setup_3   PREFIXED_NAME(findpts_local_setup_3)
 #define findpts_local_free_3    PREFIXED_NAME(findpts_local_free_3 )
 #define findpts_local_3         PREFIXED_NAME(findpts_local_3      )
+#define findpts_local_el_3      PREFIXED_NAME(findpts_local_el_3   )
 #define findpts_local_eval_3    PREFIXED_NAME(findpts_local_eval_3 )
+#define findpts_local_eval_n_3  PREFIXED_NAME(findpts_local_eval_n_3)
 
 struct findpts_local_hash_data_3 {
   uint hash_n;
@@ -64,6 +84,7 @@ struct findpts_local_hash_data_3 {
 
 struct findpts_local_data_3 {
   unsigned ntot;
+  uint nel;
   const double *elx[3];
   struct obbox_3 *obb;
   struct findpts_local_hash_data_3 hd;
@@ -86,11 +107,26 @@ void findpts_local_3(
   const double *const     x_base[3], const unsigned     x_stride[3],
   const uint npt, struct findpts_local_data_3 *const fd,
   buffer *buf);
+void findpts_local_el_3(
+        uint   *const  code_base   , const unsigned  code_stride   ,
+  const uint   *const    el_base   , const unsigned    el_stride   ,
+        double *const     r_base   , const unsigned     r_stride   ,
+        double *const dist2_base   , const unsigned dist2_stride   ,
+  const double *const     x_base[3], const unsigned     x_stride[3],
+  const uint npt, struct findpts_local_data_3 *const fd);
 void findpts_local_eval_3(
         double *const out_base, const unsigned out_stride,
   const uint   *const  el_base, const unsigned  el_stride,
   const double *const   r_base, const unsigned   r_stride,
   const uint npt,
   const double *const in, struct findpts_local_data_3 *const fd);
+void findpts_local_eval_n_3(
+        double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
+  const uint   *const  el_base, const unsigned  el_stride,
+  const double *const   r_base, const unsigned   r_stride,
+  const uint npt,
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_local_data_3 *const fd);
 
 #endif
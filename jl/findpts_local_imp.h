@@ -17,6 +17,7 @@
 #define findpts_el_free     TOKEN_PASTE(PREFIXED_NAME(findpts_el_free_ ),D)
 #define findpts_el          TOKEN_PASTE(PREFIXED_NAME(findpts_el_      ),D)
 #define findpts_el_eval     TOKEN_PASTE(PREFIXED_NAME(findpts_el_eval_ ),D)
+#define findpts_el_eval_n   TOKEN_PASTE(PREFIXED_NAME(findpts_el_eval_n_),D)
 #define findpts_el_start    TOKEN_PASTE(findpts_el_start_  ,D)
 #define findpts_el_points   TOKEN_PASTE(findpts_el_points_ ,D)
 #define findpts_local_data  TOKEN_PASTE(findpts_local_data_,D)
@@ -24,7 +25,9 @@
 #define findpts_local_setup TOKEN_PASTE(PREFIXED_NAME(findpts_local_setup_),D)
 #define findpts_local_free  TOKEN_PASTE(PREFIXED_NAME(findpts_local_free_ ),D)
 #define findpts_local       TOKEN_PASTE(PREFIXED_NAME(findpts_local_      ),D)
+#define findpts_local_el    TOKEN_PASTE(PREFIXED_NAME(findpts_local_el_   ),D)
 #define findpts_local_eval  TOKEN_PASTE(PREFIXED_NAME(findpts_local_eval_ ),D)
+#define findpts_local_eval_n TOKEN_PASTE(PREFIXED_NAME(findpts_local_eval_n_),D)
 
 /*--------------------------------------------------------------------------
    Point to Possible Elements Hashing
@@ -194,6 +197,7 @@ static void hash_free(struct hash_data *p) { free(p->offset); }
 
 struct findpts_local_data {
   unsigned ntot;
+  uint nel;
   const double *elx[D];
   struct obbox *obb;
   struct hash_data hd;
@@ -211,6 +215,7 @@ void findpts_local_setup(struct findpts_local_data *const fd,
   unsigned d;
   unsigned ntot=n[0]; for(d=1;d<D;++d) ntot*=n[d];
   fd->ntot = ntot;
+  fd->nel = nel;
   for(d=0;d<D;++d) fd->elx[d]=elx[d];
   fd->obb=tmalloc(struct obbox,nel);
   obbox_calc(fd->obb,elx,n,nel,m,bbox_tol);
@@ -331,13 +336,54 @@ void findpts_local(
   array_free(&map);
 }
 
-/* assumes points are already grouped by elements */
-void findpts_local_eval(
+/* Newton solve for each point in the given element only;
+   assumes points are already grouped by elements */
+void findpts_local_el(
+        uint   *const  code_base   , const unsigned  code_stride   ,
+  const uint   *const    el_base   , const unsigned    el_stride   ,
+        double *const     r_base   , const unsigned     r_stride   ,
+        double *const dist2_base   , const unsigned dist2_stride   ,
+  const double *const     x_base[D], const unsigned     x_stride[D],
+  const uint npt, struct findpts_local_data *const fd)
+{
+  struct findpts_el_data *const fed = &fd->fed;
+  struct findpts_el_pt *const fpt = findpts_el_points(fed);
+  const unsigned npt_max = fed->npt_max;
+  uint p;
+  for(p=0;p<npt;) {
+    const uint el = *CAT(uint,el,p), el_off=el*fd->ntot;
+    const double *elx[D];
+    unsigned d;
+    for(d=0;d<D;++d) elx[d]=fd->elx[d]+el_off;
+    findpts_el_start(fed,elx);
+    do {
+      unsigned i, n; uint q;
+      for(n=0,q=p;n<npt_max && q<npt && *CAT(uint,el,q)==el;++q,++n)
+        for(d=0;d<D;++d) fpt[n].x[d]=*CATD(double,x,q,d);
+      findpts_el(fed,n,fd->tol);
+      for(i=0;i<n;++i) {
+        double *r = AT(double,r,p+i);
+        *AT(uint,code,p+i) = fpt[i].flags==(1u<<(2*D)) ? CODE_INTERNAL
+                                                       : CODE_BORDER;
+        *AT(double,dist2,p+i) = fpt[i].dist2;
+        for(d=0;d<D;++d) r[d]=fpt[i].r[d];
+      }
+      p=q;
+    } while(p<npt && *CAT(uint,el,p)==el);
+  }
+}
+
+/* assumes points are already grouped by elements;
+   field k is in + k*in_stride, its value for point p goes to
+   out_base + p*out_stride + k*out_fld_stride (bytes) */
+void findpts_local_eval_n(
         double *const out_base, const unsigned out_stride,
+                                const unsigned out_fld_stride,
   const uint   *const  el_base, const unsigned  el_stride,
   const double *const   r_base, const unsigned   r_stride,
   const uint npt,
-  const double *const in, struct findpts_local_data *const fd)
+  const double *const in, const unsigned in_stride, const unsigned nfld,
+  struct findpts_local_data *const fd)
 {
   struct findpts_el_data *const fed = &fd->fed;
   const unsigned npt_max = fed->npt_max;
@@ -348,19 +394,32 @@ void findpts_local_eval(
     do {
       unsigned i; uint q;
       for(i=0,q=p;i<npt_max && q<npt && *CAT(uint,el,q)==el;++q) ++i;
-      findpts_el_eval( AT(double,out,p),out_stride,
-                      CAT(double,  r,p),  r_stride, i,
-                      in_el,fed);
+      findpts_el_eval_n( AT(double,out,p),out_stride,out_fld_stride,
+                        CAT(double,  r,p),  r_stride, i,
+                        in_el,in_stride,nfld,fed);
       p=q;
     } while(p<npt && *CAT(uint,el,p)==el);
   }
 }
 
+void findpts_local_eval(
+        double *const out_base, const unsigned out_stride,
+  const uint   *const  el_base, const unsigned  el_stride,
+  const double *const   r_base, const unsigned   r_stride,
+  const uint npt,
+  const double *const in, struct findpts_local_data *const fd)
+{
+  findpts_local_eval_n(out_base,out_stride,0, el_base,el_stride,
+                       r_base,r_stride, npt, in,0,1, fd);
+}
+
 #undef CATD
 #undef CAT
 #undef AT
 
+#undef findpts_local_eval_n
 #undef findpts_local_eval
+#undef findpts_local_el
 #undef findpts_local
 #undef findpts_local_free
 #undef findpts_local_setup
@@ -368,6 +427,7 @@ void findpts_local_eval(
 #undef findpts_local_data
 #undef findpts_el_points
 #undef findpts_el_start
+#undef findpts_el_eval_n
 #undef findpts_el_eval
 #undef findpts_el
 #undef findpts_el_free
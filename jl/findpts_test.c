@@ -28,6 +28,8 @@
 #define findpts_free  findpts_free_3
 #define findpts       findpts_3
 #define findpts_eval  findpts_eval_3
+#define findpts_eval_n findpts_eval_n_3
+#define findpts_update findpts_update_3
 #elif D==2
 #define INITD(a,b,c) {a,b}
 #define MULD(a,b,c) ((a)*(b))
@@ -37,6 +39,8 @@
 #define findpts_free  findpts_free_2
 #define findpts       findpts_2
 #define findpts_eval  findpts_eval_2
+#define findpts_eval_n findpts_eval_n_2
+#define findpts_update findpts_update_2
 #endif
 
 #define NR 5
@@ -192,6 +196,52 @@ static void test_mesh(void)
     printf("%u: %u shuffled points\n",id,(unsigned)testp.n);
 }
 
+/* box mesh stored in single precision, test points at its GLL nodes
+   in double precision: those on and near an element face are just
+   outside the neighbouring element (see reject_prior_step_q) */
+static void box_mesh(void)
+{
+  const uint pn = ceil(pow(np,1.0/D));
+  const uint pi=id%pn, pj=(id/pn)%pn;
+  #if D==3
+  const uint pk=(id/pn)/pn;
+  #endif
+  const double pfac = 1.0/pn;
+  const double pbase[D] = INITD(-1+2*pfac*pi, -1+2*pfac*pj, -1+2*pfac*pk);
+  const double fac = 1.0/K;
+  unsigned ki,kj;
+  #if D==3
+  unsigned kk;
+  #endif
+  struct pt_data *out;
+  array_reserve(struct pt_data,&testp,NEL*MULD(NR,NS,NT));
+  out = testp.ptr, testp.n = NEL*MULD(NR,NS,NT);
+  memset(testp.ptr,0,testp.n*sizeof(struct pt_data));
+  #if D==3
+  for(kk=0;kk<K;++kk)
+  #endif
+  for(kj=0;kj<K;++kj) for(ki=0;ki<K;++ki) {
+    unsigned off = INDEXD(ki,K, kj,K, kk)*MULD(NR,NS,NT);
+    unsigned i,j,d;
+    double r[D], base[D] = INITD(-1+2*fac*ki,-1+2*fac*kj,-1+2*fac*kk);
+    #if D==3
+    unsigned k;
+    for(k=0;k<NT;++k) { r[2]=pbase[2]+pfac*(1+base[2]+fac*(1+zt[k]));
+    #endif
+    for(j=0;j<NS;++j) { r[1]=pbase[1]+pfac*(1+base[1]+fac*(1+zs[j]));
+    for(i=0;i<NR;++i) { r[0]=pbase[0]+pfac*(1+base[0]+fac*(1+zr[i]));
+      for(d=0;d<D;++d)
+        mesh[d][off+INDEXD(i,NR, j,NS, k)] = (float)r[d],
+        out->x[d] = r[d];
+      out->proc = id;
+      ++out;
+    #if D==3
+    }
+    #endif
+    }}
+  }
+}
+
 static void print_ptdata(const struct comm *const comm)
 {
   uint notfound=0;
@@ -292,8 +342,100 @@ static void test(const struct comm *const comm)
                   pt->r    , sizeof(struct pt_data),
                   testp.n, mesh[d], fd);
   }
+  print_ptdata(comm);
+  /* search again from the previous locations, some of them wrong */
+  {
+    uint i;
+    for(i=0;i<testp.n;++i) {
+      if(i%3==1) pt[i].el=(pt[i].el+1)%NEL;
+      if(i%5==2) pt[i].proc=(pt[i].proc+1)%np;
+      if(i%7==3) pt[i].code=2;
+    }
+  }
+  if(id==0) printf("calling findpts_update\n");
+  findpts_update(&pt->code , sizeof(struct pt_data),
+                 &pt->proc , sizeof(struct pt_data),
+                 &pt->el   , sizeof(struct pt_data),
+                  pt->r    , sizeof(struct pt_data),
+                 &pt->dist2, sizeof(struct pt_data),
+                  x_base   , x_stride, testp.n, fd);
+  for(d=0;d<D;++d)
+    findpts_eval(&pt->ex[d], sizeof(struct pt_data),
+                 &pt->code , sizeof(struct pt_data),
+                 &pt->proc , sizeof(struct pt_data),
+                 &pt->el   , sizeof(struct pt_data),
+                  pt->r    , sizeof(struct pt_data),
+                  testp.n, mesh[d], fd);
+  print_ptdata(comm);
+  /* all D coordinates in one call */
+  for(d=0;d<D;++d) { uint i; for(i=0;i<testp.n;++i) pt[i].ex[d]=0; }
+  if(id==0) printf("calling findpts_eval_n\n");
+  findpts_eval_n(pt->ex    , sizeof(struct pt_data), sizeof(double),
+                 &pt->code , sizeof(struct pt_data),
+                 &pt->proc , sizeof(struct pt_data),
+                 &pt->el   , sizeof(struct pt_data),
+                  pt->r    , sizeof(struct pt_data),
+                  testp.n, mesh[0], NEL*MULD(NR,NS,NT), 0, fd);
+  findpts_eval_n(pt->ex    , sizeof(struct pt_data), sizeof(double),
+                 &pt->code , sizeof(struct pt_data),
+                 &pt->proc , sizeof(struct pt_data),
+                 &pt->el   , sizeof(struct pt_data),
+                  pt->r    , sizeof(struct pt_data),
+                  testp.n, mesh[0], NEL*MULD(NR,NS,NT), D, fd);
   findpts_free(fd);
   print_ptdata(comm);
+  /* the setup tables built and saved in findpts_test_fpts_*, then loaded */
+  findpts_cache("findpts_test_");
+  for(d=0;d<2;++d) {
+    uint i; unsigned k;
+    if(id==0) printf("calling findpts_setup, cached (%u)\n",d);
+    fd=findpts_setup(comm,elx,nr,NEL,mr,BBOX_TOL,
+                     LOC_HASH_SIZE,GBL_HASH_SIZE,
+                     NPT_MAX,NEWT_TOL);
+    for(i=0;i<testp.n;++i) for(k=0;k<D;++k) pt[i].ex[k]=0;
+    findpts(&pt->code , sizeof(struct pt_data),
+            &pt->proc , sizeof(struct pt_data),
+            &pt->el   , sizeof(struct pt_data),
+             pt->r    , sizeof(struct pt_data),
+            &pt->dist2, sizeof(struct pt_data),
+             x_base   , x_stride, testp.n, fd);
+    findpts_eval_n(pt->ex    , sizeof(struct pt_data), sizeof(double),
+                   &pt->code , sizeof(struct pt_data),
+                   &pt->proc , sizeof(struct pt_data),
+                   &pt->el   , sizeof(struct pt_data),
+                    pt->r    , sizeof(struct pt_data),
+                    testp.n, mesh[0], NEL*MULD(NR,NS,NT), D, fd);
+    findpts_free(fd);
+    print_ptdata(comm);
+  }
+  findpts_cache("");
+  /* points outside an element, single precision geometry; the loose
+     bounding boxes make findpts try each point in its neighbours too */
+  {
+    uint i, nbad=0;
+    if(id==0) printf("calling findpts, single precision box mesh\n");
+    box_mesh();
+    pt = testp.ptr;
+    x_base[0]=pt->x, x_base[1]=pt->x+1;
+    #if D==3
+    x_base[2]=pt->x+2;
+    #endif
+    fd=findpts_setup(comm,elx,nr,NEL,mr,1.00,
+                     LOC_HASH_SIZE,GBL_HASH_SIZE,
+                     NPT_MAX,NEWT_TOL);
+    findpts(&pt->code , sizeof(struct pt_data),
+            &pt->proc , sizeof(struct pt_data),
+            &pt->el   , sizeof(struct pt_data),
+             pt->r    , sizeof(struct pt_data),
+            &pt->dist2, sizeof(struct pt_data),
+             x_base   , x_stride, testp.n, fd);
+    findpts_free(fd);
+    for(i=0;i<testp.n;++i) if(pt[i].dist2>1e-12) ++nbad;
+    nbad = comm_reduce_sint(comm,gs_add,(sint*)&nbad,1);
+    if(id==0) printf("%u points found in the wrong element\n",
+                     (unsigned)nbad);
+    if(nbad) fail(1,__FILE__,__LINE__,"findpts: points misplaced");
+  }
 }
 
 int main(int narg, char *arg[])
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "c99.h"
 #include "name.h"
 #include "fail.h"
@@ -12,6 +15,7 @@
 #define sparse_cholesky_factor PREFIXED_NAME(sparse_cholesky_factor)
 #define sparse_cholesky_solve  PREFIXED_NAME(sparse_cholesky_solve )
 #define sparse_cholesky_free   PREFIXED_NAME(sparse_cholesky_free  )
+#define sparse_cholesky_restore PREFIXED_NAME(sparse_cholesky_restore)
 
 /* factors: L is in CSR format
             D is a diagonal matrix stored as a vector
@@ -24,10 +28,207 @@
      A   = (I-L)   D (I-L)
      
    (triangular factor is unit diagonal; the diagonal is not stored)
+
+   of the permuted matrix P A P', where row i of P A P' is row perm[i] of A;
+   the ordering is a nested dissection of the graph of A (see below)
+
+   rows are grouped into levels: row i depends only on rows in lower levels
+   (those in the structure of row i of L), so that the rows of one level can
+   be factored, and forward/backward substituted, concurrently (OpenMP);
+   the backward substitution uses the transpose of L (Ltp, Lti, Lt),
+   which is only kept when compiled with OpenMP
+*/
+
+/* levels with fewer rows than this are done by one thread */
+#ifndef SPCHOL_PAR_MIN
+#  define SPCHOL_PAR_MIN 64
+#endif
+
+/* subgraphs with no more vertices than this are not dissected further */
+#ifndef SPCHOL_ND_MIN
+#  define SPCHOL_ND_MIN 32
+#endif
+
+/*
+  nested dissection ordering
+
+  for the graph given by (xadj,adj) (symmetric, no self loops),
+  produces order[k] = vertex numbered k
+
+  order[] is worked on in place as a list of ranges, each one holding the
+  vertices of a subgraph; a range is split into [ part 1 | part 2 | sep ]
+  with the separator numbered last, and the two parts are pushed on a stack
+
+  the separator is the middle level of a breadth-first level structure
+  rooted at a pseudo-peripheral vertex, thinned by moving to part 1 those
+  vertices that have no neighbor in part 2;
+  a range whose subgraph is not connected is split into the component found
+  and the rest, with no separator
 */
+struct nd_range { uint s, e; };
+
+static uint nd_bfs(uint root, uint stamp, uint tag,
+                   const uint *xadj, const uint *adj, const uint *where,
+                   uint *seen, uint *lvl, uint *q)
+{
+  uint qs=0, qe=0;
+  q[qe++]=root, seen[root]=stamp, lvl[root]=0;
+  while(qs!=qe) {
+    uint v=q[qs++], p, pe;
+    for(p=xadj[v],pe=xadj[v+1];p!=pe;++p) {
+      uint u=adj[p];
+      if(where[u]!=tag || seen[u]==stamp) continue;
+      seen[u]=stamp, lvl[u]=lvl[v]+1, q[qe++]=u;
+    }
+  }
+  return qe;
+}
+
+static void nested_dissection(uint n, const uint *xadj, const uint *adj,
+                              uint *order)
+{
+  uint *where = tmalloc(uint,5*n), *seen=where+n, *lvl=seen+n, *q=lvl+n,
+       *tmp=q+n;
+  struct array stack; struct nd_range *r;
+  uint i, tag=0, stamp=0;
+
+  for(i=0;i<n;++i) order[i]=i, where[i]=0, seen[i]=0;
+  array_init(struct nd_range,&stack,32);
+  if(n>SPCHOL_ND_MIN)
+    r=stack.ptr, r->s=0, r->e=n, stack.n=1;
+
+  while(stack.n) {
+    struct nd_range cur;
+    uint size, nq, root, nlv, m, count, n1, n2, k;
+    r=stack.ptr, cur=r[--stack.n];
+    size=cur.e-cur.s, ++tag;
+    for(k=cur.s;k<cur.e;++k) where[order[k]]=tag;
+
+    /* pseudo-peripheral root: repeat bfs from the last vertex reached */
+    root=order[cur.s];
+    nq=nd_bfs(root,++stamp,tag,xadj,adj,where,seen,lvl,q);
+    if(nq==size) {
+      uint ecc=lvl[q[nq-1]];
+      for(k=0;k<2;++k) {
+        root=q[nq-1], nq=nd_bfs(root,++stamp,tag,xadj,adj,where,seen,lvl,q);
+        if(lvl[q[nq-1]]<=ecc) break;
+        ecc=lvl[q[nq-1]];
+      }
+    }
+
+    if(nq!=size) {
+      /* not connected: [ component | rest ] */
+      n1=0, n2=nq;
+      for(k=cur.s;k<cur.e;++k) {
+        uint v=order[k];
+        if(seen[v]==stamp) tmp[n1++]=v; else tmp[n2++]=v;
+      }
+      memcpy(order+cur.s,tmp,size*sizeof(uint));
+      n2-=n1;
+    } else {
+      nlv=lvl[q[nq-1]]+1;
+      if(nlv<3) continue;
+      /* separator level: the one holding the middle vertex */
+      for(m=0,count=0,k=0;k<nq;) {
+        m=lvl[q[k]];
+        while(k<nq && lvl[q[k]]==m) ++k, ++count;
+        if(2*count>=size) break;
+      }
+      if(m==0) m=1; else if(m>=nlv-1) m=nlv-2;
+      /* thin the separator */
+      for(k=0;k<nq;++k) {
+        uint v=q[k], p, pe;
+        if(lvl[v]!=m) continue;
+        for(p=xadj[v],pe=xadj[v+1];p!=pe;++p) {
+          uint u=adj[p];
+          if(where[u]==tag && seen[u]==stamp && lvl[u]==m+1) break;
+        }
+        if(p==pe) lvl[v]=m-1;
+      }
+      n1=n2=0;
+      for(k=0;k<nq;++k) { uint l=lvl[q[k]]; if(l<m) ++n1; else if(l>m) ++n2; }
+      { uint i1=0, i2=n1, is=n1+n2;
+        for(k=0;k<nq;++k) {
+          uint v=q[k], l=lvl[v];
+          if(l<m) tmp[i1++]=v; else if(l>m) tmp[i2++]=v; else tmp[is++]=v;
+        }
+      }
+      memcpy(order+cur.s,tmp,size*sizeof(uint));
+    }
+    if(n1>SPCHOL_ND_MIN) {
+      r=array_reserve(struct nd_range,&stack,stack.n+1);
+      r[stack.n].s=cur.s, r[stack.n].e=cur.s+n1, ++stack.n;
+    }
+    if(n2>SPCHOL_ND_MIN) {
+      r=array_reserve(struct nd_range,&stack,stack.n+1);
+      r[stack.n].s=cur.s+n1, r[stack.n].e=cur.s+n1+n2, ++stack.n;
+    }
+  }
+  array_free(&stack);
+  free(where);
+}
+
+/* the lower triangle of A (incl. diagonal) gives the graph of A
+   and, permuted, the lower triangle of P A P' (rows sorted) */
+static void permute_matrix(uint n, const uint *Arp, const uint *Aj,
+                           const double *A, uint *perm,
+                           uint **Prp_out, uint **Pj_out, double **P_out)
+{
+  uint *inv = tmalloc(uint,2*n+1), *xadj=inv+n;
+  uint *adj, *Prp, *Pj; double *P;
+  uint i, p, pe, nz=0, nl=0;
+  for(i=0;i<=n;++i) xadj[i]=0;
+  for(i=0;i<n;++i) for(p=Arp[i],pe=Arp[i+1];p!=pe;++p) {
+    uint j=Aj[p]; if(j>i) continue;
+    ++nl; if(j<i) ++xadj[i], ++xadj[j], nz+=2;
+  }
+  for(p=0,i=0;i<=n;++i) { uint t=xadj[i]; xadj[i]=p, p+=t; }
+  adj = tmalloc(uint,nz);
+  for(i=0;i<n;++i) for(p=Arp[i],pe=Arp[i+1];p!=pe;++p) {
+    uint j=Aj[p]; if(j>=i) continue;
+    adj[xadj[i]++]=j, adj[xadj[j]++]=i;
+  }
+  for(i=n;i;--i) xadj[i]=xadj[i-1];
+  xadj[0]=0;
+
+  nested_dissection(n,xadj,adj,perm);
+  free(adj);
+  for(i=0;i<n;++i) inv[perm[i]]=i;
+
+  Prp = tmalloc(uint,n+1+nl), Pj=Prp+n+1, P=tmalloc(double,nl);
+  for(i=0;i<=n;++i) Prp[i]=0;
+  for(i=0;i<n;++i) for(p=Arp[i],pe=Arp[i+1];p!=pe;++p) {
+    uint j=Aj[p], a, b; if(j>i) continue;
+    a=inv[i], b=inv[j]; ++Prp[(a>b?a:b)+1];
+  }
+  for(i=0;i<n;++i) Prp[i+1]+=Prp[i];
+  for(i=0;i<n;++i) for(p=Arp[i],pe=Arp[i+1];p!=pe;++p) {
+    uint j=Aj[p], a, b, r, c, q; if(j>i) continue;
+    a=inv[i], b=inv[j], r=a>b?a:b, c=a>b?b:a;
+    q=Prp[r]++, Pj[q]=c, P[q]=A[p];
+  }
+  for(i=n;i;--i) Prp[i]=Prp[i-1];
+  Prp[0]=0;
+  /* sort each row by column */
+  for(i=0;i<n;++i) {
+    uint q, qe=Prp[i+1];
+    for(q=Prp[i]+1;q<qe;++q) {
+      uint c=Pj[q], t=q; double v=P[q];
+      for(;t>Prp[i] && Pj[t-1]>c;--t) Pj[t]=Pj[t-1], P[t]=P[t-1];
+      Pj[t]=c, P[t]=v;
+    }
+  }
+  free(inv);
+  *Prp_out=Prp, *Pj_out=Pj, *P_out=P;
+}
+
 struct sparse_cholesky {
   uint n, *Lrp, *Lj;
   double *L, *D;
+  uint *perm;
+  uint nlvl, *lvl_off, *lvl_row;
+  uint *Ltp, *Lti; double *Lt;
+  double *work;
 };
 
 /*
@@ -102,74 +303,208 @@ static void factor_symbolic(uint n, const uint *Arp, const uint *Aj,
   then s = D y, and d = 1/(s' y)
   
 */
+/* computes row i of L and D[i], given all rows in the structure of row i;
+   visit must not contain i for any entry other than those set here */
+static void factor_row(uint i, uint n, const uint *Arp, const uint *Aj,
+                       const double *A, struct sparse_cholesky *out,
+                       uint *visit, double *y)
+{
+  const uint *Lrp=out->Lrp, *Lj=out->Lj;
+  double *D=out->D, *L=out->L;
+  uint p,pe; double a=0;
+  visit[i]=n;
+  for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) {
+    uint j=Lj[p]; y[j]=0, visit[j]=i;
+  }
+  for(p=Arp[i],pe=Arp[i+1];p!=pe;++p) {
+    uint j=Aj[p];
+    if(j>=i) { if(j==i) a=A[p]; break; }
+    y[j]=-A[p];
+  }
+  for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) {
+    uint q,qe,j=Lj[p]; double lij,yj=y[j];
+    for(q=Lrp[j],qe=Lrp[j+1];q!=qe;++q) {
+      uint k=Lj[q]; if(visit[k]==i) yj+=L[q]*y[k];
+    }
+    y[j]=yj;
+    L[p]=lij=D[j]*yj;
+    a-=yj*lij;
+  }
+  D[i]=1/a;
+}
+
+/* use threads when the average level has at least this many rows */
+#define PAR_LEVELS(fac) ((fac)->n >= (fac)->nlvl*(SPCHOL_PAR_MIN/4))
+
 static void factor_numeric(uint n, const uint *Arp, const uint *Aj,
                            const double *A,
-                           struct sparse_cholesky *out,
-                           uint *visit, double *y)
+                           struct sparse_cholesky *out, buffer *buf)
 {
-  const uint *Lrp=out->Lrp, *Lj=out->Lj;
-  double *D, *L;
-  uint i;
+  const uint *Lrp=out->Lrp;
   
-  D=out->D=tmalloc(double,n+Lrp[n]);
-  L=out->L=D+n;
-  
-  for(i=0;i<n;++i) {
-    uint p,pe; double a=0;
-    visit[i]=n;
-    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) {
-      uint j=Lj[p]; y[j]=0, visit[j]=i;
-    }
-    for(p=Arp[i],pe=Arp[i+1];p!=pe;++p) {
-      uint j=Aj[p];
-      if(j>=i) { if(j==i) a=A[p]; break; }
-      y[j]=-A[p];
-    }
-    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) {
-      uint q,qe,j=Lj[p]; double lij,yj=y[j];
-      for(q=Lrp[j],qe=Lrp[j+1];q!=qe;++q) {
-        uint k=Lj[q]; if(visit[k]==i) yj+=L[q]*y[k];
+  out->D=tmalloc(double,n+Lrp[n]);
+  out->L=out->D+n;
+
+#ifdef _OPENMP
+  if(PAR_LEVELS(out)) {
+    const uint nlvl=out->nlvl, *lvl_off=out->lvl_off, *lvl_row=out->lvl_row;
+    #pragma omp parallel
+    {
+      uint *visit = tmalloc(uint,n), l, k;
+      double *y = tmalloc(double,n);
+      for(k=0;k<n;++k) visit[k]=n;
+      for(l=0;l<nlvl;++l) {
+        const uint ls=lvl_off[l], le=lvl_off[l+1];
+        if(le-ls<SPCHOL_PAR_MIN) {
+          #pragma omp single
+          for(k=ls;k<le;++k) factor_row(lvl_row[k],n,Arp,Aj,A,out,visit,y);
+        } else {
+          #pragma omp for schedule(dynamic,16)
+          for(k=ls;k<le;++k) factor_row(lvl_row[k],n,Arp,Aj,A,out,visit,y);
+        }
       }
-      y[j]=yj;
-      L[p]=lij=D[j]*yj;
-      a-=yj*lij;
+      free(y); free(visit);
     }
-    D[i]=1/a;
+    return;
   }
+#endif
+  {
+    const uint n_uints_as_dbls = (n*sizeof(uint)+sizeof(double)-1)/sizeof(double);
+    uint *visit, i; double *y;
+    buffer_reserve(buf,(n_uints_as_dbls+n)*sizeof(double));
+    visit=buf->ptr, y=n_uints_as_dbls+(double*)buf->ptr;
+    for(i=0;i<n;++i) factor_row(i,n,Arp,Aj,A,out,visit,y);
+  }
+}
+
+/* level of row i = 1 + max level of the rows in its structure */
+static void find_levels(struct sparse_cholesky *fac)
+{
+  const uint n=fac->n, *Lrp=fac->Lrp, *Lj=fac->Lj;
+  uint *level = tmalloc(uint,n), *off, i, p, pe, nlvl=0;
+  for(i=0;i<n;++i) {
+    uint l=0;
+    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) if(level[Lj[p]]+1>l) l=level[Lj[p]]+1;
+    level[i]=l; if(l+1>nlvl) nlvl=l+1;
+  }
+  fac->nlvl=nlvl;
+  off=fac->lvl_off=tmalloc(uint,nlvl+1+n), fac->lvl_row=off+nlvl+1;
+  for(i=0;i<=nlvl;++i) off[i]=0;
+  for(i=0;i<n;++i) ++off[level[i]+1];
+  for(i=0;i<nlvl;++i) off[i+1]+=off[i];
+  for(i=0;i<n;++i) fac->lvl_row[off[level[i]]++]=i;
+  for(i=nlvl;i;--i) off[i]=off[i-1];
+  off[0]=0;
+  free(level);
+}
+
+/* transpose of L, for the threaded backward substitution */
+static void transpose_L(struct sparse_cholesky *fac)
+{
+#ifdef _OPENMP
+  const uint n=fac->n, *Lrp=fac->Lrp, *Lj=fac->Lj, nz=Lrp[n];
+  const double *L=fac->L;
+  uint *Ltp, *Lti, i, p, pe;
+  Ltp=fac->Ltp=tmalloc(uint,n+1+nz), Lti=fac->Lti=Ltp+n+1;
+  fac->Lt=tmalloc(double,nz);
+  for(i=0;i<=n;++i) Ltp[i]=0;
+  for(p=0;p<nz;++p) ++Ltp[Lj[p]+1];
+  for(i=0;i<n;++i) Ltp[i+1]+=Ltp[i];
+  for(i=0;i<n;++i) for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) {
+    uint q=Ltp[Lj[p]]++; Lti[q]=i, fac->Lt[q]=L[p];
+  }
+  for(i=n;i;--i) Ltp[i]=Ltp[i-1];
+  Ltp[0]=0;
+#else
+  fac->Ltp=fac->Lti=0, fac->Lt=0;
+#endif
 }
 
 /* x = A^(-1) b;  works when x and b alias */
 void sparse_cholesky_solve(
   double *x, const struct sparse_cholesky *fac, double *b)
 {
-  const uint n=fac->n, *Lrp=fac->Lrp, *Lj=fac->Lj;
+  const uint n=fac->n, *Lrp=fac->Lrp, *Lj=fac->Lj, *perm=fac->perm;
   const double *L=fac->L, *D=fac->D;
+  double *w=fac->work;
   uint i, p,pe;
+  for(i=0;i<n;++i) w[i]=b[perm[i]];
+#ifdef _OPENMP
+  if(PAR_LEVELS(fac)) {
+    const uint nlvl=fac->nlvl, *lvl_off=fac->lvl_off, *lvl_row=fac->lvl_row;
+    const uint *Ltp=fac->Ltp, *Lti=fac->Lti;
+    const double *Lt=fac->Lt;
+    #pragma omp parallel private(i,p,pe)
+    {
+      uint l, k;
+      for(l=0;l<nlvl;++l) {
+        const uint ls=lvl_off[l], le=lvl_off[l+1];
+        #pragma omp for schedule(static)
+        for(k=ls;k<le;++k) {
+          double wi; i=lvl_row[k], wi=w[i];
+          for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) wi+=L[p]*w[Lj[p]];
+          w[i]=wi;
+        }
+      }
+      #pragma omp for schedule(static)
+      for(k=0;k<n;++k) w[k]*=D[k];
+      for(l=nlvl;l;) {
+        const uint ls=lvl_off[--l], le=lvl_off[l+1];
+        #pragma omp for schedule(static)
+        for(k=ls;k<le;++k) {
+          double wi; i=lvl_row[k], wi=w[i];
+          for(p=Ltp[i],pe=Ltp[i+1];p!=pe;++p) wi+=Lt[p]*w[Lti[p]];
+          w[i]=wi;
+        }
+      }
+    }
+    for(i=0;i<n;++i) x[perm[i]]=w[i];
+    return;
+  }
+#endif
   for(i=0;i<n;++i) {
-    double xi = b[i];
-    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) xi+=L[p]*x[Lj[p]];
-    x[i]=xi;
+    double wi = w[i];
+    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) wi+=L[p]*w[Lj[p]];
+    w[i]=wi;
   }
-  for(i=0;i<n;++i) x[i]*=D[i];
+  for(i=0;i<n;++i) w[i]*=D[i];
   for(i=n;i;) {
-    double xi = x[--i];
-    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) x[Lj[p]]+=L[p]*xi;
+    double wi = w[--i];
+    for(p=Lrp[i],pe=Lrp[i+1];p!=pe;++p) w[Lj[p]]+=L[p]*wi;
   }
+  for(i=0;i<n;++i) x[perm[i]]=w[i];
 }
 
 void sparse_cholesky_factor(uint n, const uint *Arp, const uint *Aj,
                             const double *A,
                             struct sparse_cholesky *out, buffer *buf)
 {
-  const uint n_uints_as_dbls = (n*sizeof(uint)+sizeof(double)-1)/sizeof(double);
-  buffer_reserve(buf,(n_uints_as_dbls+n)*sizeof(double));
-  factor_symbolic(n,Arp,Aj,out,buf);
-  factor_numeric(n,Arp,Aj,A,out,buf->ptr,n_uints_as_dbls+(double*)buf->ptr);
+  uint *Prp, *Pj; double *P;
+  out->perm = tmalloc(uint,n);
+  permute_matrix(n,Arp,Aj,A,out->perm,&Prp,&Pj,&P);
+  factor_symbolic(n,Prp,Pj,out,buf);
+  find_levels(out);
+  factor_numeric(n,Prp,Pj,P,out,buf);
+  free(Prp); free(P);
+  transpose_L(out);
+  out->work = tmalloc(double,n);
+}
+
+void sparse_cholesky_restore(struct sparse_cholesky *fac)
+{
+  find_levels(fac);
+  transpose_L(fac);
+  fac->work = tmalloc(double,fac->n);
 }
 
 void sparse_cholesky_free(struct sparse_cholesky *fac)
 {
   free(fac->Lrp); fac->Lj=fac->Lrp=0;
   free(fac->D);   fac->L =fac->D  =0;
+  free(fac->perm); fac->perm=0;
+  free(fac->lvl_off); fac->lvl_off=fac->lvl_row=0;
+  free(fac->Ltp); fac->Ltp=fac->Lti=0;
+  free(fac->Lt); fac->Lt=0;
+  free(fac->work); fac->work=0;
 }
 
@@ -8,10 +8,15 @@
 #define sparse_cholesky_factor PREFIXED_NAME(sparse_cholesky_factor)
 #define sparse_cholesky_solve  PREFIXED_NAME(sparse_cholesky_solve )
 #define sparse_cholesky_free   PREFIXED_NAME(sparse_cholesky_free  )
+#define sparse_cholesky_restore PREFIXED_NAME(sparse_cholesky_restore)
 
 struct sparse_cholesky {
   uint n, *Lrp, *Lj;
   double *L, *D;
+  uint *perm;                         /* nested dissection ordering */
+  uint nlvl, *lvl_off, *lvl_row;      /* rows grouped by level */
+  uint *Ltp, *Lti; double *Lt;        /* transpose of L (OpenMP only) */
+  double *work;
 };
 
 /* input data is the usual CSR
@@ -30,5 +35,9 @@ void sparse_cholesky_solve(
 
 void sparse_cholesky_free(struct sparse_cholesky *fac);
 
+/* given n, Lrp, Lj, L, D and perm (e.g., read back from a file),
+   rebuilds the rest of the factor */
+void sparse_cholesky_restore(struct sparse_cholesky *fac);
+
 #endif
 
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "c99.h"
 #include "name.h"
 #include "fail.h"
@@ -41,6 +42,36 @@ int main()
     b[o[i]]=0;
   }
   sparse_cholesky_free(&data);
+
+  /* 5-point Laplacian on a grid: large enough to be dissected */
+  {
+    const uint nx=60, ng=nx*nx;
+    uint *grp = tmalloc(uint,ng+1+5*ng), *grj=grp+ng+1, k, nz=0;
+    double *ga = tmalloc(double,5*ng), *gx = tmalloc(double,2*ng),
+           *gb = gx+ng, err=0;
+    for(k=0;k<ng;++k) {
+      const uint ix=k%nx, iy=k/nx;
+      grp[k]=nz;
+      if(iy>0)    { grj[nz]=k-nx, ga[nz++]=-1; }
+      if(ix>0)    { grj[nz]=k-1,  ga[nz++]=-1; }
+                    grj[nz]=k,    ga[nz++]=4.01;
+      if(ix<nx-1) { grj[nz]=k+1,  ga[nz++]=-1; }
+      if(iy<nx-1) { grj[nz]=k+nx, ga[nz++]=-1; }
+      gb[k]=(double)((k*7)%11)-5;
+    }
+    grp[ng]=nz;
+    sparse_cholesky_factor(ng,grp,grj,ga,&data,&buf);
+    sparse_cholesky_solve(gx,&data,gb);
+    for(k=0;k<ng;++k) {
+      uint p; double r=gb[k];
+      for(p=grp[k];p<grp[k+1];++p) r-=ga[p]*gx[grj[p]];
+      if(fabs(r)>err) err=fabs(r);
+    }
+    printf("grid %dx%d: nnz(L) = %d, levels = %d, max residual = %g\n",
+           (int)nx,(int)nx,(int)data.Lrp[ng],(int)data.nlvl,err);
+    sparse_cholesky_free(&data);
+    free(gx); free(ga); free(grp);
+  }
   buffer_free(&buf);
   /*
   sparse_cholesky_solve(b,&data,b);
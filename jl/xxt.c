@@ -22,6 +22,7 @@
 #define crs_solve PREFIXED_NAME(crs_solve)
 #define crs_stats PREFIXED_NAME(crs_stats)
 #define crs_free  PREFIXED_NAME(crs_free )
+#define crs_cache PREFIXED_NAME(crs_cache)
 
 /*
   portable log base 2
@@ -707,6 +708,169 @@ static void separate_matrix(
   array_free(&mat_ss);
 }
 
+/*
+  setup cache
+
+  once a file name prefix has been given with crs_cache, crs_setup looks for
+  the file "<prefix>xxt_<key>.<id>" written by an earlier setup before doing
+  any work; the key is a hash of the proc count and id, the user's dof ids,
+  the matrix entries and the null space flag.
+  the file holds everything setup computes (separator sizes, permutation,
+  local Cholesky factor and its ordering, A_sl and X); since setup is
+  collective, the cache is used only when every proc loads a valid file,
+  otherwise the factorization is redone and each proc (re)writes its file
+*/
+
+#define CACHE_MAGIC   0x58585443u /* "XXTC" */
+#define CACHE_VERSION 2u
+#define CACHE_MAX_NAME 256
+
+static char cache_prefix[CACHE_MAX_NAME] = "";
+
+void crs_cache(const char *prefix)
+{
+  size_t len = prefix ? strlen(prefix) : 0;
+  if(len>=CACHE_MAX_NAME)
+    fail(1,__FILE__,__LINE__,"crs_cache: prefix too long");
+  memcpy(cache_prefix,prefix,len), cache_prefix[len]='\0';
+}
+
+/* two independent 32-bit FNV-1a lanes; long long is avoided on purpose */
+static void hash_bytes(unsigned long h[2], const void *p, size_t n)
+{
+  const unsigned char *c = p;
+  unsigned long h0=h[0], h1=h[1];
+  for(;n;--n,++c) {
+    h0 = ((h0^*c)*0x01000193ul) & 0xfffffffful;
+    h1 = ((h1^*c)*0x01000193ul + 0x9e3779b9ul) & 0xfffffffful;
+  }
+  h[0]=h0, h[1]=h1;
+}
+
+static void setup_key(unsigned long key[2], const struct comm *comm,
+  uint n, const ulong *id,
+  uint nz, const uint *Ai, const uint *Aj, const double *A,
+  uint null_space)
+{
+  const uint head[5] = { comm->np, comm->id, n, nz, null_space };
+  key[0]=0x811c9dc5ul, key[1]=0x050c5d1ful;
+  hash_bytes(key,head,sizeof head);
+  hash_bytes(key,id,n*sizeof(ulong));
+  hash_bytes(key,Ai,nz*sizeof(uint));
+  hash_bytes(key,Aj,nz*sizeof(uint));
+  hash_bytes(key,A ,nz*sizeof(double));
+}
+
+static void cache_name(char *name, const unsigned long key[2], uint id)
+{
+  sprintf(name,"%sxxt_%08lx%08lx.%u",cache_prefix,key[0],key[1],(unsigned)id);
+}
+
+/* number of columns of X actually stored */
+static uint x_cols(const struct xxt *data)
+{
+  return data->null_space && data->xn ? data->xn-1 : data->xn;
+}
+
+#define CACHE_WRITE(p,n) (fwrite(p,sizeof(*(p)),n,f)!=(size_t)(n))
+#define CACHE_READ(p,n)  (fread (p,sizeof(*(p)),n,f)!=(size_t)(n))
+
+static void cache_write(const struct xxt *data, const unsigned long key[2])
+{
+  char name[CACHE_MAX_NAME+40];
+  const struct sparse_cholesky *fac = &data->fac_A_ll;
+  const struct csr_mat *A_sl = &data->A_sl;
+  const uint xc = x_cols(data);
+  const uint head[12] = { CACHE_MAGIC, CACHE_VERSION,
+    data->nsep, data->un, data->cn, data->ln, data->sn, data->xn,
+    fac->n, fac->Lrp[fac->n], A_sl->n, A_sl->Arp[A_sl->n] };
+  FILE *f;
+  int err;
+  cache_name(name,key,data->comm.id);
+  if(!(f = fopen(name,"wb"))) {
+    diagnostic("WARNING ",__FILE__,__LINE__,
+               "crs_cache: could not open %s for writing",name);
+    return;
+  }
+  err = CACHE_WRITE(key,2) || CACHE_WRITE(head,12)
+     || CACHE_WRITE(data->sep_size,data->nsep)
+     || CACHE_WRITE(data->perm_u2c,data->un)
+     || (data->null_space && CACHE_WRITE(data->share_weight,data->cn))
+     || CACHE_WRITE(fac->Lrp,fac->n+1+head[9])
+     || CACHE_WRITE(fac->D  ,fac->n  +head[9])
+     || CACHE_WRITE(fac->perm,fac->n)
+     || CACHE_WRITE(A_sl->Arp,A_sl->n+1+head[11])
+     || CACHE_WRITE(A_sl->A  ,head[11])
+     || CACHE_WRITE(data->Xp,xc+1)
+     || CACHE_WRITE(data->X ,data->Xp[xc]);
+  if(fclose(f) || err) {
+    diagnostic("WARNING ",__FILE__,__LINE__,
+               "crs_cache: error writing %s",name);
+    remove(name);
+  }
+}
+
+/* returns 1 on success; on failure nothing is left allocated */
+static int cache_read(struct xxt *data, const unsigned long key[2], uint un)
+{
+  char name[CACHE_MAX_NAME+40];
+  struct sparse_cholesky *fac = &data->fac_A_ll;
+  struct csr_mat *A_sl = &data->A_sl;
+  unsigned long fkey[2];
+  uint head[12], xc;
+  FILE *f;
+  cache_name(name,key,data->comm.id);
+  if(!(f = fopen(name,"rb"))) return 0;
+  if(CACHE_READ(fkey,2) || fkey[0]!=key[0] || fkey[1]!=key[1]
+     || CACHE_READ(head,12)
+     || head[0]!=CACHE_MAGIC || head[1]!=CACHE_VERSION
+     || head[2]!=data->nsep || head[3]!=un) { fclose(f); return 0; }
+  data->un=un, data->cn=head[4], data->ln=head[5], data->sn=head[6];
+  data->xn=head[7], fac->n=head[8], A_sl->n=head[10];
+  xc = x_cols(data);
+  data->sep_size = tmalloc(uint,data->nsep);
+  data->perm_u2c = tmalloc(sint,un);
+  data->share_weight = data->null_space ? tmalloc(double,data->cn) : 0;
+  fac->Lrp = tmalloc(uint,fac->n+1+head[9]), fac->Lj = fac->Lrp+fac->n+1;
+  fac->D   = tmalloc(double,fac->n+head[9]), fac->L  = fac->D+fac->n;
+  fac->perm = tmalloc(uint,fac->n);
+  A_sl->Arp = tmalloc(uint,A_sl->n+1+head[11]), A_sl->Aj = A_sl->Arp+A_sl->n+1;
+  A_sl->A   = tmalloc(double,head[11]);
+  data->Xp = tmalloc(uint,xc+1), data->X = 0;
+  if(CACHE_READ(data->sep_size,data->nsep)
+     || CACHE_READ(data->perm_u2c,un)
+     || (data->null_space && CACHE_READ(data->share_weight,data->cn))
+     || CACHE_READ(fac->Lrp,fac->n+1+head[9])
+     || CACHE_READ(fac->D  ,fac->n  +head[9])
+     || CACHE_READ(fac->perm,fac->n)
+     || CACHE_READ(A_sl->Arp,A_sl->n+1+head[11])
+     || CACHE_READ(A_sl->A  ,head[11])
+     || CACHE_READ(data->Xp,xc+1)) goto fail_read;
+  data->X = tmalloc(double,data->Xp[xc]);
+  if(CACHE_READ(data->X,data->Xp[xc]) || fgetc(f)!=EOF) goto fail_read;
+  fclose(f);
+  sparse_cholesky_restore(fac);
+  return 1;
+fail_read:
+  fclose(f);
+  free(data->sep_size), free(data->perm_u2c), free(data->share_weight);
+  free(fac->Lrp), free(fac->D), free(fac->perm);
+  free(A_sl->Arp), free(A_sl->A);
+  free(data->Xp), free(data->X);
+  return 0;
+}
+
+#undef CACHE_READ
+#undef CACHE_WRITE
+
+static void alloc_exec_buffers(struct xxt *data)
+{
+  data->vl = tmalloc(double,data->ln+data->cn+2*data->xn);
+  data->vc = data->vl+data->ln;
+  data->vx = data->vc+data->cn;
+  data->combuf = data->vx+data->xn;
+}
+
 struct xxt *crs_setup(
   uint n, const ulong *id,
   uint nz, const uint *Ai, const uint *Aj, const double *A,
@@ -717,6 +881,7 @@ struct xxt *crs_setup(
   struct array dofa;
   struct csr_mat A_ll, A_ss;
   buffer buf;
+  unsigned long key[2];
 
   comm_dup(&data->comm,comm);
 
@@ -724,6 +889,23 @@ struct xxt *crs_setup(
 
   data->null_space=null_space;
 
+  if(cache_prefix[0]) {
+    int ok;
+    setup_key(key,&data->comm,n,id,nz,Ai,Aj,A,null_space);
+    ok = cache_read(data,key,n);
+    if(comm_reduce_int(&data->comm,gs_min,&ok,1)) {
+      alloc_exec_buffers(data);
+      return data;
+    }
+    if(ok) {
+      free(data->sep_size), free(data->perm_u2c);
+      if(data->null_space) free(data->share_weight);
+      sparse_cholesky_free(&data->fac_A_ll);
+      free(data->A_sl.Arp), free(data->A_sl.A);
+      free(data->Xp), free(data->X);
+    }
+  }
+
   buffer_init(&buf,1024);
 
   discover_dofs(data,n,id,&dofa,&buf,&data->comm);
@@ -756,16 +938,15 @@ struct xxt *crs_setup(
                          &data->fac_A_ll, &buf);
   free(A_ll.Arp); free(A_ll.A);
 
-  data->vl = tmalloc(double,data->ln+data->cn+2*data->xn);
-  data->vc = data->vl+data->ln;
-  data->vx = data->vc+data->cn;
-  data->combuf = data->vx+data->xn;
+  alloc_exec_buffers(data);
 
   orthogonalize(data,&A_ss,perm_x2c,&buf);
   free(A_ss.Arp); free(A_ss.A);
   free(perm_x2c);
   buffer_free(&buf);
 
+  if(cache_prefix[0]) cache_write(data,key);
+
   return data;
 }
 
@@ -1,6 +1,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include "name.h"
 #include "fail.h"
 #include "types.h"
@@ -109,6 +110,7 @@ int main(int narg, char* arg[])
   if(np!=3) { puts("run with 3 procs"); exit(1); }
   id = comm.id;
 
+  crs_cache("xxt_test_");
   crs = crs_setup(nx[id], &x_id[id][0],
                   nz[id], &Ai[id][0], &Aj[id][0], &Ar[id][0],
                   0, &comm);
@@ -116,16 +118,30 @@ int main(int narg, char* arg[])
   crs_stats(crs);
   
   if(1) {
-    uint i,j; double xv[8];
+    uint i,j; double xv[8][8];
     for(i=0;i<8;++i) {
-      crs_solve(xv,crs,&bv[id][i][0]);
+      crs_solve(xv[i],crs,&bv[id][i][0]);
       printf("%d col %d:",id,i);
-      for(j=0;j<nx[id];++j) printf("\t%.4g",xv[j]);
+      for(j=0;j<nx[id];++j) printf("\t%.4g",xv[i][j]);
       printf("\n");
     }
+    crs_free(crs);
+
+    /* second setup is loaded from the files written by the first */
+    crs = crs_setup(nx[id], &x_id[id][0],
+                    nz[id], &Ai[id][0], &Aj[id][0], &Ar[id][0],
+                    0, &comm);
+    for(i=0;i<8;++i) {
+      double yv[8], diff=0;
+      crs_solve(yv,crs,&bv[id][i][0]);
+      for(j=0;j<nx[id];++j) if(fabs(yv[j]-xv[i][j])>diff)
+        diff=fabs(yv[j]-xv[i][j]);
+      if(diff>0) printf("%d col %d: cached setup differs by %g\n",id,i,diff);
+    }
   }
 
   crs_free(crs);
+  crs_cache("");
   comm_free(&comm);
 
 #ifdef MPI
@@ -124,6 +124,22 @@ c
 
       if(ifzper.or.ifgtp) call gfdm_elm_to_proc(gllnid,np) ! special processor map
 
+      call set_gllel
+c
+c     All Done.
+c
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine set_gllel
+
+c     Local numbering (gllel, lglel, nelt, nelv) for the current gllnid
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      common /ctmp0/ iwork(lelt)
+
 c     compute global to local map (no processor info)
 c
       if (.not. ifmoab) then
@@ -159,9 +175,7 @@ c
          ie   =gllel (ieg)
          if (mid.eq.nid) lglel(ie)=ieg
       enddo
-c
-c     All Done.
-c
+
       return
       end
 c-----------------------------------------------------------------------
@@ -388,3 +402,1230 @@ c-----------------------------------------------------------------------
       return
       end
 c-----------------------------------------------------------------------
+      subroutine part_chk
+
+c     Decide whether the mesh is partitioned in code (ifpart):
+c
+c        p147 = 0  :  read the .map file, RCB if there is none
+c        p147 = 1  :  recursive coordinate bisection (RCB)
+c        p147 = 2  :  recursive spectral bisection (RSB)
+c
+c     If so, gllnid is set to a block distribution for the first read
+c     of the mesh (see readat and part_mesh).
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'ZPER'
+
+      character*132 mapfle
+      logical ifmap
+      integer eg
+
+      ifpart = .false.
+      if (ifgfdm.or.ifgtp.or.ifzper) return
+
+      imap = 0
+      if (nid.eq.0 .and. param(147).le.0) then
+         lfname = ltrunc(reafle,132) - 4
+         call blank (mapfle,132)
+         call chcopy(mapfle,reafle,lfname)
+         call chcopy(mapfle(lfname+1:lfname+4),'.map',4)
+         inquire(file=mapfle,exist=ifmap)
+         if (ifmap) imap = 1
+      endif
+      imap = iglmax(imap,1)
+      if (param(147).le.0 .and. imap.eq.1) return
+
+      ifpart = .true.
+      do eg=1,nelgt
+         gllnid(eg) = ((eg-1)*int(np,8))/nelgt
+      enddo
+
+      ipart = max(1,int(param(147)))
+      if (nio.eq.0) write(6,*) 'partitioning mesh in code, p147 =',
+     $                         ipart
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_mesh
+
+c     Partition the mesh read with the block distribution of part_chk.
+c     The elements are bisected recursively over the ranks, by their
+c     centroids (RCB) and for p147 = 2 again by the Fiedler vector of
+c     the element graph (RSB), and migrate with their corners at each
+c     level.  The vertex ids come from the corner coordinates and the
+c     periodic faces (part_vert).  On return gllnid, gllel, lglel and
+c     vertex hold the new distribution; the mesh is then read again.
+
+      include 'SIZE'
+      include 'TOTAL'
+
+      common /ivrtx/ vertex ((2**ldim),lelt)
+      integer vertex
+
+c     element tuples:  vi = dest, eg, (eg,face) across 'P' x 6, ids(8)
+c                      vr = corner coordinates(3,8), weight
+      parameter (lpe=2*lelt,li=22,lr=25)
+      common /cpartm/ vr(lr,lpe),vi(li,lpe)
+      integer vi
+
+      integer e,f
+      character*3 cb
+      integer isym(8)
+      save    isym
+      data    isym / 1,2,4,3,5,6,8,7 /
+
+      real*8 dnekclock,t0
+
+      t0 = dnekclock()
+      nv = 2**ndim
+      nface = 2*ndim
+
+      do e=1,nelt
+         call izero(vi(1,e),li)
+         vi(2,e) = lglel(e)
+         do j=1,nv
+            vr(3*j-2,e) = xc(isym(j),e)
+            vr(3*j-1,e) = yc(isym(j),e)
+            vr(3*j  ,e) = 0.
+            if (if3d) vr(3*j,e) = zc(isym(j),e)
+         enddo
+         vr(lr,e) = 1.
+         do f=1,nface
+         do ifld=1,2
+            cb = cbc(f,e,ifld)
+            if (cb.eq.'P  '.or.cb.eq.'p  ') then
+               vi(1+2*f,e) = nint(bc(1,f,e,ifld))
+               vi(2+2*f,e) = nint(bc(2,f,e,ifld))
+            endif
+         enddo
+         enddo
+      enddo
+      n = nelt
+
+      nset = 1
+      if (nelgv.lt.nelgt) nset = 2   ! fluid and solid are cut apart
+      do iset=1,nset
+         call part_bisect(vi,li,vr,lr,n,lpe,iset,1,0)
+      enddo
+      call part_gllnid(vi,li,n)
+      call part_vert  (vi,li,vr,lr,n,nvg)
+
+      if (param(147).eq.2) then
+         do iset=1,nset
+            call part_bisect(vi,li,vr,lr,n,lpe,iset,2,nvg)
+         enddo
+         call part_gllnid(vi,li,n)
+      endif
+
+      nmax = iglmax(n,1)
+      if (nmax.gt.lelt) call exitti('part_mesh: increase lelt to $',
+     $                              nmax)
+      call set_gllel
+      nvmax = iglmax(nelv,1)
+      if (nvmax.gt.lelv) call exitti('part_mesh: increase lelv to $',
+     $                               nvmax)
+      do k=1,n
+         e = gllel(vi(2,k))
+         call icopy(vertex(1,e),vi(15,k),nv)
+      enddo
+      ifpart = .false.
+
+      nmin = iglmin(n,1)
+      if (nio.eq.0) write(6,1) nmin,nmax,nvg,dnekclock()-t0
+    1 format(' done :: partition, nelt min/max',2i9,', nvert',i11,
+     $       1pe12.4,' sec')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_gllnid(vi,li,n)
+
+c     gllnid of the elements in vi; gllel(eg) = k for the local ones
+
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer vi(li,n)
+      common /ctmp0/ iwork(lelt)
+      integer eg
+
+      call izero(gllnid,nelgt)
+      do k=1,n
+         eg = vi(2,k)
+         gllnid(eg) = nid+1
+         gllel (eg) = k
+      enddo
+      k = 1
+      do while (k.le.nelgt)
+         m = min(nelgt-k+1,lelt)
+         call igop(gllnid(k),iwork,'+  ',m)
+         k = k+m
+      enddo
+      do eg=1,nelgt
+         gllnid(eg) = gllnid(eg)-1
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_bisect(vi,li,vr,lr,n,lpe,iset,imode,nvg)
+
+c     Recursive bisection of the elements of set iset (1 = fluid,
+c     2 = solid) over all ranks: at each level the ranks [p0,p1) of a
+c     part split into two halves, the part is cut by the weighted
+c     median of c, and each element is sent to a rank of its half in
+c     order of its prefix weight.  Elements of the other set stay put.
+c     c is the centroid coordinate along the longest extent of the
+c     part (imode = 1, RCB) or the Fiedler vector (imode = 2, RSB).
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'mpif.h'
+
+      integer vi(li,lpe)
+      real    vr(lr,lpe)
+
+      common /nekmpi/ nid_,np_,nekcomm,nekgroup,nekreal
+      parameter (lpm=2*lelt)
+      common /cpartb/ c(lpm),w(lpm),kk(lpm),il(lpm),ieg(lpm)
+
+      integer p0,p1,eg
+      real wl(2),wt(2),ws(2)
+      integer*8 vl
+
+      nlev = 0
+      do while (2**nlev.lt.np)
+         nlev = nlev+1
+      enddo
+
+      p0 = 0
+      p1 = np
+      do lev=1,nlev
+         npg = p1-p0
+         nl  = npg/2
+         call mpi_comm_split(nekcomm,p0,nid,icg,ierr)
+
+         m = 0
+         do k=1,n
+            vi(1,k) = nid
+            eg = vi(2,k)
+            if ((iset.eq.1.and.eg.le.nelgv) .or.
+     $          (iset.eq.2.and.eg.gt.nelgv)) then
+               m = m+1
+               kk (m) = k
+               ieg(m) = eg
+               w  (m) = vr(lr,k)
+            endif
+         enddo
+
+         call part_axis(c,kk,m,vr,lr,icg)
+         if (imode.eq.2)
+     $      call part_fiedler(c,kk,m,vi,li,nvg,p0,npg,icg)
+
+         if (npg.gt.1) then
+            wt(1) = vlsum(w,m)
+            call part_gop(wt,ws,'+  ',1,icg)
+            t = wt(1)*nl/npg
+            call part_split(il,c,ieg,w,m,t,nelgt,icg)
+
+            wl(1) = 0.
+            wl(2) = 0.
+            do i=1,m
+               j = 2-il(i)
+               wl(j) = wl(j)+w(i)
+            enddo
+            call mpi_scan(wl,ws,2,nekreal,mpi_sum,icg,ierr)
+            ws(1) = ws(1)-wl(1)            ! weight on lower ranks
+            ws(2) = ws(2)-wl(2)
+            call copy    (wt,wl,2)
+            call part_gop(wt,wl,'+  ',2,icg)
+
+            do i=1,m
+               k = kk(i)
+               if (il(i).eq.1) then
+                  x = (ws(1)+0.5*w(i))*nl/wt(1)
+                  vi(1,k) = p0 + min(nl-1,int(x))
+                  ws(1) = ws(1)+w(i)
+               else
+                  x = (ws(2)+0.5*w(i))*(npg-nl)/wt(2)
+                  vi(1,k) = p0 + nl + min(npg-nl-1,int(x))
+                  ws(2) = ws(2)+w(i)
+               endif
+            enddo
+
+            if (nid.lt.p0+nl) then
+               p1 = p0+nl
+            else
+               p0 = p0+nl
+            endif
+         endif
+         call mpi_comm_free(icg,ierr)
+
+         call crystal_tuple_transfer(cr_h,n,lpe,vi,li,vl,0,vr,lr,1)
+         nmax = iglmax(n,1)
+         if (nmax.gt.lpe) call exitti('part_bisect: increase lelt $',
+     $                                nmax)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_axis(c,kk,m,vr,lr,icg)
+
+c     c = centroid coordinate along the longest extent of the part
+
+      include 'SIZE'
+
+      real c(m),vr(lr,1)
+      integer kk(m)
+      real b(6),bw(6)
+
+      nv = 2**ndim
+      do id=1,6
+         b(id) = -1.e30
+      enddo
+      do i=1,m
+         k = kk(i)
+         do id=1,3
+            x = 0.
+            do j=1,nv
+               x = x+vr(3*j-3+id,k)
+            enddo
+            x = x/nv
+            b(id  ) = max(b(id  ),-x)
+            b(id+3) = max(b(id+3), x)
+         enddo
+      enddo
+      call part_gop(b,bw,'M  ',6,icg)
+
+      id = 1
+      do jd=2,ndim
+         if (b(jd+3)+b(jd).gt.b(id+3)+b(id)) id = jd
+      enddo
+      do i=1,m
+         k = kk(i)
+         x = 0.
+         do j=1,nv
+            x = x+vr(3*j-3+id,k)
+         enddo
+         c(i) = x/nv
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_split(il,c,ieg,w,m,t,nelgt,icg)
+
+c     Weighted median on communicator icg: il(i) = 1 for the elements
+c     with the smallest c (ties broken by eg) adding up to weight t
+
+      integer il(m),ieg(m)
+      real    c(m),w(m)
+      real    x(2),y(2)
+
+      x(1) = -1.e30
+      x(2) = -1.e30
+      do i=1,m
+         x(1) = max(x(1),-c(i))
+         x(2) = max(x(2), c(i))
+      enddo
+      call part_gop(x,y,'M  ',2,icg)
+      clo = -x(1) - 1. - abs(x(1))          ! below all c
+      chi =  x(2)
+
+      do it=1,64                      ! w{c<=clo} < t <= w{c<=chi}
+         cut = 0.5*(clo+chi)
+         s = 0.
+         do i=1,m
+            if (c(i).le.cut) s = s+w(i)
+         enddo
+         call part_gop(s,y,'+  ',1,icg)
+         if (s.ge.t) then
+            chi = cut
+         else
+            clo = cut
+         endif
+      enddo
+
+      s = 0.
+      do i=1,m
+         if (c(i).le.clo) s = s+w(i)
+      enddo
+      call part_gop(s,y,'+  ',1,icg)
+      r = t-s                               ! from the ties, by eg
+
+      jlo = 0
+      jhi = nelgt
+      if (r.le.0) jhi = 0
+      do it=1,32
+         j = (jlo+jhi)/2
+         s = 0.
+         do i=1,m
+            if (c(i).gt.clo.and.c(i).le.chi.and.ieg(i).le.j) s = s+w(i)
+         enddo
+         call part_gop(s,y,'+  ',1,icg)
+         if (s.ge.r) then
+            jhi = j
+         else
+            jlo = j
+         endif
+      enddo
+
+      do i=1,m
+         il(i) = 0
+         if (c(i).le.clo) il(i) = 1
+         if (c(i).le.chi.and.ieg(i).le.jhi) il(i) = 1
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_fiedler(c,kk,m,vi,li,nvg,p0,npg,icg)
+
+c     Fiedler vector of the element graph of the part (elements sharing
+c     a vertex are neighbors), by Lanczos on the graph Laplacian with
+c     full reorthogonalization and the constant vector deflated.  On
+c     entry c holds the start vector.  The Laplacian is applied through
+c     one gs handle on nekcomm for all parts, so every rank calls this
+c     routine, including those of parts that are not split (npg = 1).
+
+      include 'SIZE'
+      include 'PARALLEL'
+
+      common /nekmpi/ nid_,np_,nekcomm,nekgroup,nekreal
+
+      integer kk(m),vi(li,1),p0
+      real    c(m)
+
+      parameter (lpe=2*lelt,mlan=40)
+      common /cpartf/ q(lpe,mlan+1),y(lpe),cnt(8*lpe),ul(8*lpe)
+      common /cparti/ ids(8*lpe)
+      integer*8 ids
+
+      real al(mlan),be(mlan),d(mlan),e(mlan),z(mlan,mlan),wk(2*mlan)
+      real s(mlan+2),sw(mlan+2)
+
+      nv = 2**ndim
+      l  = 0
+      do i=1,m
+         k = kk(i)
+         do j=1,nv
+            l = l+1
+            ids(l) = 0
+            if (npg.gt.1) ids(l) = vi(14+j,k) + int(nvg,8)*p0
+         enddo
+      enddo
+      call gs_setup(ih,ids,nv*m,nekcomm,np)
+      call rone    (cnt,nv*m)
+      call gs_op   (ih,cnt,1,1,0)           ! corner multiplicity
+
+      s(1) = vlsum(c,m)
+      s(2) = m
+      call part_gop(s,sw,'+  ',2,icg)
+      cm = 0.
+      if (s(2).gt.0) cm = s(1)/s(2)
+      do i=1,m
+         q(i,1) = c(i)-cm + 1.e-3*(mod(kk(i)*0.618034,1.)-0.5)
+      enddo
+      s(1) = vlsc2(q,q,m)
+      call part_gop(s,sw,'+  ',1,icg)
+      mg = mlan
+      if (s(1).le.0) mg = 0
+      if (mg.gt.0) call cmult(q,1./sqrt(s(1)),m)
+
+      bprev = 0.
+      do it=1,mlan
+         call part_lap(y,q(1,it),m,nv,cnt,ul,ih)
+         if (it.le.mg) then
+            s(1) = vlsc2(y,q(1,it),m)
+            call part_gop(s,sw,'+  ',1,icg)
+            a = s(1)
+            do i=1,m
+               y(i) = y(i)-a*q(i,it)
+               if (it.gt.1) y(i) = y(i)-bprev*q(i,it-1)
+            enddo
+            do jt=1,it                      ! reorthogonalize
+               s(jt) = vlsc2(y,q(1,jt),m)
+            enddo
+            s(it+1) = vlsum(y,m)
+            s(it+2) = m
+            call part_gop(s,sw,'+  ',it+2,icg)
+            do jt=1,it
+               call add2s2(y,q(1,jt),-s(jt),m)
+            enddo
+            call cadd(y,-s(it+1)/s(it+2),m)
+            s(1) = vlsc2(y,y,m)
+            call part_gop(s,sw,'+  ',1,icg)
+            b = sqrt(s(1))
+            al(it) = a
+            be(it) = b
+            if (b.le.1.e-8*(abs(a)+bprev)) then
+               mg = it                      ! invariant subspace
+            else
+               call copy(q(1,it+1),y,m)
+               call cmult(q(1,it+1),1./b,m)
+            endif
+            bprev = b
+         endif
+      enddo
+      call gs_free(ih)
+
+      if (mg.eq.0) return
+      call copy(d,al,mg)
+      call copy(e,be,mg-1)
+      if (ifdblas) then
+         call dsteqr('I',mg,d,e,z,mlan,wk,info)
+      else
+         call ssteqr('I',mg,d,e,z,mlan,wk,info)
+      endif
+      if (info.ne.0) call exitti('part_fiedler: steqr failed $',info)
+
+      call rzero(c,m)                       ! smallest Ritz vector
+      do jt=1,mg
+         call add2s2(c,q(1,jt),z(jt,1),m)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_lap(y,x,m,nv,cnt,ul,ih)
+
+c     y = L x, L = element graph Laplacian (one edge per shared vertex)
+
+      real y(m),x(m),cnt(nv,m),ul(nv,m)
+
+      do i=1,m
+      do j=1,nv
+         ul(j,i) = x(i)
+      enddo
+      enddo
+      call gs_op(ih,ul,1,1,0)
+      do i=1,m
+         y(i) = 0.
+         do j=1,nv
+            y(i) = y(i) + cnt(j,i)*x(i)-ul(j,i)
+         enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_vert(vi,li,vr,lr,n,nvg)
+
+c     Vertex ids from the corner coordinates: corners that agree to a
+c     tolerance (a tenth of the shortest corner distance of either
+c     element) are one vertex.  Corners within reach of another rank's
+c     box are copied there, so that each rank sees all the copies of
+c     its own corners.  Ids are merged across 'P' faces (part_per) and
+c     numbered 1..nvg.
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+
+      integer vi(li,n)
+      real    vr(lr,n)
+
+      parameter (lpt=16*lelt)
+      common /cpartv/ rp(4,lpt),a(lpt),ip(3,lpt),ind(lpt),iperm(lpt)
+     $              , iw(lpt),iseg(lpt)
+      common /cpartx/ bb(6,0:lp-1),bw(6,0:lp-1)
+      integer*8 vl
+      real b(6)
+
+      nv  = 2**ndim
+      big = 1.e30
+      do id=1,3
+         b(id  ) =  big
+         b(id+3) = -big
+      enddo
+
+      tmax = 0.
+      npt  = 0
+      do k=1,n
+         d2 = big
+         do j=2,nv
+         do l=1,j-1
+            d = 0.
+            do id=1,3
+               d = d + (vr(3*j-3+id,k)-vr(3*l-3+id,k))**2
+            enddo
+            d2 = min(d2,d)
+         enddo
+         enddo
+         tol  = 0.1*sqrt(d2)
+         tmax = max(tmax,tol)
+         do j=1,nv
+            npt = npt+1
+            ip(1,npt) = nid
+            ip(2,npt) = (k-1)*nv+j               ! home location
+            ip(3,npt) = (vi(2,k)-1)*nv+j         ! unique id
+            do id=1,3
+               x = vr(3*j-3+id,k)
+               rp(id,npt) = x
+               b(id  ) = min(b(id  ),x)
+               b(id+3) = max(b(id+3),x)
+            enddo
+            rp(4,npt) = tol
+         enddo
+      enddo
+
+      call rzero(bb,6*np)                       ! boxes within reach
+      do id=1,3
+         bb(id  ,nid) = b(id  )-tmax
+         bb(id+3,nid) = b(id+3)+tmax
+      enddo
+      call gop(bb,bw,'+  ',6*np)
+
+      nown = npt
+      ierr = 0
+      do ir=0,np-1
+         iov = 0
+         if (ir.ne.nid) iov = 1
+         do id=1,3
+            if (bb(id,ir).gt.bb(id+3,nid) .or.
+     $          bb(id+3,ir).lt.bb(id,nid)) iov = 0
+         enddo
+         if (iov.eq.1) then
+            do i=1,nown
+               iin = 1
+               do id=1,3
+                  if (rp(id,i).lt.bb(id,ir) .or.
+     $                rp(id,i).gt.bb(id+3,ir)) iin = 0
+               enddo
+               if (iin.eq.1 .and. npt.lt.lpt) then
+                  npt = npt+1
+                  ip(1,npt) = ir
+                  ip(2,npt) = 0                  ! a copy
+                  ip(3,npt) = ip(3,i)
+                  call copy(rp(1,npt),rp(1,i),4)
+               elseif (iin.eq.1) then
+                  ierr = 1
+               endif
+            enddo
+         endif
+      enddo
+      call err_chk(ierr,'part_vert: increase lelt (copies)$')
+
+      call crystal_tuple_transfer(cr_h,npt,lpt,ip,3,vl,0,rp,4,1)
+      nmax = iglmax(npt,1)
+      if (nmax.gt.lpt) call exitti('part_vert: increase lelt $',nmax)
+
+c     Sort by x, split where consecutive points are out of tolerance,
+c     then by y within each segment, then by z.
+
+      do i=1,npt
+         iperm(i) = i
+         iseg (i) = 0
+      enddo
+      if (npt.gt.0) iseg(1) = 1
+      do id=1,ndim
+         i0 = 1
+         do i1=1,npt
+            iend = 0
+            if (i1.eq.npt) then
+               iend = 1
+            elseif (iseg(i1+1).eq.1) then
+               iend = 1
+            endif
+            if (iend.eq.1) then
+               m = i1-i0+1
+               do l=1,m
+                  a(l) = rp(id,iperm(i0+l-1))
+               enddo
+               call sort(a,ind,m)
+               do l=1,m
+                  iw(l) = iperm(i0+ind(l)-1)
+               enddo
+               do l=1,m
+                  iperm(i0+l-1) = iw(l)
+               enddo
+               do l=2,m
+                  tol = min(rp(4,iw(l)),rp(4,iw(l-1)))
+                  if (a(l)-a(l-1).gt.tol) iseg(i0+l-1) = 1
+               enddo
+               i0 = i1+1
+            endif
+         enddo
+      enddo
+
+      i0 = 1                           ! id = smallest id of the group
+      do i1=1,npt
+         iend = 0
+         if (i1.eq.npt) then
+            iend = 1
+         elseif (iseg(i1+1).eq.1) then
+            iend = 1
+         endif
+         if (iend.eq.1) then
+            lmin = ip(3,iperm(i0))
+            do l=i0+1,i1
+               lmin = min(lmin,ip(3,iperm(l)))
+            enddo
+            do l=i0,i1
+               i = iperm(l)
+               if (ip(1,i).eq.nid .and. ip(2,i).gt.0) then
+                  k = (ip(2,i)-1)/nv + 1
+                  j = ip(2,i) - (k-1)*nv
+                  vi(14+j,k) = lmin
+               endif
+            enddo
+            i0 = i1+1
+         endif
+      enddo
+
+      call part_per(vi,li,vr,lr,n)
+
+      l = 0
+      do k=1,n
+      do j=1,nv
+         l = l+1
+         ip(3,l) = vi(14+j,k)
+      enddo
+      enddo
+      call gbtuple_rank(ip,3,nv*n,lpt,cr_h,nid,np,ind)
+      nvg = 0
+      l = 0
+      do k=1,n
+      do j=1,nv
+         l = l+1
+         vi(14+j,k) = ip(3,l)
+         nvg = max(nvg,ip(3,l))
+      enddo
+      enddo
+      nvg = iglmax(nvg,1)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_per(vi,li,vr,lr,n)
+
+c     Merge vertex ids across 'P' faces.  Each face gets the corners
+c     and ids of the face it connects to, the corners are paired by the
+c     translation between the face centroids, and the smaller id of
+c     each pair spreads over the vertices it connects (gs min).
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+
+      common /nekmpi/ nid_,np_,nekcomm,nekgroup,nekreal
+
+      integer vi(li,n)
+      real    vr(lr,n)
+
+      parameter (lpe=2*lelt,lpf=6*lpe)
+      common /cpartp/ rq(12,lpf),iq(9,lpf),ipr(4*lpf),iu(8*lpe+4*lpf)
+      common /cpartq/ ids(8*lpe+4*lpf)
+      integer*8 ids,vl
+
+      integer f,fn,egn,c,cn
+      real s(3),t(3)
+      integer fcrn(4,6),fcrn2(2,4)
+      save    fcrn,fcrn2
+      data    fcrn  / 1,2,5,6, 2,4,6,8, 3,4,7,8,
+     $                1,3,5,7, 1,2,3,4, 5,6,7,8 /
+      data    fcrn2 / 1,2, 2,4, 3,4, 1,3 /
+
+      nv    = 2**ndim
+      nvf   = 2**(ndim-1)
+      nface = 2*ndim
+
+      nq = 0
+      do k=1,n
+      do f=1,nface
+         egn = vi(1+2*f,k)
+         if (egn.gt.0) then
+            nq = nq+1
+            iq(1,nq) = gllnid(egn)
+            iq(2,nq) = k
+            iq(3,nq) = f
+            iq(4,nq) = egn
+            iq(5,nq) = vi(2+2*f,k)
+         endif
+      enddo
+      enddo
+      if (iglmax(nq,1).eq.0) return
+
+      call crystal_tuple_transfer(cr_h,nq,lpf,iq,9,vl,0,rq,12,1)
+      nmax = iglmax(nq,1)
+      if (nmax.gt.lpf) call exitti('part_per: increase lelt $',nmax)
+      do i=1,nq                              ! answer with face iq(5)
+         k  = gllel(iq(4,i))
+         fn = iq(5,i)
+         do c=1,nvf
+            j = fcrn(c,fn)
+            if (ndim.eq.2) j = fcrn2(c,fn)
+            iq(5+c,i) = vi(14+j,k)
+            call copy(rq(3*c-2,i),vr(3*j-2,k),3)
+         enddo
+      enddo
+      call crystal_tuple_transfer(cr_h,nq,lpf,iq,9,vl,0,rq,12,1)
+
+      nall = nv*n
+      npr  = 0
+      do i=1,nq
+         k = iq(2,i)
+         f = iq(3,i)
+         call rzero(s,3)
+         call rzero(t,3)
+         do c=1,nvf
+            j = fcrn(c,f)
+            if (ndim.eq.2) j = fcrn2(c,f)
+            call add2(s,vr(3*j-2,k),3)
+            call add2(t,rq(3*c-2,i),3)
+         enddo
+         do c=1,nvf
+            j = fcrn(c,f)
+            if (ndim.eq.2) j = fcrn2(c,f)
+            dmin = 1.e30
+            do ic=1,nvf                      ! nearest translated corner
+               d = 0.
+               do id=1,3
+                  x = vr(3*j-3+id,k) + (t(id)-s(id))/nvf
+                  d = d + (x-rq(3*ic-3+id,i))**2
+               enddo
+               if (d.lt.dmin) then
+                  dmin = d
+                  cn   = ic
+               endif
+            enddo
+            npr = npr+1
+            ipr(npr) = (k-1)*nv+j
+            ids(nall+npr) = iq(5+cn,i)
+         enddo
+      enddo
+
+      l = 0
+      do k=1,n
+      do j=1,nv
+         l = l+1
+         iu (l) = vi(14+j,k)
+         ids(l) = iu(l)
+      enddo
+      enddo
+      call gs_setup(ih,ids,nall+npr,nekcomm,np)
+
+      ichg = 1
+      do while (ichg.gt.0)
+         do i=1,npr
+            iu(nall+i) = iu(ipr(i))
+         enddo
+         call gs_op(ih,iu,2,3,0)
+         ichg = 0
+         do i=1,npr
+            if (iu(nall+i).lt.iu(ipr(i))) then
+               iu(ipr(i)) = iu(nall+i)
+               ichg = 1
+            endif
+         enddo
+         ichg = iglmax(ichg,1)
+      enddo
+      call gs_free(ih)
+
+      l = 0
+      do k=1,n
+      do j=1,nv
+         l = l+1
+         vi(14+j,k) = iu(l)
+      enddo
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_gop(x,w,op,n,icomm)
+
+c     gop on communicator icomm
+
+      include 'mpif.h'
+      common /nekmpi/ nid,np,nekcomm,nekgroup,nekreal
+
+      real x(n),w(n)
+      character*3 op
+
+      if (op.eq.'+  ') then
+         call mpi_allreduce (x,w,n,nekreal,mpi_sum,icomm,ierr)
+      elseif (op.eq.'M  ') then
+         call mpi_allreduce (x,w,n,nekreal,mpi_max,icomm,ierr)
+      elseif (op.eq.'m  ') then
+         call mpi_allreduce (x,w,n,nekreal,mpi_min,icomm,ierr)
+      else
+         write(6,*) nid,' OP ',op,' not supported.  ABORT in part_gop.'
+         call exitt
+      endif
+      call copy(x,w,n)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_rebal
+
+c     Dynamic load balancing, every p148 steps.  The load of an element
+c     is elwgt(e) if the user sets it (on any rank), otherwise the
+c     rank's time outside dssum and gop since the last check divided
+c     by nelt.  If the largest rank load exceeds the mean by more than
+c     p149 (default 0.1) the elements are partitioned again as for p147
+c     (part_bisect, weighted).  If that lowers the largest load by at
+c     least half of p149 the elements move to their new ranks with the
+c     mesh, boundary conditions, solution state and the avg_all
+c     statistics (part_move).  The topology, geometry and pressure
+c     solver are set up again, and nrebal is incremented so that point
+c     searches can be redone.
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'CTIMER'
+      include 'ORTHOP'
+      include 'RESTART'
+      include 'ZPER'
+      include 'AVG'
+
+      common /ivrtx/ vertex ((2**ldim),lelt)
+      integer vertex
+
+      parameter (lpe=2*lelt,li=22,lr=25)
+      common /cpartm/ vr(lr,lpe),vi(li,lpe)
+      integer vi
+
+      common /orthoi/ nprev,mprev
+
+      parameter (lch=18*(ldimt1+1)+12)      ! cbc and ccurve
+      common /cpartc/ ich(lch,lelt)
+
+      integer e,f
+      logical ifwarn
+      real*8  tnow,tlast,trb
+      save    ifwarn,tlast,tcom0
+      data    ifwarn /.true./
+      data    tlast  /-1./
+
+      if (param(148).le.0) return
+
+      tnow = dnekclock()
+      tcom = tdsum + tgop
+      if (tlast.lt.0) then
+         tlast = tnow
+         tcom0 = tcom
+         return
+      endif
+      if (mod(istep,int(param(148))).ne.0) return
+
+      if (ifmvbd.or.ifmhd.or.ifpert.or.ifcmt.or.ifchar.or.ifcvode
+     $    .or.ifneknek.or.ifmoab.or.ifgfdm.or.ifgtp.or.ifaxis
+     $    .or.ifstrs) then
+         if (nio.eq.0.and.ifwarn) write(6,*)
+     $      'WARNING: no load balancing for this case (p148)'
+         ifwarn = .false.
+         return
+      endif
+
+      tc    = (tnow-tlast) - (tcom-tcom0)   ! compute time of this rank
+      tlast = tnow
+      tcom0 = tcom
+
+      wu = glmax(elwgt,nelt)
+      wr = 0.
+      do e=1,nelt
+         w = tc/max(nelt,1)
+         if (wu.gt.0) w = elwgt(e)
+         wr = wr + w
+         vr(lr,e) = w
+      enddo
+      wmax = glmax(wr,1)
+      wmean = glsum(wr,1)/np
+      tol  = param(149)
+      if (tol.le.0) tol = 0.1
+      if (wmax.le.(1.+tol)*wmean) return
+
+      trb = dnekclock_sync()
+
+      nv = 2**ndim
+      do e=1,nelt
+         call izero(vi(1,e),li)
+         vi(2,e) = lglel(e)
+         do j=1,nv
+            vr(3*j-2,e) = xc(j,e)
+            vr(3*j-1,e) = yc(j,e)
+            vr(3*j  ,e) = 0.
+            if (if3d) vr(3*j,e) = zc(j,e)
+            vi(14+j,e) = vertex(j,e)
+         enddo
+      enddo
+      n = nelt
+      nvg = iglmax(vertex,nv*nelt)
+
+      imode = 1
+      if (param(147).eq.2) imode = 2
+      nset  = 1
+      if (nelgv.lt.nelgt) nset = 2
+      do iset=1,nset
+         call part_bisect(vi,li,vr,lr,n,lpe,iset,imode,nvg)
+      enddo
+
+      nvl = 0
+      wr  = 0.
+      do k=1,n
+         if (vi(2,k).le.nelgv) nvl = nvl+1
+         wr = wr + vr(lr,k)
+      enddo
+      wnew = glmax(wr,1)
+      if (wnew.gt.wmax-0.5*tol*wmean) return     ! not worth the move
+      nmax  = iglmax(n,1)
+      nvmax = iglmax(nvl,1)
+      if (nmax.gt.lelt .or. nvmax.gt.lelv) then
+         if (nio.eq.0) write(6,*)
+     $      'WARNING: no rebalance, increase lelt to',nmax
+         return
+      endif
+      if (nio.eq.0) write(6,1) istep,wmax/wmean,wnew/wmean
+    1 format(i9,' rebalance, load max/avg',2f9.4)
+
+      nelt0 = nelt
+      call part_plan(lglel,nelt,nelv)           ! old distribution
+      call part_gllnid(vi,li,n)                 ! new owners
+      call set_gllel
+
+c     Move the mesh, boundary conditions and state
+
+      nxyz = lx1*ly1*lz1
+      call part_move(xm1,nxyz,2)
+      call part_move(ym1,nxyz,2)
+      call part_move(zm1,nxyz,2)
+      call part_move(xc,8,2)
+      call part_move(yc,8,2)
+      call part_move(zc,8,2)
+      call part_move(curve,72,2)
+      do ifld=0,ldimt1
+         call part_move(bc(1,1,1,ifld),30,2)
+      enddo
+      call part_move (elwgt,1,2)
+      call part_imove(vertex,nv,2)
+
+      do e=1,nelt0                              ! characters as integers
+         l = 0
+         do ifld=0,ldimt1
+         do f=1,6
+         do j=1,3
+            l = l+1
+            ich(l,e) = ichar(cbc(f,e,ifld)(j:j))
+         enddo
+         enddo
+         enddo
+         do j=1,12
+            ich(l+j,e) = ichar(ccurve(j,e))
+         enddo
+      enddo
+      call part_imove(ich,lch,2)
+      do e=1,nelt
+         l = 0
+         do ifld=0,ldimt1
+         do f=1,6
+         do j=1,3
+            l = l+1
+            cbc(f,e,ifld)(j:j) = char(ich(l,e))
+         enddo
+         enddo
+         enddo
+         do j=1,12
+            ccurve(j,e) = char(ich(l+j,e))
+         enddo
+      enddo
+
+      nxyz2 = lx2*ly2*lz2
+      if (ifflow) then
+         call part_move(vx  ,nxyz,1)
+         call part_move(vy  ,nxyz,1)
+         if (if3d) call part_move(vz,nxyz,1)
+         call part_move(pr  ,nxyz2,1)
+         call part_move(abx1,nxyz,1)
+         call part_move(aby1,nxyz,1)
+         call part_move(abx2,nxyz,1)
+         call part_move(aby2,nxyz,1)
+         if (if3d) call part_move(abz1,nxyz,1)
+         if (if3d) call part_move(abz2,nxyz,1)
+         do k=1,2
+            call part_move(vxlag(1,1,1,1,k),nxyz,1)
+            call part_move(vylag(1,1,1,1,k),nxyz,1)
+            if (if3d) call part_move(vzlag(1,1,1,1,k),nxyz,1)
+         enddo
+         do k=1,lorder2
+            call part_move(prlag(1,1,1,1,k),nxyz2,1)
+         enddo
+         call part_move(usrdiv,nxyz2,2)
+      endif
+      do j=1,nfield-1                       ! temperature and scalars
+         call part_move(t(1,1,1,1,j)      ,nxyz,2)
+         call part_move(vgradt1(1,1,1,1,j),nxyz,2)
+         call part_move(vgradt2(1,1,1,1,j),nxyz,2)
+         do k=1,lorder-1
+            call part_move(tlag(1,1,1,1,k,j),nxyz,2)
+         enddo
+      enddo
+      if (ax1.eq.lx1 .and. ax2.eq.lx2) then ! statistics of avg_all
+         call part_move(uavg,nxyz,1)
+         call part_move(vavg,nxyz,1)
+         call part_move(wavg,nxyz,1)
+         call part_move(pavg,nxyz2,1)
+         call part_move(urms,nxyz,1)
+         call part_move(vrms,nxyz,1)
+         call part_move(wrms,nxyz,1)
+         call part_move(prms,nxyz2,1)
+         call part_move(uvms,nxyz,1)
+         call part_move(vwms,nxyz,1)
+         call part_move(wums,nxyz,1)
+         do j=1,ldimt
+            call part_move(tavg(1,1,1,1,j),nxyz,2)
+            call part_move(trms(1,1,1,1,j),nxyz,2)
+         enddo
+      endif
+
+c     Set up again what depends on the distribution
+
+      do ifld=1,nfield                      ! not ifield (TSTEP)
+         nelfld(ifld) = nelv
+         if (iftmsh(ifld)) nelfld(ifld) = nelt
+      enddo
+      if (gsh_fld(2).ne.gsh_fld(1)) call gs_free(gsh_fld(2))
+      call gs_free(gsh_fld(1))
+
+      call setup_topo
+      call geom_reset(1)
+      call bcmask
+      if (ifflow.and.iftran.and.solver_type.eq.'itr') then
+         call free_overlap
+         call set_overlap
+      endif
+      call setprop
+
+      napprox(2) = 0                        ! projection spaces
+      nprev      = 0
+      izipb      = 1                        ! next restart file: base
+      nrebal     = nrebal+1
+      if (param(145).gt.0) call buddy_take
+
+      trb = dnekclock_sync()-trb
+      nmin = iglmin(nelt,1)
+      if (nio.eq.0) write(6,2) istep,nmin,nmax,trb
+    2 format(i9,' done :: rebalance, nelt min/max',2i9,1pe12.4,' sec')
+
+      tlast = dnekclock()
+      tcom0 = tdsum + tgop
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_plan(lglel0,nelt0,nelv0)
+
+c     Remember the old distribution for part_move
+
+      include 'SIZE'
+
+      integer lglel0(nelt0)
+      common /cpartr/ lgl0(lelt),nt0,nv0,ivm(2,lelt)
+
+      nt0 = nelt0
+      nv0 = nelv0
+      call icopy(lgl0,lglel0,nelt0)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_move(u,nw,ifld)
+
+c     Move the elementwise data u(nw,e) of the distribution before the
+c     last rebalance (part_rebal) to the current one; ifld = 1 for
+c     fluid arrays (nelv elements), otherwise nelt elements.  Can be
+c     called from userchk for user arrays after nrebal has changed.
+
+      include 'SIZE'
+      include 'PARALLEL'
+
+      real u(nw,1)
+      common /cpartr/ lgl0(lelt),nt0,nv0,ivm(2,lelt)
+      integer*8 vl
+
+      call part_route(n,nmax,ifld)
+      call crystal_tuple_transfer(cr_h,n,nmax,ivm,2,vl,0,u,nw,1)
+
+      do i=1,n                              ! in place, by swaps
+  10     j = gllel(ivm(2,i))
+         if (j.ne.i) then
+            do l=1,nw
+               x      = u(l,i)
+               u(l,i) = u(l,j)
+               u(l,j) = x
+            enddo
+            k        = ivm(2,i)
+            ivm(2,i) = ivm(2,j)
+            ivm(2,j) = k
+            goto 10
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_imove(iu,nw,ifld)
+
+c     part_move for integer data; the rows travel as reals, so
+c     nw*isize must be a multiple of wdsize
+
+      include 'SIZE'
+      include 'PARALLEL'
+
+      integer iu(nw,1)
+      common /cpartr/ lgl0(lelt),nt0,nv0,ivm(2,lelt)
+      integer*8 vl
+
+      mw = (nw*isize)/wdsize
+      if (mw*wdsize.ne.nw*isize) call exitti('part_imove: odd nw $',nw)
+
+      call part_route(n,nmax,ifld)
+      call crystal_tuple_transfer(cr_h,n,nmax,ivm,2,vl,0,iu,mw,1)
+
+      do i=1,n
+  10     j = gllel(ivm(2,i))
+         if (j.ne.i) then
+            do l=1,nw
+               k       = iu(l,i)
+               iu(l,i) = iu(l,j)
+               iu(l,j) = k
+            enddo
+            k        = ivm(2,i)
+            ivm(2,i) = ivm(2,j)
+            ivm(2,j) = k
+            goto 10
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine part_route(n,nmax,ifld)
+
+c     Destination and global number of the old local elements
+
+      include 'SIZE'
+      include 'PARALLEL'
+
+      common /cpartr/ lgl0(lelt),nt0,nv0,ivm(2,lelt)
+      integer eg
+
+      n    = nt0
+      nmax = lelt
+      if (ifld.eq.1) n    = nv0
+      if (ifld.eq.1) nmax = lelv
+      do i=1,n
+         eg = lgl0(i)
+         ivm(1,i) = gllnid(eg)
+         ivm(2,i) = eg
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
@@ -936,6 +936,32 @@ c
       write ( *, '(a)' ) 'MPI_SEND - Error!'
       write ( *, '(a)' )  '  Should not send message to self.'
 
+      return
+      end
+      subroutine mpi_test ( irequest, flag, istatus, ierror )
+
+c*********************************************************************72
+c
+cc MPI_TEST tests for completion of an I/O request.
+c
+      implicit none
+
+      integer ierror
+      integer irequest
+      integer istatus
+      logical flag
+      integer MPI_FAILURE
+      parameter ( MPI_FAILURE = 1 )
+      integer MPI_SUCCESS
+      parameter ( MPI_SUCCESS = 0 )
+
+      flag = .true.
+      ierror = MPI_FAILURE
+
+      write ( *, '(a)' ) ' '
+      write ( *, '(a)' ) 'MPI_TEST - Error!'
+      write ( *, '(a)' ) '  Should not test on message from self.'
+
       return
       end
       subroutine mpi_wait ( irequest, istatus, ierror )
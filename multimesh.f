@@ -107,6 +107,12 @@ C     Intercommunications set up only for 2 sessions
 
          ifhigh=.true.
          call mpi_intercomm_merge(intercomm, ifhigh, iglobalcomm, ierr)
+
+c        Each session is contiguous in iglobalcomm
+         call mpi_comm_rank(iglobalcomm,nid_gc,ierr)
+         nid_neighbor0 = 0
+         if (nid_gc.eq.nid) nid_neighbor0 = npsess(idsess)
+         call crystal_setup(cr_neknek,iglobalcomm,np_global)
       
          ifneknek   = .true.
          ifneknekm  = .false.
@@ -124,6 +130,7 @@ C-----------------------------------------------------------------------
 
       include 'SIZE'
       include 'TOTAL'
+      include 'NEKNEK'
       integer iList_all(ldim+2,nmaxcom)
       real    pts(ldim,nmaxcom)
 
@@ -134,19 +141,26 @@ C-----------------------------------------------------------------------
 C     Set interpolation flag: points with bc = 'int' get intflag=1. 
 C     Boundary conditions are changed back to 'v' or 't'.
 
+C     The exchange pattern set up below is kept until the mesh moves
+C     (ifneknekm, see neknekmv)
+
       if (icalld.eq.0) then
          call set_intflag
          call neknekmv()
+         nreq_nn = 0
          icalld = icalld + 1
+      else
+         call get_values_wait
+         call neknekgsync()
       endif 
 
 c     Every processor sends all the points with intflag=1 to the processors 
 c     of remote session
 c     (send_points)
 
-C    Root processor receives all the boundary points from remote session
-C    and redistributes it among its processors for efficient 
-C    localization of points (recv_points)
+C    The points are dealt evenly among the processors of the remote 
+C    session for efficient localization of points, through the crystal
+C    router on iglobalcomm
 
       call exchange_points(pts,iList_all,npoints_all)
       
@@ -208,12 +222,7 @@ c-------------------------------------------------------------
       include 'TOTAL'
       include 'NEKUSE'
       include 'NEKNEK'
-      include 'mpif.h'
-      common /nekmpi/ mid,mp,nekcomm,nekgroup,nekreal
-      integer status(mpi_status_size)
       real    pts(ldim,nmaxcom)   
-      integer jsend((ldim+2)*nmaxl),jrecv((ldim+2)*nmaxl)
-      common /exchr/ rsend(ldim*nmaxl), rrecv(ldim*nmaxl) 
       integer iList_all(ldim+2,nmaxcom)
     
 C     Look for boundary points with Diriclet b.c. (candidates for
@@ -229,6 +238,10 @@ C     interpolation)
       nfaces = 2*ndim
       nel    = nelfld(ifield)
 
+C     Deal the points round-robin to the processors of remote session
+C     (for load balancing); column ldim+2 holds the destination rank 
+C     in iglobalcomm, the rest is the local identity (ix,iy,iz,iel)
+
       ip = 0
       do 2010 iel=1,nel
       do 2010 iface=1,nfaces
@@ -240,112 +253,42 @@ C     interpolation)
                call nekasgn (ix,iy,iz,iel)
                ip=ip+1
 
-               if (if3d) then
-                 jsend((ldim+2)*(ip-1)+1)=ix
-                 jsend((ldim+2)*(ip-1)+2)=iy
-                 jsend((ldim+2)*(ip-1)+3)=iz
-                 jsend((ldim+2)*(ip-1)+4)=iel
-                 jsend((ldim+2)*(ip-1)+5)=nid
-
-                 rsend(ldim*(ip-1)+1)=x
-                 rsend(ldim*(ip-1)+2)=y
-                 rsend(ldim*(ip-1)+3)=z
-               else
-                 jsend((ldim+2)*(ip-1)+1)=ix
-                 jsend((ldim+2)*(ip-1)+2)=iy
-                 jsend((ldim+2)*(ip-1)+3)=iel
-                 jsend((ldim+2)*(ip-1)+4)=nid
-
-                 rsend(ldim*(ip-1)+1)=x
-                 rsend(ldim*(ip-1)+2)=y
-               endif
-
-               if (ip.gt.nmaxl) then
+               if (ip.gt.nmaxl.or.ip.gt.nmaxcom) then
                   write(6,*) nid,
      &            ' ABORT: nbp (current ip) too large',ip,nmaxl
                   call exitt
                endif
 
+               iList_all(1,ip)=ix
+               iList_all(2,ip)=iy
+               if (if3d) iList_all(3,ip)=iz
+               iList_all(ldim+1,ip)=iel
+               iList_all(ldim+2,ip)=nid_neighbor0
+     &                             +mod(ip+nid,np_neighbor)
+
+               pts(1,ip)=x
+               pts(2,ip)=y
+               if (if3d) pts(3,ip)=z
+
   100       continue
          endif
  2010 continue
 
-      nbp = ip
-
-      call izero(iList_all,(ldim+2)*nmaxcom)
-      call rzero(pts,  ldim*nmaxcom)
-
-C     Send amount of points boundary points, its coordinates and 
-c     its local identities 
-C     to the the processors of remote session (for load balancing) 
-
-C     Determine amount of points to send to each processor
-
-      ndistrib = nbp/np_neighbor
-      iremainder = nbp - ndistrib*np_neighbor
-
-      ip=0
-      iaddress=1
-      iraddress=1
-
-      do id=0,np_neighbor-1
-        if(id.le.iremainder-1) then
-            nsend = ndistrib + 1
-            else 
-            nsend = ndistrib
-        endif
-
-         len=isize
-         call mpi_irecv (nrecv,len,mpi_byte, id, id, 
-     &                                    intercomm, msg,ierr)
-         call mpi_send  (nsend,len,mpi_byte, id, nid, 
-     &                                    intercomm, ierr)
-
-         call mpi_wait (msg,status,ierr)
-
-         len=(ldim+2)*nrecv*isize
-         call mpi_irecv (jrecv, len ,mpi_byte, id, 100+id, 
-     &                                     intercomm, msg, ierr)
-         len=(ldim+2)*nsend*isize
-         call mpi_send (jsend(iaddress),len,mpi_byte, id, 100+nid, 
-     &                                           intercomm, ierr)
-         iaddress=iaddress+(ldim+2)*nsend
-
-         call mpi_wait (msg, status, ierr)
-
-         len=ldim*nrecv*wdsize
-         call mpi_irecv (rrecv, len ,mpi_byte, id, 200+id, 
-     &                                  intercomm, msg, ierr)
-         len=ldim*nsend*wdsize
-         call mpi_send (rsend(iraddress),len,mpi_byte, id, 200+nid, 
-     &                                        intercomm, ierr)
-         iraddress=iraddress+ldim*nsend
+      n = ip
+      call crystal_tuple_transfer(cr_neknek,n,nmaxcom,iList_all,ldim+2
+     &                           ,vl,0,pts,ldim,ldim+2)
 
-         call mpi_wait (msg, status, ierr)
-
-         do n=1,nrecv
-            ip = ip + 1
-
-            if (ip.gt.nmaxcom) then
-               write(6,*) nid,'ABORT: increase nmaxcom',ip,nmaxcom
-               call exitt
-            endif
-
-            
-           do j=1,ldim+2
-              iList_all(j,ip)=jrecv((ldim+2)*(n-1)+j)
-           enddo
-           do j=1,ldim
-               pts(j,ip)=rrecv(ldim*(n-1)+j)
-           enddo
-
-         enddo ! n
-
-      enddo    ! id
+      if (n.gt.nmaxcom) then
+         write(6,*) nid,'ABORT: increase nmaxcom',n,nmaxcom
+         call exitt
+      endif
 
-      call neknekgsync()
+C     Column ldim+2 now holds the sending processor of remote session
+      do i=1,n
+         iList_all(ldim+2,i)=iList_all(ldim+2,i)-nid_neighbor0
+      enddo
 
-      npoints_all = ip    
+      npoints_all = n
 
       return
       end
@@ -355,21 +298,19 @@ C-------------------------------------------------------------------------
       include 'SIZE'
       include 'TOTAL'
       include 'NEKNEK'
-      include 'mpif.h'  
-      integer jsend((ldim+1)*nmaxl),jrecv((ldim+1)*nmaxl)
+      parameter (li=ldim+4)
       integer rcode_all(nmaxcom),elid_all(nmaxcom),proc_all(nmaxcom)
-      real    dist(nmaxcom)
       real    pts(ldim,nmaxcom)
       real    dist_all(nmaxcom)
       real    rst_all(nmaxcom*ldim)
       integer iList_all(ldim+2,nmaxcom)
-      character*3 CB
-      integer status(mpi_status_size)
-      logical ifcomm
+      integer ifw(li,nmaxcom),key(li)
+      real    rfw(ldim,nmaxcom)
 
-      integer icalld
-      save    icalld
-      data    icalld /0/
+      integer icalld,npts0
+      save    icalld,npts0
+      data    icalld,npts0 /0,-1/
+      save    rcode_all,elid_all,proc_all,rst_all,dist_all
 
       if (icalld.le.1) then
          icalld=icalld+1
@@ -380,21 +321,30 @@ C-------------------------------------------------------------------------
       call intpts_setup(-1.0,inth_multi) ! use default tolerance
         
 
-      call findpts(inth_multi,rcode_all,1,
-     &             proc_all,1,
-     &             elid_all,1,
-     &             rst_all,ndim,
-     &             dist_all,1,
-     &             pts(1,1),ndim,
-     &             pts(2,1),ndim,
-     &             pts(3,1),ndim,npoints_all)
-
-      ierror=0
-
-c     Rearrange arrays so that only the points which are found within 
-c     the mesh are marked for interpolation: those are truly internal 
-c     points (rcode_all=0) plus some of the "boundary points" 
-c     (rcode_all=1) which fall on the boundaries of the elements 
+      if (npoints_all.eq.npts0) then  ! start from the last locations
+         call findpts_update(inth_multi,rcode_all,1,
+     &                       proc_all,1,
+     &                       elid_all,1,
+     &                       rst_all,ndim,
+     &                       dist_all,1,
+     &                       pts(1,1),ndim,
+     &                       pts(2,1),ndim,
+     &                       pts(3,1),ndim,npoints_all)
+      else
+         call findpts(inth_multi,rcode_all,1,
+     &                proc_all,1,
+     &                elid_all,1,
+     &                rst_all,ndim,
+     &                dist_all,1,
+     &                pts(1,1),ndim,
+     &                pts(2,1),ndim,
+     &                pts(3,1),ndim,npoints_all)
+      endif
+      npts0 = npoints_all
+
+c     Keep only the points which are found within the mesh: those are
+c     truly internal points (rcode_all=0) plus some of the "boundary
+c     points" (rcode_all=1) which fall on the boundaries of the elements
 c     of another domain (essentially also internal points) or 
 c     wall or periodic boundaries 
 c
@@ -403,14 +353,12 @@ c     boundaries of another domain are treated with boundary
 c     conditions and not with interpolation routines, and are 
 c     therefore excluded.
 c
-c     rcode_all, proc_all ... npoints_all represent all boundary points,
-c     rcode, proc ... npoints - only interpolation points 
-c     (used by interpolation routines)
-c     Contained in a common block /multipts_r/, /multipts_i/ (in NEKNEK)
-
-C
-
-C     Exclude "true" boundary points 
+c     Each kept point goes to the processor owning its element, which
+c     evaluates it in get_values_start without further communication
+c     within the session, and sends the values straight to the remote
+c     processor which owns the point.  The point identities are sent
+c     there once here, so that each message of the exchange is a 
+c     contiguous block on both sides.
 
       if (ifflow) then
          ifield = 1
@@ -424,16 +372,11 @@ C     Exclude "true" boundary points
 
       call izero(imask,ntot) 
 
-      ip=0
-      icount=0
-      ierror=0
-
+      n=0
       do 100 i=1,npoints_all
          
       if (rcode_all(i).lt.2) then
 
-        iel  = elid_all(i) + 1
-
         if (rcode_all(i).eq.1.and.dist_all(i).gt.1e-02) then
            if (ndim.eq.2) write(6,'(A,3E15.7)') 
      &     'WARNING: point on boundary or outside the mesh xy[z]d^2: ',
@@ -443,166 +386,121 @@ C     Exclude "true" boundary points
      &     (pts(k,i),k=1,ndim),dist_all(i)  
            goto 100
          endif
-         ip=ip+1
-         rcode(ip) = rcode_all(i)
-         elid(ip)  = elid_all(i)
-         proc(ip)  = proc_all(i)
-         do j=1,ndim
-           rst(ndim*(ip-1)+j)   = rst_all(ndim*(i-1)+j)
+         n=n+1
+         ifw(1,n) = proc_all(i)
+         ifw(2,n) = elid_all(i)
+         do j=1,ldim+2
+           ifw(2+j,n) = iList_all(j,i)
          enddo
-         do n=1,ndim+1
-           iList(n,ip) = iList_all(n,i)
+         do j=1,ldim
+           rfw(j,n) = rst_all(ndim*(i-1)+j)
          enddo
-
-c        Check receiving remote processor id information 
-         n=ndim+2
-c        First point 
-         if (ip.eq.1) then
-            icount=1
-            infosend(icount,1)=iList_all(n,i)
-            infosend(icount,2)=ip
-            iprocp=iList_all(n,i)
-         else
-            iproc  = iList_all(n,i)
-            if (iproc.ne.iprocp) then
-             if (iproc.gt.iprocp) then
-               icount=icount+1
-               infosend(icount,1)=iproc
-               infosend(icount,2)=ip
-               iprocp=iproc
-             else
-               write(6,*) 'Attention: intrinsic sorting is not achieved'
-               write(6,'(a7,3i7,1x,a10)') 'switch', ip, 
-     &         iproc,iprocp, session
-               ierror = 1
-               goto 100
-             endif
-            endif
-         endif
       
       endif  !  rcode_all
 
  100  continue
 
-      call iglmax(ierror,1)
-      if (ierror.eq.1) call exitt
-
-      npoints=ip
-      npsend=icount
-
-c     Store point counts (infosend(:,2)) instead of pointers 
-
-      do n=2,npsend
-         ip=infosend(n-1,2)
-         ic=infosend(n,2)
-         infosend(n-1,2)=ic-ip
-      enddo
-      infosend(npsend,2)=npoints-infosend(npsend,2)+1
-
-      if (istep.eq.0) write(6,'(a7,i12,1x,a10)') 'found', npoints, 
+      if (istep.eq.0) write(6,'(a7,i12,1x,a10)') 'found', n, 
      &                     session
 
-c     Sending all processors information about the number 
-c     of receiving points, including zero points
-c     ifcomm=.false. means there are no more processors
-c     with non-zero receiving points (either if npsend=0 
-c     or if we already notified all the relevant processors)
-
-      if (npsend.eq.0) then
-         ifcomm=.false.
-      else
-         ifcomm=.true.
-         icount=1
-      endif   
+      call crystal_tuple_transfer(cr_h,n,nmaxcom,ifw,li,vl,0,rfw,ldim,1)
 
-      il=0
-      do id=0,np_neighbor-1
-
-         if (ifcomm) then
-
-            idsend=infosend(icount,1)
-
-            if (id.lt.idsend) then
-               nsend=0
-            elseif (id.eq.idsend) then
-               nsend=infosend(icount,2)
-               icount =icount+1
-            endif
-
-         else   !  not(ifcomm)
-            nsend=0
-         endif
-
-         if (ifcomm.and.(icount.gt.npsend)) ifcomm=.false.
-
-         len=isize   
-         call mpi_send (nsend,len,mpi_byte, id, nid, intercomm, ierr)
+      if (n.gt.nmaxcom) then
+         write(6,*) nid,'ABORT: increase nmaxcom',n,nmaxcom
+         call exitt
+      endif
 
-         if (nsend.ne.0) then
-c           Send the points identity to communicating processors
-            len=(ldim+1)*nsend*isize
-               do i=1,nsend
-               il=il+1
-               do j=1,ldim+1
-                  jsend((ldim+1)*(i-1)+j)=iList(j,il)
-               enddo
-            enddo   
+c     Sort by remote processor, then by remote identity (iel,iz,iy,ix)
+c     which orders the messages the same way on both sides
 
-            call mpi_send(jsend,len,mpi_byte,id,100+nid, intercomm,ierr)
+      key(1)=li
+      do j=2,ldim+2
+         key(j)=li+1-j
+      enddo
+      call crystal_tuple_sort(cr_h,n,ifw,li,vl,0,rfw,ldim,key,ldim+2)
 
+      npsend=0
+      do i=1,n
+         elid(i)=ifw(2,i)
+         do j=1,ldim
+            rst(ndim*(i-1)+j)=rfw(j,i)
+         enddo
+         do j=1,ldim+1
+            iList(j,i)=ifw(2+j,i)
+         enddo
+         id=ifw(li,i)
+         if (npsend.eq.0) then
+            npsend=1
+            infosend(npsend,1)=id
+            infosend(npsend,2)=0
+         elseif (id.ne.infosend(npsend,1)) then
+            npsend=npsend+1
+            infosend(npsend,1)=id
+            infosend(npsend,2)=0
          endif
+         infosend(npsend,2)=infosend(npsend,2)+1
+         ifw(1,i)=nid_neighbor0+id
+      enddo
+      npoints=n
 
-      enddo   
-
+c     Send the point identities to the remote processors, which mask
+c     their points received by interpolation with imask=1 
 
-c     Receive information about sending processors
- 6    irecvcnt=0
-      il=0
-      do id=0,np_neighbor-1
-         len=isize
+      call crystal_tuple_transfer(cr_neknek,n,nmaxcom,ifw,li,vl,0,rfw,0
+     &                           ,1)
 
-         call mpi_recv(nrecv,len,mpi_byte,id,id,intercomm,status,ierr)
+      if (n.gt.nmaxl.or.n.gt.nmaxcom) then
+         write(6,*) nid,'ABORT: increase nmaxl',n,nmaxl
+         call exitt
+      endif
 
-         if (nrecv.ne.0) then
-            irecvcnt=irecvcnt+1
-            inforecv(irecvcnt,1)=id
-            inforecv(irecvcnt,2)=nrecv
+      do i=1,n
+         ifw(1,i)=ifw(1,i)-nid_neighbor0
+      enddo
+      key(1)=1
+      call crystal_tuple_sort(cr_h,n,ifw,li,vl,0,rfw,0,key,ldim+2)
 
-c     Receive information about point identities
-            len=(ldim+1)*nrecv*isize
-            call mpi_recv
-     $        (jrecv,len,mpi_byte,id,100+id,intercomm,status,ierr)
-         
-c     Receiving processor nid masks which points he receives from 
-c     remote processor id as interpolation points using the identity 
-c     information contained in array 'jrecv'. Those points are masked 
-c     with imask=1 (imask=0 for all other points). 
-
-      do ii=1,nrecv
-         ix=jrecv((ldim+1)*(ii-1)+1)
-         iy=jrecv((ldim+1)*(ii-1)+2)
-         iz = 1
-         if (if3d) iz=jrecv((ldim+1)*(ii-1)+3)
-         ie=jrecv((ldim+1)*(ii-1)+ldim+1)
-         il=il+1
-            iden(1,il)=ix
-            iden(2,il)=iy
-            if (if3d) iden(3,il)=iz
-            iden(ldim+1,il)=ie
-            imask(ix,iy,iz,ie)=1
+      nprecv=0
+      do i=1,n
+         do j=1,ldim+1
+            iden(j,i)=ifw(2+j,i)
          enddo
+         ix=iden(1,i)
+         iy=iden(2,i)
+         iz=1
+         if (if3d) iz=iden(3,i)
+         ie=iden(ldim+1,i)
+         imask(ix,iy,iz,ie)=1
+
+         id=ifw(1,i)
+         if (nprecv.eq.0) then
+            nprecv=1
+            inforecv(nprecv,1)=id
+            inforecv(nprecv,2)=0
+         elseif (id.ne.inforecv(nprecv,1)) then
+            nprecv=nprecv+1
+            inforecv(nprecv,1)=id
+            inforecv(nprecv,2)=0
+         endif
+         inforecv(nprecv,2)=inforecv(nprecv,2)+1
+      enddo
 
-      endif  !  jrecv.ne.0
-      
-      enddo  !  all remote processors
+      return
+      end
+C----------------------------------------------------------------
+      subroutine get_values(which_field)
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+      character*3 which_field(nfld_neknek)
 
-      nprecv=irecvcnt
+      call get_values_start(which_field)
+      call get_values_wait
 
-      call neknekgsync()
       return
       end
 C----------------------------------------------------------------
-      subroutine get_values(which_field)
+      subroutine get_values_start(which_field)
       include 'SIZE'
       include 'TOTAL'
       include 'NEKNEK'
@@ -613,19 +511,12 @@ C----------------------------------------------------------------
 
       character*3 which_field(nfld_neknek)
       real field(lx1*ly1*lz1*lelt,nfldmax)
-      real rsend(nfldmax*nmaxl), rrecv(nfldmax*nmaxl)
-      real fieldout(nfldmax,nmaxl)
-
-      integer status(mpi_status_size)
-
-c     Information about communication of points is contained in common 
-c     block /proclist/.
- 
-C     iden(1,:) = ix
-C     iden(2,:) = iy
-C     iden(3,:) = iz
-C     iden(4,:) = iel
 
+c     Interpolate our fields at the points of the remote session and
+c     post the exchange of interface values along the pattern set up in
+c     intpts_locate.  Only the processors sharing interface points talk
+c     to each other, and get_values_wait, which moves the received 
+c     values to valint, may be deferred to overlap with other work.
 
 c     Put field values for the field ifld=1,nfld_neknek to the working array 
 c     field (:,:,:,:,nfld_neknek) used byt the findpts_value routine according 
@@ -633,7 +524,9 @@ c     to the field identificator which_field(ifld)
 
       if (nfld_neknek.eq.0) 
      $ call exitti('Error: set nfld_neknek in usrchk. Session:$',idsess)
-      
+
+      call happy_check(1)
+      call get_values_wait   ! complete an exchange nobody waited for
 
       call mappr(pm1,pr,wk1,wk2)  ! Map pressure to pm1 
 
@@ -646,57 +539,75 @@ c     to the field identificator which_field(ifld)
         if (which_field(ifld).eq.'vy') call copy(field(1,ifld),vy ,nt)
         if (which_field(ifld).eq.'vz') call copy(field(1,ifld),vz ,nt)
         if (which_field(ifld).eq.'pr') call copy(field(1,ifld),pm1,nt)
+      enddo
 
-C       Find interpolation values      
-         call findpts_eval(inth_multi,fieldout(ifld,1),nfldmax,
-     &                     rcode,1,
-     &                     proc,1,
-     &                     elid,1,
-     &                     rst,ndim,npoints,
-     &                     field(1,ifld))
+C     Points are local and sorted by destination: evaluate all fields 
+C     directly into the send buffer
 
-       enddo  
+      call findpts_eval_local_n(inth_multi,rsend_nn,nfld_neknek,1,
+     &                          elid,1,
+     &                          rst,ndim,npoints,
+     &                          nfld_neknek,field,lx1*ly1*lz1*lelt)
 
-C     Send interpolation values to the corresponding processors 
-C     of remote session
+      nreq_nn=0
 
-      call neknekgsync()
+      il=1
+      do n=1,nprecv
+         id  = inforecv(n,1)
+         len = nfld_neknek*inforecv(n,2)*wdsize
+         nreq_nn=nreq_nn+1
+         call mpi_irecv (rrecv_nn(il),len,mpi_byte,id,id,intercomm,
+     &                   ireq_nn(nreq_nn),ierr)
+         il = il + nfld_neknek*inforecv(n,2)
+      enddo
 
-      il=0
+      il=1
       do n=1,npsend   
-         id       = infosend(n,1)
-         nsend    = infosend(n,2)
-         do i=1,nsend
-            il=il+1
-            do ifld=1,nfld_neknek
-               rsend(nfld_neknek*(i-1)+ifld)=fieldout(ifld,il)
-           enddo
-         enddo
-         len=nfld_neknek*nsend*wdsize
-         call mpi_send (rsend,len,mpi_byte, id, nid, intercomm, ierr)
+         id  = infosend(n,1)
+         len = nfld_neknek*infosend(n,2)*wdsize
+         nreq_nn=nreq_nn+1
+         call mpi_isend (rsend_nn(il),len,mpi_byte,id,nid,intercomm,
+     &                   ireq_nn(nreq_nn),ierr)
+         il = il + nfld_neknek*infosend(n,2)
       enddo
 
-      il=0 
+      return
+      end
+C----------------------------------------------------------------
+      subroutine get_values_wait
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+      include 'mpif.h' 
+
+c     Complete the exchange posted by get_values_start
+
+C     iden(1,:) = ix
+C     iden(2,:) = iy
+C     iden(3,:) = iz
+C     iden(4,:) = iel
+
+      if (nreq_nn.eq.0) return
+
+      call mpi_waitall(nreq_nn,ireq_nn,mpi_statuses_ignore,ierr)
+      nreq_nn=0
+
+      nrecv=0
       do n=1,nprecv
-         id    = inforecv(n,1)
-         nrecv = inforecv(n,2)
-         len=nfld_neknek*nrecv*wdsize
-         call mpi_recv (rrecv,len,mpi_byte,id,id,intercomm,status,ierr)
-         do i=1,nrecv ! Extract point identity
-            il=il+1
-            ix = iden(1,il)
-            iy = iden(2,il)
-            iz = 1
-            if (if3d) iz=iden(3,il)
-            ie=iden(ldim+1,il)      
-            do ifld=1,nfld_neknek
-               valint(ix,iy,iz,ie,ifld)=rrecv(nfld_neknek*(i-1)+ifld)
-            enddo
+         nrecv=nrecv+inforecv(n,2)
+      enddo
+
+      do i=1,nrecv ! Extract point identity
+         ix = iden(1,i)
+         iy = iden(2,i)
+         iz = 1
+         if (if3d) iz=iden(3,i)
+         ie=iden(ldim+1,i)      
+         do ifld=1,nfld_neknek
+            valint(ix,iy,iz,ie,ifld)=rrecv_nn(nfld_neknek*(i-1)+ifld)
          enddo
       enddo 
 
-      call neknekgsync()
-
       return
       end
 C--------------------------------------------------------------------------
@@ -710,13 +621,21 @@ C--------------------------------------------------------------------------
 c     nfld_neknek is the number of fields to interpolate.
 c     nfld_neknek = 3 for just veliocities, nfld_neknek = 4 for velocities + temperature
 
+      if (nsessions.le.1) return
+
+      call neknek_rate
+      if (mod(istep,nsub_nn).ne.0) return  ! between coupling steps
+
       which_field(1)='vx'
       which_field(2)='vy'
       which_field(3)='vz'
       which_field(ndim+1)='pr'
       if (nfld_neknek.gt.ndim+1) which_field(ndim+2)='t'
 
-      if (nsessions.gt.1) call get_values(which_field)
+c     Values arrive in valint by the next bcopy; in between, each 
+c     session proceeds with its own work
+
+      call get_values_start(which_field)
 
       return
       end
@@ -728,30 +647,40 @@ c------------------------------------------------------------------------
 
       n    = nx1*ny1*nz1*nelt
 
-      do k=1,nfld_neknek
-         call copy(bdrylg(1,k,2),bdrylg(1,k,1),n)
-         call copy(bdrylg(1,k,1),bdrylg(1,k,0),n)
-         call copy(bdrylg(1,k,0),valint(1,1,1,1,k),n)
-      enddo
+      if (mod(istep,nsub_nn).eq.0) then  ! new interface data
+         call get_values_wait
+         do k=1,nfld_neknek
+            call copy(bdrylg(1,k,2),bdrylg(1,k,1),n)
+            call copy(bdrylg(1,k,1),bdrylg(1,k,0),n)
+            call copy(bdrylg(1,k,0),valint(1,1,1,1,k),n)
+         enddo
+         nbdry_nn = min(nbdry_nn+1,3)
+      endif
 
 c     Order of extrpolation is contolled by the parameter NINTER contained 
 c     in NEKNEK. First order interface extrapolation, NINTER=1 (time lagging) 
 c     is activated. It is unconditionally stable.  If you want to use 
 c     higher-order interface extrapolation schemes, you need to increase 
 c     ngeom to ngeom=3-5 for scheme to be stable.
+c
+c     The data are nsub_nn steps apart; s is the time of the next step
+c     past the newest data, in those units (s=1 for single rate).
+
+      s = (mod(istep,nsub_nn)+1)/real(nsub_nn)
+      k = min(ninter,nbdry_nn)
 
-      if (NINTER.eq.1.or.istep.eq.0) then
+      if (k.le.1) then
        c0=1
        c1=0
        c2=0
-       else if (NINTER.eq.2.or.istep.eq.1) then
-         c0=2
-         c1=-1
+       else if (k.eq.2) then
+         c0=1+s
+         c1=-s
          c2=0
        else 
-         c0=3
-         c1=-3
-         c2=1
+         c0=(s+1)*(s+2)/2
+         c1=-s*(s+2)
+         c2=s*(s+1)/2
       endif
      
       do k=1,nfld_neknek
@@ -761,6 +690,80 @@ c     ngeom to ngeom=3-5 for scheme to be stable.
       enddo
       enddo
 
+      return
+      end
+C---------------------------------------------------------------------
+      subroutine neknek_rate
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+
+      integer icalld
+      save    icalld
+      data    icalld /0/
+
+c     Multi-rate coupling (p154 > 0, in both sessions): each session
+c     keeps its first dt and the sessions exchange interface data only
+c     every nsub_nn steps, at the coupling interval dtc_nn = max dt over
+c     both sessions.  In between, bcopy extrapolates in time from the
+c     last ninter exchanges, so that a small inner domain does not hold
+c     the outer one to its dt.  Otherwise nsub_nn = 1 and the sessions
+c     share the smallest dt (neknek_dt).
+
+      if (icalld.ne.0) return
+      icalld = 1
+
+      nsub_nn    = 1
+      nsubmax_nn = 1
+      nbdry_nn   = 0
+
+      rmr = 0
+      if (param(154).gt.0) rmr = 1
+      if (uglamax(rmr,1).ne.uglmin(rmr,1)) call exitti
+     $   ('neknek: set p154 in both sessions or in neither $',0)
+      if (rmr.eq.0) return
+
+      dtc_nn     = uglamax(dt,1)
+      nsub_nn    = nint(dtc_nn/dt)
+      rsub       = nsub_nn
+      nsubmax_nn = nint(uglamax(rsub,1))
+
+      ierr = 0
+      if (abs(nsub_nn*dt-dtc_nn).gt.1.e-6*dtc_nn) ierr = 1
+      rerr = ierr
+      ierr = nint(uglamax(rerr,1))   ! both sessions exit together
+      if (ierr.ne.0) call exitti
+     $   ('neknek: dt must divide the coupling dt, nsub = $',nsub_nn)
+
+      if (nio.eq.0.and.nsubmax_nn.gt.1) write(6,1) nsub_nn,dt,dtc_nn
+    1 format(' neknek multi-rate: nsub, dt, dtc:',i6,1p2e13.4)
+
+      return
+      end
+C---------------------------------------------------------------------
+      subroutine neknek_dt
+      include 'SIZE'
+      include 'TOTAL'
+      include 'NEKNEK'
+
+c     Called by setdt: single rate sessions share the smallest dt, while
+c     multi-rate ones keep their own dt, fixed, without synchronizing.
+c     As for a fixed dt (iffxdt), the CFL is then only checked.
+
+      common /udxmax/ umax
+
+      call neknek_rate
+
+      if (nsubmax_nn.gt.1) then
+         dt     = dtc_nn/nsub_nn
+         courno = dt*umax
+         if (nio.eq.0.and.courno.gt.ctarg) write(6,1) istep,courno,ctarg
+    1    format(i9,' neknek multi-rate: CFL',1pe12.4,' > ctarg',e12.4)
+         if (courno.gt.10.*ctarg) call emerxit
+      else
+         dt = uglmin(dt,1)
+      endif
+
       return
       end
 C---------------------------------------------------------------------
@@ -109,6 +109,33 @@ c
 
       enddo
  
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine free_overlap
+c
+c     Free the gs and coarse grid handles of set_overlap (field 1)
+c     before it is called again for a new distribution (part_rebal)
+c
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'HSMG'
+c
+      if (ifsplit.and.ifmgrid) then
+         lmax = mg_lmax                     ! h1mg_setup levels
+      elseif (.not.ifsplit .and. param(43).eq.0) then
+         lmax = mg_lmax-1                   ! hsmg_setup levels
+      else
+         lmax = 0
+      endif
+      do l=1,lmax
+         call gs_free(mg_gsh_handle        (l,1))
+         call gs_free(mg_gsh_schwarz_handle(l,1))
+      enddo
+
+      call crs_free(xxth(1))
+
       return
       end
 c-----------------------------------------------------------------------
@@ -106,7 +106,7 @@ c
       integer key(2),aa(2)
       common /scrch/ iwork(2,lx1*ly1*lz1*lelv)
       common /scrns/ w(7*lx1*ly1*lz1*lelv)
-      common /vptsol/ a(27*lx1*ly1*lz1*lelv)
+      common /scrxxta/ a(lcr*lcr*lelv)   ! not SOLN: called mid-run
       integer w
       real wr(1)
       equivalence (wr,w)
@@ -203,6 +203,7 @@ c      endif
       endif
 
       nz=ncr*ncr*nelv
+      call set_crs_cache
       call crs_setup(xxth(ifield),nekcomm,mp, ntot,se_to_gcrs,
      $               nz,ia,ja,a, null_space)
 c     call crs_stats(xxth(ifield))
@@ -216,6 +217,39 @@ c     call crs_stats(xxth(ifield))
       return
       end
 c
+c-----------------------------------------------------------------------
+      subroutine set_crs_cache  ! p135 > 0: keep coarse grid setup on disk
+c
+c     The XXT setup of each proc is saved in <session>.xxt_<key>.<nid>
+c     and reloaded by later runs with the same mesh, partition and bcs.
+c
+      include 'SIZE'
+      include 'INPUT'
+
+      character*132 cname
+      character*1   cname1(132)
+      integer       icname(33)
+      equivalence  (cname1,cname)
+      equivalence  (icname,cname)
+
+      character*1   path1(132),sess1(132)
+      equivalence  (path1,path)
+      equivalence  (sess1,session)
+
+      call izero(icname,33)
+      if (param(135).gt.0) then
+         lpp = ltrunc(path,132)
+         ls  = ltrunc(session,132)
+         if (lpp+ls+1.lt.132) then
+            call chcopy(cname1(    1),path1,lpp)
+            call chcopy(cname1(lpp+1),sess1,ls )
+            cname1(lpp+ls+1) = '.'
+         endif
+      endif
+      call crs_cache(cname)
+
+      return
+      end
 c-----------------------------------------------------------------------
       subroutine set_jl_crs_mask(n, mask, se_to_gcrs)
       real mask(1)
@@ -1740,7 +1774,9 @@ c-----------------------------------------------------------------------
          call nekMOAB_loadConn (vertex, nelgt, ncrnr)
 #endif
       else
-         call get_vert_map(vertex, ncrnr, nelgt, '.map', ifgfdm)
+         call part_chk   ! partition in code instead of reading .map?
+         if (.not.ifpart)
+     $      call get_vert_map(vertex, ncrnr, nelgt, '.map', ifgfdm)
       endif
 
       return
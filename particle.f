@@ -0,0 +1,494 @@
+c-----------------------------------------------------------------------
+c
+c     Lagrangian particle tracking
+c
+c     Particles live on the rank that owns the element containing them,
+c     in the struct of arrays of PARTICLE.  They are advanced by the
+c     3-stage SSP Runge-Kutta scheme over each fluid time step,
+c
+c        dx/dt = v,   dv/dt = (u(x,t) - v)/tau,
+c
+c     with v = u for tracers (tau = 0); explicit stability requires
+c     dt < 2 tau for the inertial ones.  The fluid velocity is
+c     evaluated on the owning rank (findpts_eval_local_n), linearly
+c     interpolated in time between vxlag and vx.  After each stage the
+c     particles are re-located starting from their previous element
+c     (findpts_update) and those that changed rank are moved in one
+c     batched crystal router transfer.  Particles that leave the
+c     domain are dropped, except across the periodic directions
+c     iflper(i) set by the user before the first lpt_add, which wrap
+c     around the bounding box of the mesh.
+c
+c     Usage, from usrdat2/userchk:
+c
+c        call lpt_add(x,v,tau,n)    ! new particles, from any rank
+c        call lpt_advance           ! each step, from userchk
+c        call lpt_out               ! parallel dump to lpt<case>0.f*
+c
+c     The number of particles per rank is limited by lpart (SIZE).
+c
+c-----------------------------------------------------------------------
+      subroutine lpt_init
+
+      include 'SIZE'
+      include 'PARTICLE'
+
+      iflpt  = .false.
+      nlpt   = 0
+      nlptid = 0
+      nlost  = 0
+      do i=1,ldim
+         iflper(i) = .false.
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_setup
+
+c     (Re)build the findpts handle on the current mesh and distribution
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'PARTICLE'
+
+      if (iflpt) call intpts_done(ih_lpt)
+      call intpts_setup(-1.0,ih_lpt)
+      iflpt      = .true.
+      nrebal_lpt = nrebal
+
+      n = nx1*ny1*nz1*nelt
+      xpmin(1) = glmin(xm1,n)
+      xplen(1) = glmax(xm1,n) - xpmin(1)
+      xpmin(2) = glmin(ym1,n)
+      xplen(2) = glmax(ym1,n) - xpmin(2)
+      if (if3d) then
+         xpmin(ndim) = glmin(zm1,n)
+         xplen(ndim) = glmax(zm1,n) - xpmin(ndim)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_add(x,v,tau,n)
+
+c     Add n particles with positions x and velocities v, packed as in
+c     intpts, x := [x(1)...x(n),y(1)...y(n),z(1)...z(n)], and
+c     relaxation times tau (0 for tracers).  Collective; the particles
+c     are moved to the owners of their elements, those outside the
+c     mesh are dropped.
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'PARTICLE'
+
+      real x(n,ldim),v(n,ldim),tau(n)
+
+      if (.not.iflpt) call lpt_setup
+
+      ierr = 0
+      if (nlpt+n.gt.llpt) ierr = 1
+      call err_chk(ierr,'lpt_add: too many particles, increase lpart$')
+
+      nn = n
+      i0 = igl_running_sum(nn) - n + nlptid
+      do i=1,n
+         k = nlpt+i
+         do j=1,ndim
+            xp(k,j) = x(i,j)
+            vp(k,j) = v(i,j)
+         enddo
+         taup  (k) = tau(i)
+         ipid  (k) = i0+i
+         ipcode(k) = 2          ! not found, forces the global search
+         ipproc(k) = nid
+         ipel  (k) = 0
+      enddo
+      nlpt   = nlpt + n
+      nlptid = nlptid + iglsum(nn,1)
+
+      nl0 = nlost
+      call lpt_locate
+
+      nptg = iglsum(nlpt,1)
+      nl0  = iglsum(nlost-nl0,1)
+      if (nio.eq.0) write(6,1) istep,nptg,nl0
+    1 format(i9,' lpt_add: particles, dropped',2i12)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_advance
+
+c     Advance all particles over the last time step, [time-dt,time]
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'PARTICLE'
+
+      real*8 dnekclock,t0
+
+      if (.not.iflpt .or. istep.eq.0) return
+
+      t0 = dnekclock()
+
+      if (ifmvbd .or. nrebal.ne.nrebal_lpt) then  ! new mesh/partition
+         call lpt_setup
+         call lpt_locate
+      endif
+
+      do j=1,ndim
+         call copy(xp0(1,j),xp(1,j),nlpt)
+         call copy(vp0(1,j),vp(1,j),nlpt)
+      enddo
+
+      call lpt_stage(0.0 ,1.0 ,0.0)               ! SSP-RK3
+      call lpt_stage(0.75,0.25,1.0)
+      call lpt_stage(1./3,2./3,0.5)
+
+      call lpt_sort
+
+      nptg = iglsum(nlpt,1)
+      nlsg = iglsum(nlost,1)
+      tlpt = dnekclock()-t0
+      tlpt = glmax(tlpt,1)
+      if (nio.eq.0) write(6,1) istep,nptg,nlsg,tlpt
+    1 format(i9,' lpt: particles, lost, time',2i12,1pe12.4)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_stage(a,b,c)
+
+c     x := a x0 + b (x + dt f(x,t0+c dt)), likewise for v
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'PARTICLE'
+
+      parameter (lt=lx1*ly1*lz1*lelt)
+      common /lptscr/ uf(lt,ldim)
+
+      n = nx1*ny1*nz1*nelv
+      call add3s2(uf(1,1),vxlag(1,1,1,1,1),vx,1.-c,c,n)
+      call add3s2(uf(1,2),vylag(1,1,1,1,1),vy,1.-c,c,n)
+      if (if3d) call add3s2(uf(1,3),vzlag(1,1,1,1,1),vz,1.-c,c,n)
+
+      call findpts_eval_local_n(ih_lpt,up,1,llpt,
+     &                          ipel,1,
+     &                          rsp,ldim,nlpt,
+     &                          ndim,uf,lt)
+
+      do j=1,ndim
+      do i=1,nlpt
+         if (taup(i).gt.0) then
+            fv = (up(i,j)-vp(i,j))/taup(i)
+            xp(i,j) = a*xp0(i,j) + b*(xp(i,j) + dt*vp(i,j))
+            vp(i,j) = a*vp0(i,j) + b*(vp(i,j) + dt*fv)
+         else
+            xp(i,j) = a*xp0(i,j) + b*(xp(i,j) + dt*up(i,j))
+            vp(i,j) = up(i,j)
+         endif
+      enddo
+      enddo
+
+      call lpt_locate
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_locate
+
+c     Find the new elements of the particles and move them to their
+c     owners; particles outside the mesh are dropped
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'PARTICLE'
+
+      parameter (lrp=5*ldim+2)
+      common /lptsnd/ rr(lrp,llpt),ir(4,llpt)
+      integer*8 vl
+
+      do j=1,ndim                    ! periodic wrap, x0 shifted along
+         if (iflper(j)) then           ! for the next RK stages
+            do i=1,nlpt
+               s = xp(i,j)-xpmin(j)
+               d = 0
+               if (s.lt.0)        d =  xplen(j)
+               if (s.ge.xplen(j)) d = -xplen(j)
+               xp (i,j) = xp (i,j) + d
+               xp0(i,j) = xp0(i,j) + d
+            enddo
+         endif
+      enddo
+
+      call findpts_update(ih_lpt,ipcode,1,
+     &                    ipproc,1,
+     &                    ipel,1,
+     &                    rsp,ldim,
+     &                    dsp,1,
+     &                    xp(1,1),1,
+     &                    xp(1,2),1,
+     &                    xp(1,ndim),1,nlpt)
+
+      m = 0                                       ! pack the movers
+      k = 0
+      do i=1,nlpt
+         if (ipcode(i).eq.2 .or.
+     $      (ipcode(i).eq.1 .and. dsp(i).gt.1e-12)) then
+            nlost = nlost+1
+         elseif (ipproc(i).ne.nid) then
+            m = m+1
+            call lpt_pack(rr(1,m),ir(1,m),i)
+         else
+            k = k+1
+            if (k.ne.i) call lpt_copy(k,i)
+         endif
+      enddo
+      nlpt = k
+
+      call crystal_tuple_transfer(cr_h,m,llpt,ir,4,vl,0,rr,lrp,1)
+
+      ierr = 0
+      if (m.gt.llpt-nlpt) ierr = 1
+      call err_chk(ierr,'lpt_locate: too many particles, incr. lpart$')
+      do i=1,m
+         nlpt = nlpt+1
+         call lpt_unpack(rr(1,i),ir(1,i),nlpt)
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_pack(r,ir,i)
+
+      include 'SIZE'
+      include 'PARTICLE'
+
+      real r(1)
+      integer ir(4)
+
+      ir(1) = ipproc(i)
+      ir(2) = ipid  (i)
+      ir(3) = ipel  (i)
+      ir(4) = ipcode(i)
+      k = 0
+      do j=1,ndim
+         r(k+1) = xp (i,j)
+         r(k+2) = vp (i,j)
+         r(k+3) = xp0(i,j)
+         r(k+4) = vp0(i,j)
+         r(k+5) = rsp(j,i)
+         k = k+5
+      enddo
+      r(k+1) = dsp (i)
+      r(k+2) = taup(i)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_unpack(r,ir,i)
+
+      include 'SIZE'
+      include 'PARTICLE'
+
+      real r(1)
+      integer ir(4)
+
+      ipproc(i) = nid
+      ipid  (i) = ir(2)
+      ipel  (i) = ir(3)
+      ipcode(i) = ir(4)
+      k = 0
+      do j=1,ndim
+         xp (i,j) = r(k+1)
+         vp (i,j) = r(k+2)
+         xp0(i,j) = r(k+3)
+         vp0(i,j) = r(k+4)
+         rsp(j,i) = r(k+5)
+         k = k+5
+      enddo
+      dsp (i) = r(k+1)
+      taup(i) = r(k+2)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_copy(k,i)   ! particle i to slot k
+
+      include 'SIZE'
+      include 'PARTICLE'
+
+      do j=1,ndim
+         xp (k,j) = xp (i,j)
+         vp (k,j) = vp (i,j)
+         xp0(k,j) = xp0(i,j)
+         vp0(k,j) = vp0(i,j)
+         rsp(j,k) = rsp(j,i)
+      enddo
+      dsp   (k) = dsp   (i)
+      taup  (k) = taup  (i)
+      ipid  (k) = ipid  (i)
+      ipcode(k) = ipcode(i)
+      ipproc(k) = ipproc(i)
+      ipel  (k) = ipel  (i)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_sort
+
+c     Order the particles by element, so that the evaluation in
+c     findpts_eval_local_n works element by element
+
+      include 'SIZE'
+      include 'PARTICLE'
+
+      common /lptsrt/ rw(ldim,llpt),ind(llpt)
+
+      n = nlpt
+      call isort(ipel,ind,n)
+      do j=1,ndim
+         call swap_ip(xp (1,j),ind,n)
+         call swap_ip(vp (1,j),ind,n)
+         call swap_ip(xp0(1,j),ind,n)
+         call swap_ip(vp0(1,j),ind,n)
+      enddo
+      do i=1,n                                    ! rsp(ldim,llpt)
+         do j=1,ndim
+            rw(j,i) = rsp(j,ind(i))
+         enddo
+      enddo
+      call copy(rsp,rw,ldim*n)
+      call swap_ip (dsp   ,ind,n)
+      call swap_ip (taup  ,ind,n)
+      call iswap_ip(ipid  ,ind,n)
+      call iswap_ip(ipcode,ind,n)
+      call iswap_ip(ipproc,ind,n)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine lpt_out
+
+c     Dump id, position and velocity of all particles to the next
+c     lpt<case>0.f<nnnnn>, one record of 1+2*ndim 4-byte words
+c     (integer id, real*4 x and v) per particle after a 132 byte
+c     '#lpt' header and the byte-order test pattern.  Records are
+c     written by every rank at its offset with MPI-IO, otherwise
+c     gathered to the i/o nodes (one file per node, see p65; with
+c     MPIIO_NOCOL one file, the nodes write at their offset).
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+      include 'PARTICLE'
+
+      parameter (lw=1+2*ldim)
+      common /lptout/ u4(2+lw*llpt)
+      real*4 u4
+      integer i4(2+lw*llpt)
+      equivalence (u4,i4)
+
+      character*132 hdr
+      real*4 test_pattern
+#ifdef MPIIO
+      integer*8 ioff
+#endif
+
+      real*8 dnekclock_sync,t0
+
+      if (.not.iflpt) return
+
+      t0  = dnekclock_sync()
+      nw  = 1+2*ndim
+      len = 4*(2+lw*llpt)
+
+      nptg = iglsum(nlpt,1)
+      nn   = nlpt
+      npb  = igl_running_sum(nn) - nlpt     ! particles before mine
+      idum = 1
+
+#ifdef MPIIO
+      nfileoo = 1
+      npo     = nptg
+#else
+      nfileoo = nfileo
+      if (nid.eq.pid0) then                 ! how many in this file
+         npo = nlpt
+         do j=pid0+1,pid1
+            call csend(j,idum,4,j,0)        ! handshake
+            call crecv(j,inpt,4)
+            npo = npo + inpt
+         enddo
+      else
+         call crecv(nid,idum,4)             ! handshake
+         call csend(nid,nlpt,4,pid0,0)
+      endif
+#endif
+
+      ierr = 0
+      if (nid.eq.pid0) call mfo_open_files('lpt',ierr)
+      call err_chk(ierr,'Error opening file in lpt_out. $')
+
+      do i=1,nlpt                           ! records, u4 :=: i4
+         k = 2 + nw*(i-1)
+         i4(k+1) = ipid(i)
+         do j=1,ndim
+            u4(k+1+j)      = xp(i,j)
+            u4(k+1+ndim+j) = vp(i,j)
+         enddo
+      enddo
+
+      if (nid.eq.pid0) then
+         call blank(hdr,132)
+         write(hdr,1) ndim,npo,nptg,time,istep,fid0,nfileoo
+    1    format('#lpt',1x,i1,1x,i12,1x,i12,1x,e20.13,
+     &          1x,i9,1x,i6,1x,i6)
+         test_pattern = 6.54321
+#ifdef MPIIO
+         call byte_write_mpi(hdr,iHeaderSize/4,pid00,ifh_mbyte,ierr)
+         call byte_write_mpi(test_pattern,1,pid00,ifh_mbyte,ierr)
+         ioff = npb
+         ioff = iHeaderSize + 4 + 4*nw*ioff
+         call byte_set_view (ioff,ifh_mbyte)
+         call byte_write_mpi(u4(3),nw*nlpt,-1,ifh_mbyte,ierr)
+#else
+         call byte_write(hdr,iHeaderSize/4,ierr)
+         call byte_write(test_pattern,1,ierr)
+         call byte_write(u4(3),nw*nlpt,ierr)
+#endif
+         do j=pid0+1,pid1                   ! data of my children
+            call csend(j,idum,4,j,0)        ! handshake
+            call crecv(j,u4,len)
+#ifdef MPIIO
+            if (ierr.eq.0)                  ! MPIIO_NOCOL, follows mine
+     &         call byte_write_mpi(u4(3),nw*i4(1),-1,ifh_mbyte,ierr)
+#else
+            if (ierr.eq.0) call byte_write(u4(3),nw*i4(1),ierr)
+#endif
+         enddo
+      else
+         i4(1) = nlpt
+         call crecv(nid,idum,4)             ! handshake
+         call csend(nid,u4,4*(2+nw*nlpt),pid0,0)
+      endif
+      call err_chk(ierr,'Error writing file in lpt_out. $')
+
+      if (nid.eq.pid0)
+#ifdef MPIIO
+     &   call byte_close_mpi(ifh_mbyte,ierr)
+#else
+     &   call byte_close(ierr)
+#endif
+      call err_chk(ierr,'Error closing file in lpt_out. $')
+
+      tio = dnekclock_sync()-t0
+      if (nio.eq.0) write(6,2) istep,time,nptg,tio
+    2 format(i9,1pe12.4,' done :: lpt_out',i12,' particles',
+     &       0pf9.3,' sec')
+
+      return
+      end
+c-----------------------------------------------------------------------
@@ -412,11 +412,46 @@ c
       bb_t    = 0.1 ! relative size to expand bounding boxes by
 c
       if(nidd.eq.0) write(6,*) 'initializing intpts(), tol=', tol
+      call set_findpts_cache
       call findpts_setup(ih,nekcomm,npp,ndim,
      &                     xm1,ym1,zm1,nx1,ny1,nz1,
      &                     nelt,nxf,nyf,nzf,bb_t,n,n,
      &                     npt_max,tol)
 c       
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine set_findpts_cache  ! p152 > 0: keep findpts setup on disk
+c
+c     The findpts hash tables of each proc are saved in the file
+c     <session>.fpts_<key>.<nid> and reloaded by later setups (runs)
+c     with the same mesh and partition.
+c
+      include 'SIZE'
+      include 'INPUT'
+
+      character*132 cname
+      character*1   cname1(132)
+      integer       icname(33)
+      equivalence  (cname1,cname)
+      equivalence  (icname,cname)
+
+      character*1   path1(132),sess1(132)
+      equivalence  (path1,path)
+      equivalence  (sess1,session)
+
+      call izero(icname,33)
+      if (param(152).gt.0 .and. .not.ifmvbd) then  ! moving: new key
+         lpp = ltrunc(path,132)
+         ls  = ltrunc(session,132)
+         if (lpp+ls+1.lt.132) then
+            call chcopy(cname1(    1),path1,lpp)
+            call chcopy(cname1(lpp+1),sess1,ls )
+            cname1(lpp+ls+1) = '.'
+         endif
+      endif
+      call findpts_cache(cname)
+
       return
       end
 c-----------------------------------------------------------------------
@@ -490,23 +525,20 @@ c
         enddo
       endif
 
-      ! evaluate inut field at given points
-      ltot = lelt*lx1*ly1*lz1
-      do ifld = 1,nfld
-         iin    = (ifld-1)*ltot + 1
-         iout   = (ifld-1)*n + 1
-         is_out = 1
-         if(ifot) then ! transpose output 
-           iout   = ifld
-           is_out = nfld 
-         endif
-         call findpts_eval(ih,fieldout(iout),is_out,
-     &                     rcode,1,
-     &                     proc,1,
-     &                     elid,1,
-     &                     rst,ndim,n,
-     &                     fieldin(iin))
-      enddo
+      ! evaluate input fields at given points, all in one pass
+      ltot   = lelt*lx1*ly1*lz1
+      is_out = 1
+      is_fld = n
+      if(ifot) then ! transpose output 
+        is_out = nfld 
+        is_fld = 1
+      endif
+      call findpts_eval_n(ih,fieldout,is_out,is_fld,
+     &                    rcode,1,
+     &                    proc,1,
+     &                    elid,1,
+     &                    rst,ndim,n,
+     &                    nfld,fieldin,ltot)
 
       nn(1) = iglsum(n,1)
       nn(2) = iglsum(nfail,1)
@@ -516,6 +548,50 @@ c
      &         ,i12,/,' done :: intpts')
       endif
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine intpts_move(pts,n,ih)
+c
+c locate the points of the last intpts call again after they (or the
+c mesh, with a new handle) have moved; each point is first tried in its
+c previous element and on its previous processor, and only the points
+c that escaped are searched for globally.  Evaluate afterwards with
+c intpts(...,ifpts=.false.,ih).
+c
+c pts ... packed list of the moved points, same n and order as before
+c n   ... local number of interpolation points
+c ih  ... interpolation handle
+c
+      include 'SIZE'
+
+      real    pts(1)
+
+      real    dist(lpart) ! squared distance
+      real    rst(lpart*ldim)
+      integer rcode(lpart),elid(lpart),proc(lpart)
+
+      common /intp_r/ rst,dist
+      common /intp_i/ rcode,elid,proc
+
+      call findpts_update(ih,rcode,1,
+     &                    proc,1,
+     &                    elid,1,
+     &                    rst,ndim,
+     &                    dist,1,
+     &                    pts(    1),1,
+     &                    pts(  n+1),1,
+     &                    pts(2*n+1),1,n)
+
+      nfail = 0
+      do in=1,n
+         if(rcode(in).eq.2) nfail = nfail + 1
+         if(rcode(in).eq.1 .and. dist(in).gt.1e-12) nfail = nfail + 1
+      enddo
+      nfail = iglsum(nfail,1)
+      if(nio.eq.0 .and. nfail.gt.0) write(6,*)
+     &   'WARNING: intpts_move, points outside the mesh:',nfail
+
       return
       end
 c-----------------------------------------------------------------------
@@ -1704,6 +1780,10 @@ c
       call err_chk(ierr,' Cannot read geometry file!$')
       call bcast(hdr,iHeaderSize)
       call mfi_parse_hdr(hdr,ierr)
+      if(izipr.ne.0) then
+        if(nid.eq.0) write(6,*) 'ABORT: compressed file ', geofld
+        call exitt
+      endif
       if(indx2(rdcode,10,'X',1).le.0) then
         if(nid.eq.0) write(6,*) 'ABORT: No geometry found in ', geofld
         call exitt
@@ -1919,10 +1999,10 @@ c-----------------------------------------------------------------------
 c
 c     evaluate velocity, temperature, pressure and ps-scalars 
 c     for list of points (read from hpts.in) and dump results
-c     into a file (hpts.out).
-c     note: read/write on rank0 only 
+c     into a file (hpts.out, or hpts.bin for p153 > 0, see hpts_bin).
+c     note: rank r keeps a contiguous block of the points (hpts_in)
 c
-c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
+c     ASSUMING LHIS IS MAX NUMBER OF POINTS ON ONE PROCESSOR
 
       include 'SIZE'
       include 'TOTAL'
@@ -1943,8 +2023,8 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
 
       logical iffind
 
-      integer icalld,npoints,npts
-      save    icalld,npoints,npts
+      integer icalld,npoints,npts,nrebal0
+      save    icalld,npoints,npts,nrebal0
       data    icalld  /0/
       data    npoints /0/
 
@@ -1952,7 +2032,6 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
 
       nxyz  = nx1*ny1*nz1
       ntot  = nxyz*nelt 
-      nbuff = lhis      ! point to be read in on 1 proc.
 
       if(nio.eq.0) write(6,*) 'dump history points'
 
@@ -1960,6 +2039,15 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
         npts  = lhis      ! number of points per proc
         call hpts_in(pts,npts,npoints)
         call intpts_setup(-1.0,inth_hpts) ! use default tolerance
+        nrebal0 = nrebal
+      elseif (nrebal.ne.nrebal0) then       ! elements have moved
+        call intpts_done (inth_hpts)
+        call intpts_setup(-1.0,inth_hpts)
+        nrebal0 = nrebal
+        icalld  = 0                         ! locate the points again
+      elseif (ifmvbd) then                  ! mesh has moved
+        call intpts_done (inth_hpts)
+        call intpts_setup(-1.0,inth_hpts)
       endif
 
 
@@ -1989,8 +2077,9 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
       enddo
       
       ! interpolate
-      if(icalld.eq.0) then
-        call findpts(inth_hpts,rcode,1,
+      if(icalld.eq.0 .or. ifmvbd) then
+        if(icalld.eq.0) then
+          call findpts(inth_hpts,rcode,1,
      &                 proc,1,
      &                 elid,1,
      &                 rst,ndim,
@@ -1998,6 +2087,16 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
      &                 pts(1,1),ndim,
      &                 pts(2,1),ndim,
      &                 pts(3,1),ndim,npts)
+        else              ! start from the locations on the old mesh
+          call findpts_update(inth_hpts,rcode,1,
+     &                 proc,1,
+     &                 elid,1,
+     &                 rst,ndim,
+     &                 dist,1,
+     &                 pts(1,1),ndim,
+     &                 pts(2,1),ndim,
+     &                 pts(3,1),ndim,npts)
+        endif
       
         do i=1,npts
            ! check return code 
@@ -2018,17 +2117,18 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
         icalld = 1
       endif
 
-      ! evaluate input field at given points
-      do ifld = 1,nflds
-         call findpts_eval(inth_hpts,fieldout(ifld,1),nfldm,
-     &                     rcode,1,
-     &                     proc,1,
-     &                     elid,1,
-     &                     rst,ndim,npts,
-     &                     wrk(1,ifld))
-      enddo
-      ! write interpolation results to hpts.out
-      call hpts_out(fieldout,nflds,nfldm,npoints,nbuff)
+      ! evaluate input fields at given points
+      call findpts_eval_n(inth_hpts,fieldout,nfldm,1,
+     &                    rcode,1,
+     &                    proc,1,
+     &                    elid,1,
+     &                    rst,ndim,npts,
+     &                    nflds,wrk,lx1*ly1*lz1*lelt)
+      if (param(153).gt.0) then   ! buffer, write to hpts.bin
+         call hpts_bin(pts,fieldout,nflds,nfldm,npts,npoints)
+      else                        ! write results to hpts.out
+         call hpts_out(fieldout,nflds,nfldm,npoints,npts)
+      endif
 
       call prepost_map(1)  ! maps back axisymm arrays
 
@@ -2037,176 +2137,491 @@ c     ASSUMING LHIS IS MAX NUMBER OF POINTS TO READ IN ON ONE PROCESSOR
       return
       end
 c-----------------------------------------------------------------------
-      subroutine buffer_in(buffer,npp,npoints,nbuf)
-        
+      subroutine hpts_in(pts,npts,npoints)
+c                        npts=local count; npoints=total count
+c
+c     Every rank maps hpts.in and reads the lines (one point each)
+c     that start in its share of the bytes after the point count.  The
+c     points are then sent to their owners: rank r keeps the points
+c     r*npb+1 ... (r+1)*npb in file order, npb = ceil(npoints/np).
+
       include 'SIZE'
       include 'PARALLEL'
 
-      real    buffer(ldim,nbuf)  
+      parameter (lt2=2*lx1*ly1*lz1*lelt)
+      common /scrns/ xyz(ldim,lt2)
+      common /scruz/ mid(2,lt2)  ! target proc id, point number
+      real    pts(ldim,npts)
+
+      character*132 line
+      integer*8 lfile,lbody,ipos,ipos0,ib1,iwin,vl
+
+      integer fnami (33)
+      character*132 fname
+      equivalence (fname,fnami)
+
+      ierr    = 0
+      npoints = 0
+      call izero(fnami,33)
+      call chcopy(fname,'hpts.in',7)
+      call byte_open(fname,ierr)
+      if (ierr.eq.0) call byte_map(ierr)
+      call byte_mlen(lfile)
+      if (lfile.lt.4) ierr = 1
+      call err_chk(ierr,'Cannot open hpts.in in subroutine hpts()$')
+      if(nid.eq.0) write(6,*) 'reading hpts.in'
+
+      iwin = -1                             ! no window read yet
+      ipos = 0
+      call hpts_getl(line,ipos,iwin,lfile,ierr)
+      if (ierr.eq.0) read(line,*,err=100,end=100) npoints
+      if (npoints.gt.0) goto 101
+  100 ierr = 1
+  101 continue
+      call err_chk(ierr,'Cannot read # of points in hpts.in$')
 
-      ierr = 0
-      if(nid.eq.0) then
-        write(6,*) 'reading hpts.in'
-        open(50,file='hpts.in',status='old',err=100)
-        read(50,*,err=100) npoints
-        goto 101
- 100    ierr = 1
- 101    continue
-      endif
-      ierr=iglsum(ierr,1)
-      if(ierr.gt.0) then
-        write(6,*) 'Cannot open hpts.in in subroutine hpts()'
-        call exitt
-      endif
-      
-      call bcast(npoints,isize)
       if(npoints.gt.lhis*np) then
         if(nid.eq.0) write(6,*) 'ABORT: Too many pts to read in hpts()!'
         call exitt
       endif
       if(nid.eq.0) write(6,*) 'found ', npoints, ' points'
 
+      ipos0 = ipos                          ! my share of the points
+      lbody = lfile-ipos0
+      ipos  = ipos0 + (lbody*nid)/np
+      ib1   = ipos0 + (lbody*(nid+1))/np
+      if (ipos.gt.ipos0) then               ! skip to the next line
+         ipos = ipos-1
+         call hpts_getl(line,ipos,iwin,lfile,ierr)
+      endif
 
-      npass =  npoints/nbuf +1  !number of passes to cover all pts
-      n0    =  mod(npoints,nbuf)!remainder 
-      if(n0.eq.0) then
-         npass = npass-1
-         n0    = nbuf
+      npp = 0
+  110 if (ipos.lt.ib1 .and. ierr.eq.0) then
+         call hpts_getl(line,ipos,iwin,lfile,ierr)
+         if (ierr.eq.0 .and. line.ne.' ') then
+            npp = npp + 1
+            if (npp.gt.lt2) then
+               ierr = 1
+            else
+               read(line,*,err=120,end=120) (xyz(j,npp),j=1,ndim)
+            endif
+         endif
+         goto 110
+  120    ierr = 1
+      endif
+      call byte_close(ierr2)
+      call err_chk(ierr,'Error reading points from hpts.in$')
+
+      npb = (npoints+np-1)/np
+      ig  = igl_running_sum(npp) - npp      ! points before mine
+      n   = 0
+      do i=1,npp
+         ig = ig + 1
+         if (ig.le.npoints) then            ! ignore lines past npoints
+            n = n + 1
+            mid(1,n) = (ig-1)/npb
+            mid(2,n) = ig
+            call copy(xyz(1,n),xyz(1,i),ndim)
+         endif
+      enddo
+      nn = iglsum(n,1)
+      if (nn.lt.npoints) then
+         if(nid.eq.0) write(6,*) 'ABORT: hpts.in has',nn,' points only'
+         call exitt
       endif
 
-      len = wdsize*ndim*nbuf
-      if (nid.gt.0.and.nid.lt.npass) msg_id=irecv(nid,buffer,len)
-      call nekgsync
-      
-      npp=0  
+      call crystal_tuple_transfer
+     &   (cr_h,n,lt2,mid,2,vl,0,xyz,ldim,1)
+      key = 2                               ! sort by point number
+      call crystal_tuple_sort
+     &   (cr_h,n,mid,2,vl,0,xyz,ldim,key,1)
+
+      npts = n
+      call copy(pts,xyz,ldim*npts)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_getl(line,ipos,iwin,lfile,ierr)
+c
+c     Copy the line at byte ipos of the mapped file to line and advance
+c     ipos past it.  The file is read through a window of lcw words at
+c     byte iwin (iwin < 0: none yet).
+
+      character*132 line
+      integer*8 ipos,iwin,lfile
+
+      parameter (lcw=8192)
+      common /hptsw/ cw(lcw)
+      real*4 cw
+      character*1 cwc(4*lcw),c
+      equivalence (cw,cwc)
+
+      nw = lcw
+      if (lfile.lt.4*lcw) nw = lfile/4
+
+      call blank(line,132)
+      k    = 0
+      ierr = 0
+   10 if (ipos.ge.lfile) return
+      if (iwin.lt.0 .or. ipos.lt.iwin .or. ipos.ge.iwin+4*nw) then
+         iwin = min(ipos,lfile-4*nw)
+         call byte_mread(cw,iwin,nw,ierr)
+         if (ierr.ne.0) return
+      endif
+      c    = cwc(ipos-iwin+1)
+      ipos = ipos + 1
+      if (c.eq.char(10)) return
+      if (c.eq.char(13) .or. c.eq.char(9)) c = ' '
+      k = k + 1
+      if (k.le.132) line(k:k) = c
+      goto 10
+
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_out(fieldout,nflds,nfldm,npoints,npts)
+c
+c     Rank 0 writes its points to hpts.out, then those of ranks 1,2,...
+c     (contiguous blocks in the order of hpts.in, see hpts_in)
+
+      include 'SIZE'
+      include 'TOTAL'
+
+      real buf(nfldm,lhis),fieldout(nfldm,npts)
+
+      integer icalld
+      save    icalld
+      data    icalld /0/
+
+      npb  = (npoints+np-1)/np
+      nrk  = (npoints+npb-1)/npb            ! # of ranks with points
+      len  = wdsize*nfldm*lhis
+      idum = 1
+
       if(nid.eq.0) then
-        i1 = nbuf
-        do ipass = 1,npass
-           if(ipass.eq.npass) i1 = n0
-           do i = 1,i1
-              read(50,*) (buffer(j,i),j=1,ndim) 
-           enddo
-           if(ipass.lt.npass)call csend(ipass,buffer,len,ipass,0)
-        enddo
-        close(50)
-        npp = n0
-        open(50,file='hpts.out',status='new')
-        write(50,'(A)') 
+        if(icalld.eq.0) then
+          open(50,file='hpts.out',status='new')
+          write(50,'(A)')
      &      '# time  vx  vy  [vz]  pr  T  PS1  PS2  ...'
-      elseif (nid.lt.npass)  then !processors receiving data
-        call msgwait(msg_id)
-        npp=nbuf
+        endif
+        do ip = 1,npts
+          write(50,'(1p20E15.7)') time,
+     &     (fieldout(i,ip), i=1,nflds)
+        enddo
+        do j = 1,nrk-1
+          call csend(j,idum,4,j,0)          ! handshake
+          call crecv(j,buf,len)
+          do ip = 1,min(npb,npoints-j*npb)
+            write(50,'(1p20E15.7)') time,
+     &       (buf(i,ip), i=1,nflds)
+          enddo
+        enddo
+      elseif(nid.lt.nrk) then
+        call crecv(nid,idum,4)              ! handshake
+        call csend(nid,fieldout,wdsize*nfldm*npts,0,nid)
       endif
+      icalld = 1
 
       return
       end
 c-----------------------------------------------------------------------
-      subroutine hpts_in(pts,npts,npoints) 
-c                        npts=local count; npoints=total count
+      subroutine hpts_init
 
       include 'SIZE'
-      include 'PARALLEL'
+      include 'HPTS'
 
-      parameter (lt2=2*lx1*ly1*lz1*lelt)
-      common /scrns/ xyz(ldim,lt2)
-      common /scruz/ mid(lt2)  ! Target proc id
-      real    pts(ldim,npts)
+      ifhpts = .false.
+      nsmp   = 0
 
-      if (lt2.gt.npts) then
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_bin(pts,fieldout,nflds,nfldm,npts,npoints)
+c
+c     Buffer this sample of my points (p153 > 0).  The buffer is
+c     appended to hpts.bin every min(p153,lhsmp) samples and at the
+c     end of the run (hpts_close).
+c
+c     hpts.bin is a 132 byte '#hpts' header, the byte-order test
+c     pattern and the point coordinates as columns over all points
+c     (x, y[, z], real*4), followed by one block per flush:
+c
+c        nt                       integer, # of samples
+c        time(nt)                 real*8
+c        u(nt,npoints,nflds)      real*4
+c
+c     i.e. the samples of a point are contiguous and each field is a
+c     column over all points in the order of hpts.in.  Each rank
+c     writes its own points at their offset (see hpts_bwrite).
 
-         call buffer_in(xyz,npp,npoints,lt2)
-         if(npoints.gt.np*npts) then
-           if(nid.eq.0)write(6,*)'ABORT in hpts(): npoints > NP*lhis!!' 
-           if(nid.eq.0)write(6,*)'Change SIZE: ',np,npts,npoints
-           call exitt
-         endif
+      include 'SIZE'
+      include 'TOTAL'
+      include 'HPTS'
 
-         npmax = (npoints/npts)
-         if(mod(npoints,npts).eq.0) npmax=npmax+1
+      real pts(ldim,npts),fieldout(nfldm,npts)
 
-         if(nid.gt.0.and.npp.gt.0) then
-          npts_b = lt2*(nid-1)               ! # pts  offset(w/o 0)
-          nprc_b = npts_b/npts               ! # proc offset(w/o 0)
+      if (.not.ifhpts) call hpts_bopen(pts,nflds,npts,npoints)
 
-          istart = mod(npts_b,npts)          ! istart-->npts pts left
-          ip     = nprc_b + 1                ! PID offset
-          icount = istart                    ! point offset
-         elseif(nid.eq.0) then
-          npts0   = mod1(npoints,lt2)        ! Node 0 pts
-          npts_b  = npoints - npts0          ! # pts before Node 0
-          nprc_b  = npts_b/npts
+      nsmp = nsmp + 1
+      tsmp(nsmp) = time
+      do k=1,nflds
+      do i=1,npts
+         hsmp(nsmp+msmp*(i-1+npts*(k-1))) = fieldout(k,i)
+      enddo
+      enddo
+      if (nsmp.eq.msmp) call hpts_flush
 
-          istart  = mod(npts_b,npts)
-          ip      = nprc_b + 1
-          icount  = istart
-         endif
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_bopen(pts,nflds,npts,npoints)
+c
+c     Create hpts.bin, write the header and the point coordinates.
+c     As for hpts.out, an existing file (e.g. of the run this one
+c     restarts from) is an error rather than being overwritten.
 
-         do i =1,npp
-            icount = icount + 1
-            if(ip.gt.npmax) ip = 0
-            mid(i) = ip
-            if (icount.eq.npts) then
-               ip     = ip+1
-               icount = 0
-            endif
-         enddo
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+      include 'HPTS'
 
-         call crystal_tuple_transfer 
-     &      (cr_h,npp,lt2,mid,1,pts,0,xyz,ldim,1)
+      real pts(ldim,npts)
 
-         call copy(pts,xyz,ldim*npp)
-      else
-         call buffer_in(pts,npp,npoints,npts)
+      character*132 hdr
+      character*80  tags
+      real*4 test_pattern
+      integer*8 ioff
+
+      integer fnami (33)
+      character*132 fname
+      equivalence (fname,fnami)
+      logical ifexist
+
+      msmp     = min(int(param(153)),lhsmp)
+      nhflds   = nflds
+      nhpts    = npts
+      nhpoints = npoints
+      nhpb     = (npoints+np-1)/np
+      nsmp     = 0
+
+      ierr = 0
+      if (nid.eq.0) then                    ! status='new', as hpts.out
+         inquire(file='hpts.bin',exist=ifexist)
+         if (ifexist) ierr = 1
       endif
-      npts = npp
+      call err_chk(ierr,'hpts.bin exists, move it before the run. $')
 
+#ifdef MPIIO
+      call blank(fname,132)
+      fname = 'hpts.bin'
+      call byte_open_mpi(fname,ifh_hpts,ierr)
+#else
+      if (nid.eq.0) then
+         call izero(fnami,33)
+         call chcopy(fname,'hpts.bin',8)
+         call byte_open(fname,ierr)
+         if (ierr.eq.0) call byte_move(3,ierr) ! keep handle 1 free
+      endif
+#endif
+      call err_chk(ierr,'Error opening hpts.bin in hpts_bin. $')
+      ifhpts = .true.
+
+      call blank(tags,80)                   ! fields, as in hpts
+      k = 0
+      if (ifvo) then
+         tags(k+1:k+1) = 'U'
+         k = k + 1
+      endif
+      if (ifpo) then
+         tags(k+1:k+1) = 'P'
+         k = k + 1
+      endif
+      if (ifto) then
+         tags(k+1:k+1) = 'T'
+         k = k + 1
+      endif
+      do i=1,ldimt
+         if (ifpsco(i) .and. k+3.le.80) then
+            write(tags(k+1:k+3),'(a1,i2.2)') 'S',i
+            k = k + 3
+         endif
+      enddo
+
+      call blank(hdr,132)
+      write(hdr,1) ndim,nflds,npoints,msmp,tags
+    1 format('#hpts',1x,i1,1x,i2,1x,i12,1x,i6,1x,a)
+      test_pattern = 6.54321
+
+      ioff = 0
+      call hpts_bput(hdr,iHeaderSize/4,ioff,0,ie1)
+      ioff = iHeaderSize
+      call hpts_bput(test_pattern,1,ioff,0,ie2)
+
+      do k=1,ndim                           ! columns x, y[, z]
+      do i=1,npts
+         hsmp(i+npts*(k-1)) = pts(k,i)
+      enddo
+      enddo
+      ioff = iHeaderSize + 4
+      call hpts_bwrite(hsmp,1,ndim,ioff,ie3)
+
+      ihoff = npoints
+      ihoff = ioff + 4*ndim*ihoff
+      ierr  = ie1 + ie2 + ie3
+      call err_chk(ierr,'Error writing hpts.bin in hpts_bin. $')
 
       return
       end
 c-----------------------------------------------------------------------
-      subroutine hpts_out(fieldout,nflds,nfldm,npoints,nbuff)
+      subroutine hpts_flush
+c
+c     Append the buffered samples to hpts.bin (all ranks, see hpts_bin)
 
       include 'SIZE'
-      include 'TOTAL'
+      include 'PARALLEL'
+      include 'HPTS'
 
-      real buf(nfldm,nbuff),fieldout(nfldm,nbuff)
+      integer*8 ioff,npt8
 
-      len = wdsize*nfldm*nbuff
+      if (.not.ifhpts .or. nsmp.eq.0) return
 
+      nt = nsmp
+      if (nt.lt.msmp) then                  ! pack to u(nt,npts,nflds)
+         do j=1,nhpts*nhflds
+         do i=1,nt
+            hsmp(i+nt*(j-1)) = hsmp(i+msmp*(j-1))
+         enddo
+         enddo
+      endif
+
+      call hpts_bput(nt,1,ihoff,0,ie1)
+      ioff = ihoff + 4
+      call hpts_bput(tsmp,2*nt,ioff,0,ie2)
+      ioff = ioff + 8*nt
+      call hpts_bwrite(hsmp,nt,nhflds,ioff,ie3)
 
-      npass = npoints/nbuff + 1
-      il = mod(npoints,nbuff)
-      if(il.eq.0) then
-         il = nbuff
-         npass = npass-1
+      npt8  = nhpoints
+      ihoff = ioff + 4*nt*nhflds*npt8
+      nsmp  = 0
+      ierr  = ie1 + ie2 + ie3
+#ifndef MPIIO
+      if (nid.eq.0 .and. ierr.eq.0) then    ! push the block to the file
+         call byte_select(3)
+         call byte_seek(ihoff,ierr)
+         call byte_select(1)
       endif
+#endif
+      call err_chk(ierr,'Error writing hpts.bin in hpts_flush. $')
 
-      do ipass = 1,npass
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_close
+c
+c     Flush and close hpts.bin (nek_end)
 
-        call nekgsync
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'HPTS'
 
-        if(ipass.lt.npass) then
-          if(nid.eq.0) then
-            call crecv(ipass,buf,len)
-            do ip = 1,nbuff
-              write(50,'(1p20E15.7)') time,
-     &         (buf(i,ip), i=1,nflds)
-            enddo
-          elseif(nid.eq.ipass) then
-            call csend(ipass,fieldout,len,0,nid)
-          endif
+      if (.not.ifhpts) return
+      call hpts_flush
 
-        else  !ipass.eq.npass
+      ierr = 0
+#ifdef MPIIO
+      call byte_close_mpi(ifh_hpts,ierr)
+#else
+      if (nid.eq.0) then
+         call byte_select(3)
+         call byte_close(ierr)
+         call byte_select(1)
+      endif
+#endif
+      ifhpts = .false.
+      call err_chk(ierr,'Error closing hpts.bin. $')
 
-          if(nid.eq.0) then
-            do ip = 1,il
-              write(50,'(1p20E15.7)') time,
-     &         (fieldout(i,ip), i=1,nflds)
-            enddo
-          endif
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_bwrite(u,nt,ncol,ioff,ierr)
+c
+c     Write the columns u(nt,nhpts,ncol) of my points to hpts.bin;
+c     column k of point ig is at byte ioff+4*nt*((k-1)*npoints+ig-1).
+c     With MPI-IO every rank writes (or its i/o node, see io_init),
+c     otherwise rank 0 gathers and writes the points of all ranks.
 
-        endif
-      enddo
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+      include 'HPTS'
+
+      real*4 u(1)
+      integer*8 ioff,ioffk
+
+#ifdef MPIIO
+      iw0 = pid0
+      iw1 = pid1
+#else
+      iw0 = 0
+      iw1 = np-1
+#endif
+      ierr = 0
+      idum = 1
+      nw   = nt*nhpts
+
+      if (nid.eq.iw0) then
+         do k=1,ncol                        ! my points
+            ioffk = k-1
+            ioffk = ioff + 4*nt*(ioffk*nhpoints + nid*nhpb)
+            call hpts_bput(u(1+nw*(k-1)),nw,ioffk,-1,ie)
+            ierr = ierr + ie
+         enddo
+         do j=nid+1,iw1                     ! points of my children
+            nj = min(nhpb,nhpoints-j*nhpb)
+            if (nj.gt.0) then
+               call csend(j,idum,4,j,0)     ! handshake
+               do k=1,ncol
+                  call crecv(j,hrcv,4*nt*nj)
+                  ioffk = k-1
+                  ioffk = ioff + 4*nt*(ioffk*nhpoints + j*nhpb)
+                  call hpts_bput(hrcv,nt*nj,ioffk,-1,ie)
+                  ierr = ierr + ie
+               enddo
+            endif
+         enddo
+      elseif (nhpts.gt.0) then
+         call crecv(nid,idum,4)             ! handshake
+         do k=1,ncol
+            call csend(nid,u(1+nw*(k-1)),4*nw,iw0,0)
+         enddo
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine hpts_bput(buf,n,ioff,iorank,ierr)
+c
+c     Write buf(1:n) at byte ioff of hpts.bin; iorank >= 0: that rank
+c     only, the others join the collective MPI-IO write with no data.
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'HPTS'
+
+      real*4 buf(1)
+      integer*8 ioff
+
+#ifdef MPIIO
+      call byte_set_view (ioff,ifh_hpts)
+      call byte_write_mpi(buf,n,iorank,ifh_hpts,ierr)
+#else
+      ierr = 0
+      if (iorank.ge.0 .and. nid.ne.iorank) return
+      call byte_select(3)
+      if (ioff.gt.0) call byte_seek(ioff,ierr) ! file is open
+      if (ierr.eq.0) call byte_write(buf,n,ierr)
+      call byte_select(1)
+#endif
 
       return
       end
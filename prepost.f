@@ -1387,6 +1387,7 @@ c-----------------------------------------------------------------------
      &              , ur2(lxo*lxo*lxo*lelt)
      &              , ur3(lxo*lxo*lxo*lelt)
 
+      call mfo_async_wait                 ! finish previous async output
       tiostart=dnekclock_sync()
 
       ifxyo_s = ifxyo 
@@ -1415,10 +1416,12 @@ c-----------------------------------------------------------------------
       call err_chk(ierr,'Error opening file in mfo_open_files. $')
       call bcast(ifxyo_,lsize)
       ifxyo = ifxyo_
+      call mfo_zip_init(nout,nxo*nyo*nzo)  ! compress if p143 .ne. 0
       call mfo_write_hdr                     ! create element mapping +
 
 c     call exitti('this is wdsizo A:$',wdsizo)
                                              ! write hdr
+      call mfo_async_init(nout,nxo*nyo*nzo)  ! stage fields if p140 > 0
       nxyzo8  = nxo*nyo*nzo
       strideB = nelB * nxyzo8*wdsizo
       stride  = nelgt* nxyzo8*wdsizo
@@ -1488,6 +1491,7 @@ c     call exitti('this is wdsizo A:$',wdsizo)
          endif
       enddo
       dnbyte = 1.*ioflds*nout*wdsizo*nxo*nyo*nzo
+      if (izipo.ne.0) dnbyte = dzbyte
 
       if (if3d) then
          offs0   = offs0 + ioflds*stride
@@ -1528,6 +1532,20 @@ c     call exitti('this is wdsizo A:$',wdsizo)
          dnbyte = dnbyte + 2.*ioflds*nout*wdsizo
       endif
 
+      if (ifasyo) then                  ! hand off the staged fields
+         call mfo_async_start
+         tio = dnekclock_sync()-tiostart
+         dnbyte = glsum(dnbyte,1)
+         dnbyte = dnbyte + iHeaderSize + 4. + isize*nelgt
+         dnbyte = dnbyte/1024/1024
+         if(nio.eq.0) write(6,8) istep,time,dnbyte,tio
+    8    format(/,i9,1pe12.4,' queued :: Write checkpoint',/,
+     &          30X,'file size = ',3pG12.2,'MB',/,
+     &          30X,'staging time = ',0pf9.3,' sec',/)
+         ifxyo = ifxyo_s
+         return
+      endif
+
       ierr = 0
       if (nid.eq.pid0) 
 #ifdef MPIIO
@@ -1597,6 +1615,17 @@ c-----------------------------------------------------------------------
 
       call nek_comm_io(nfileo)
 
+      ifasyo = .false.                   ! p140 > 0 --> async output
+      izipd  = 0                         ! p144 > 0 --> delta restart
+      izipb  = 0
+      izsto  = -1                        ! no reference written/read yet
+      izstr  = -1
+      tzsto  = 0.
+      tzstr  = 0.
+      nasync = 0
+      masync = 0
+      call create_comm(nekcomm_async)
+
       wdsizo = 4                             ! every proc needs this
       if (param(63).gt.0) wdsizo = 8         ! 64-bit .fld file
       if (wdsizo.gt.wdsize) then
@@ -1844,6 +1873,10 @@ c
 c       .save_size = 8 ==> dbl. precision output
 c
 c       .nfldi is the number of rs files to save before overwriting
+c
+c     p144 > 0: the first file of each set is a compressed base, the
+c     others only hold the (compressed) XOR with the previous file,
+c     see mfo_zip_init.  full_restart has to read the set in order.
 c
 
       include 'SIZE'
@@ -1897,9 +1930,16 @@ c                                      ! is the only form used for restart
          if_full_pres_tmp = if_full_pres     
          if (save_size.eq.8) if_full_pres = .true. !Preserve mesh 2 pressure
 
+         if (param(144).gt.0 .and. .not.ifmhd) then
+            izipd = 2                         ! delta to previous file
+            if (mt.eq.0 .or. izipb.eq.1) izipd = 1      ! base
+            izipb = 0
+         endif
+
          if (ifmhd) call outpost2(bx,by,bz,pm,t,0      ,prefix)  ! first B
                     call outpost2(vx,vy,vz,pr,t,npscal1,prefix)  ! then  U
 
+         izipd     = 0
          wdsizo    = iwdsizo  ! Restore output parameters
 
          param(66) = p66
@@ -1911,6 +1951,275 @@ c     if (nid.eq.0) write(6,8) istep,prefix,nfld,nfld2,i2,m1,mt
 c  8  format(i8,' prefix ',a3,5i5)
 
       if_full_pres = .false.
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buddy_save ! in-memory checkpoint every p145 steps
+
+c     Diskless checkpoint: every p145 steps, each rank keeps a copy of
+c     its state (see buddy_state) and sends it to rank mod(nid+np/2,np),
+c     which keeps it as a mirror.  The copies live in C memory
+c     (buddy_put, chelpers.c), nothing is allocated for p145 = 0.
+c     buddy_restore rolls back to the checkpoint.
+c
+c     The copies live as long as the job: they serve a rollback within
+c     the run, which the user triggers by calling buddy_restore from
+c     userchk (e.g., on a NaN).  A new job starts from the restart files.
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+
+      logical ifwarn
+      save    ifwarn
+      data    ifwarn /.true./
+
+      if (param(145).le.0 .or. istep.eq.0) return
+      if (mod(istep,int(param(145))).ne.0) return
+
+      if (ifmvbd.or.ifmhd.or.ifpert.or.ifcmt) then
+         if (nio.eq.0.and.ifwarn) write(6,*)
+     $      'WARNING: no in-memory checkpoint for this case (p145)'
+         ifwarn = .false.
+         return
+      endif
+
+      call buddy_take
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buddy_take ! take the in-memory checkpoint now
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+
+      etime0 = dnekclock_sync()
+
+      ierr = 0
+      call buddy_state(1,ierr)
+      nbud = ibud
+      ierr = iglmax(ierr,1)
+      if (ierr.eq.0) call buddy_xchg(1,ierr)
+      call err_chk(ierr,'Error in buddy_save, out of memory?$')
+
+      etime0 = dnekclock_sync()-etime0
+      if (nio.eq.0) write(6,1) istep,etime0
+    1 format(i9,1pe12.4,' done :: in-memory checkpoint')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buddy_restore(ierr) ! roll back to in-memory checkpoint
+
+c     Restore the state saved by the last buddy_save.  A rank without
+c     a copy of its own (e.g., lost and replaced) gets it back from its
+c     partner.  ierr .ne. 0 on all ranks if there is no checkpoint, or
+c     a state can not be recovered; the state is unchanged then.
+c     Nothing calls this by itself, see buddy_save.
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+
+      ierr = 1
+      if (param(145).le.0) return
+
+      call buddy_xchg(-1,ierr)
+      if (ierr.ne.0) return
+
+      call buddy_state(-1,ierr)
+      call err_chk(ierr,'Error in buddy_restore.$')
+
+      if (nio.eq.0) write(6,1) istep,time
+    1 format(i9,1pe14.7,' done :: restore in-memory checkpoint')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buddy_state(idir,ierr) ! save (idir>0) or restore state
+
+c     Fields, lagged fields and extrapolated convective terms, as used
+c     by the next step, plus the time step history.  Projection spaces
+c     are not kept, so the solvers continue from a cold start.
+
+      include 'SIZE'
+      include 'TOTAL'
+      include 'RESTART'
+
+      real s(13)
+
+      nv  = lx1*ly1*lz1*nelv
+      nt  = lx1*ly1*lz1*nelt
+      np2 = lx2*ly2*lz2*nelv
+
+      if (idir.gt.0) then
+         s(1) = time
+         s(2) = dt
+         s(3) = istep
+         call copy(s(4),dtlag,10)
+      endif
+
+      ibud = 0
+      call buddy_fld(s,13,idir,ierr)
+
+      if (ifflow) then
+         call buddy_fld(vx  ,nv,idir,ierr)
+         call buddy_fld(vy  ,nv,idir,ierr)
+         if (if3d) call buddy_fld(vz,nv,idir,ierr)
+         call buddy_fld(pr  ,np2,idir,ierr)
+         call buddy_fld(abx1,nv,idir,ierr)
+         call buddy_fld(aby1,nv,idir,ierr)
+         call buddy_fld(abx2,nv,idir,ierr)
+         call buddy_fld(aby2,nv,idir,ierr)
+         if (if3d) call buddy_fld(abz1,nv,idir,ierr)
+         if (if3d) call buddy_fld(abz2,nv,idir,ierr)
+         do k=1,2
+            call buddy_fld(vxlag(1,1,1,1,k),nv,idir,ierr)
+            call buddy_fld(vylag(1,1,1,1,k),nv,idir,ierr)
+            if (if3d) call buddy_fld(vzlag(1,1,1,1,k),nv,idir,ierr)
+         enddo
+         do k=1,lorder2
+            call buddy_fld(prlag(1,1,1,1,k),np2,idir,ierr)
+         enddo
+      endif
+
+      do j=1,nfield-1                  ! temperature and scalars
+         call buddy_fld(t(1,1,1,1,j)      ,nt,idir,ierr)
+         call buddy_fld(vgradt1(1,1,1,1,j),nt,idir,ierr)
+         call buddy_fld(vgradt2(1,1,1,1,j),nt,idir,ierr)
+         do k=1,lorder-1
+            call buddy_fld(tlag(1,1,1,1,k,j),nt,idir,ierr)
+         enddo
+      enddo
+
+      if (ifchar) then                 ! convecting field history
+         do k=1,lorder+1
+            call buddy_fld(c_vx(1,k),lxd*lyd*lzd*nelv*ndim,idir,ierr)
+         enddo
+      endif
+
+      if (idir.lt.0 .and. ierr.eq.0) then
+         time  = s(1)
+         dt    = s(2)
+         istep = s(3)
+         call copy(dtlag,s(4),10)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buddy_fld(u,n,idir,ierr) ! save/restore n reals
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real u(n)
+
+      nw = n*wdsize/4
+      if (idir.gt.0) then
+         call buddy_put(1,u,ibud,nw,ier)
+      else
+         call buddy_get(1,u,ibud,nw,ier)
+      endif
+      ibud = ibud + nw
+      ierr = max(ierr,ier)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine buddy_xchg(idir,ierr) ! exchange with partner ranks
+
+c     idir > 0: send the nbud words of the own copy to rank jb, and keep
+c               the copy received from rank js as mirror
+c     idir < 0: ranks that lost their own copy get it back from jb;
+c               ierr .ne. 0 on all ranks if that is not possible
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      parameter (lw=lx1*ly1*lz1*lelt)
+      common /cbudw/ w(lw),w2(lw)
+
+      parameter (mtag=8717)           ! mtag+1: 2nd handshake
+
+      jb = mod(nid+np/2   ,np)        ! holds the mirror of nid
+      js = mod(nid+np-np/2,np)        ! nid holds the mirror of js
+      lwb = lw*wdsize/4               ! chunk size, 4-byte words
+
+      if (idir.gt.0) then
+         if (np.eq.1) return
+         msg = irecv(mtag,ms,isize)   ! # words to mirror
+         call csend(mtag,nbud,isize,jb,0)
+         call msgwait(msg)
+         ns = 0                       ! words sent, received
+         nr = 0
+         do while (ns.lt.nbud .or. nr.lt.ms)
+            mr = min(lwb,ms-nr)
+            if (mr.gt.0) msg = irecv(mtag,w2,4*mr)
+            m  = min(lwb,nbud-ns)
+            if (m.gt.0) then
+               call buddy_get(1,w,ns,m,ier)
+               ierr = max(ierr,ier)
+               call csend(mtag,w,4*m,jb,0)
+               ns = ns + m
+            endif
+            if (mr.gt.0) then
+               call msgwait(msg)
+               call buddy_put(2,w2,nr,mr,ier)
+               ierr = max(ierr,ier)
+               nr = nr + mr
+            endif
+         enddo
+         return
+      endif
+
+      call buddy_len(1,nown)
+      ilost = 0
+      if (nown.eq.0) ilost = 1
+      ineed = 0
+      mhave = 0
+      mgot  = 0
+      if (np.gt.1) then
+         msg = irecv(mtag,ineed,isize)   ! js lost its copy?
+         call csend(mtag,ilost,isize,jb,0)
+         call msgwait(msg)
+         if (ineed.ne.0) call buddy_len(2,mhave)
+         msg = irecv(mtag+1,mgot,isize)  ! # words jb can send back
+         call csend(mtag+1,mhave,isize,js,0)
+         call msgwait(msg)
+      endif
+
+      ierr = 0
+      if (ilost.ne.0 .and. mgot.eq.0) ierr = 1
+      ierr = iglmax(ierr,1)
+      if (iglmax(nown,1).eq.0) ierr = 1
+      if (ierr.ne.0) return
+
+      ns = 0
+      nr = 0
+      do while (ns.lt.mhave .or. nr.lt.mgot)
+         mr = min(lwb,mgot-nr)
+         if (mr.gt.0) msg = irecv(mtag,w2,4*mr)
+         m  = min(lwb,mhave-ns)
+         if (m.gt.0) then
+            call buddy_get(2,w,ns,m,ier)
+            ierr = max(ierr,ier)
+            call csend(mtag,w,4*m,js,0)
+            ns = ns + m
+         endif
+         if (mr.gt.0) then
+            call msgwait(msg)
+            call buddy_put(1,w2,nr,mr,ier)
+            ierr = max(ierr,ier)
+            nr = nr + mr
+         endif
+      enddo
+      ierr = iglmax(ierr,1)
+
       return
       end
 c-----------------------------------------------------------------------
@@ -2014,6 +2323,11 @@ c-----------------------------------------------------------------------
 
       integer e
 
+      if (ifasyo) then
+         call mfo_async_addm(u,v,w,nel,ndim,nx1*ny1*nz1)
+         return
+      endif
+
       call nekgsync() ! clear outstanding message queues.
 
       nxyz = nx1*ny1*nz1
@@ -2103,6 +2417,11 @@ c-----------------------------------------------------------------------
 
       integer e
 
+      if (ifasyo) then
+         call mfo_async_addm(u,u,u,nel,1,nx1*ny1*nz1)
+         return
+      endif
+
       call nekgsync() ! clear outstanding message queues.
 
       nxyz = nx1*ny1*nz1
@@ -2161,6 +2480,59 @@ c-----------------------------------------------------------------------
 
       call err_chk(ierr,'Error writing data to .f00 in mfo_mdatas. $')
 
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_gather(nwpe,kdone,ierr) ! pipelined child gather
+
+c     Receive and write the data of the children of this i/o node.
+c     Up to lring messages are in flight at once, in slots carved out
+c     of uasync (which is idle for synchronous output), so that disk
+c     writes overlap with the receives of the next children.  Messages
+c     are as sent by mfo_outs/mfo_outv: 8 byte nel, then nwpe words per
+c     element.  On return, children pid0+1..kdone have been written;
+c     kdone=pid0 if uasync cannot hold two slots.
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      parameter (lring=8)
+      integer   islot(lring),imsg(lring)
+
+      kdone = pid0
+      ls    = 2 + nwpe*lelt             ! slot size in 4-byte words
+      ls    = 2*((ls+1)/2)              ! keep slots 8-byte aligned
+      nslot = min(lring,lasync/ls,pid1-pid0)
+      if (nslot.lt.2) return
+
+      idum = 1
+      do i=1,nslot                      ! prime the pipeline
+         islot(i) = 1 + (i-1)*ls
+         k        = pid0 + i
+         imsg(i)  = irecv(k,uasync(islot(i)),4*ls)
+         call csend(k,idum,4,k,0)       ! handshake
+      enddo
+
+      do k=pid0+1,pid1
+         i = mod(k-pid0-1,nslot) + 1
+         call msgwait(imsg(i))
+         j    = islot(i)
+         nout = nwpe * u8async((j+1)/2)
+         if(ierr.eq.0) 
+#ifdef MPIIO
+     &      call byte_write_mpi(uasync(j+2),nout,-1,ifh_mbyte,ierr)
+#else
+     &      call byte_write(uasync(j+2),nout,ierr)
+#endif
+         kn = k + nslot
+         if (kn.le.pid1) then           ! refill the slot
+            imsg(i) = irecv(kn,uasync(j),4*ls)
+            call csend(kn,idum,4,kn,0)  ! handshake
+         endif
+      enddo
+      kdone = pid1
+
       return
       end
 c-----------------------------------------------------------------------
@@ -2180,6 +2552,15 @@ c-----------------------------------------------------------------------
 
       integer e
 
+      if (ifasyo) then
+         call mfo_async_adds(u,nel,mx*my*mz)
+         return
+      endif
+      if (izipo.ne.0) then
+         call mfo_outz(u,u,u,nel,mx,1)
+         return
+      endif
+
       call nekgsync() ! clear outstanding message queues.
       if(mx.gt.lxo .or. my.gt.lxo .or. mz.gt.lxo) then
         if(nid.eq.0) write(6,*) 'ABORT: lxo too small'
@@ -2210,8 +2591,9 @@ c-----------------------------------------------------------------------
 #endif
 
          ! write out the data of my childs
+         call mfo_gather(wdsizo/4*nxyz,kdone,ierr)
          idum  = 1
-         do k=pid0+1,pid1
+         do k=kdone+1,pid1
             mtype = k
             call csend(mtype,idum,4,k,0)       ! handshake
             call crecv(mtype,u4,len)
@@ -2268,6 +2650,15 @@ c-----------------------------------------------------------------------
 
       integer e
 
+      if (ifasyo) then
+         call mfo_async_addv(u,v,w,nel,mx*my*mz)
+         return
+      endif
+      if (izipo.ne.0) then
+         call mfo_outz(u,v,w,nel,mx,ndim)
+         return
+      endif
+
       call nekgsync() ! clear outstanding message queues.
       if(mx.gt.lxo .or. my.gt.lxo .or. mz.gt.lxo) then
         if(nid.eq.0) write(6,*) 'ABORT: lxo too small'
@@ -2313,7 +2704,8 @@ c-----------------------------------------------------------------------
      &     call byte_write(u4,nout,ierr)          ! u4 :=: u8
 #endif
          ! write out the data of my childs
-         do k=pid0+1,pid1
+         call mfo_gather(wdsizo/4*nxyz*ndim,kdone,ierr)
+         do k=kdone+1,pid1
             mtype = k
             call csend(mtype,idum,4,k,0)           ! handshake
             call crecv(mtype,u4,len)
@@ -2401,6 +2793,8 @@ c-----------------------------------------------------------------------
            call crecv(mtype,inelp,4)
            nelo = nelo + inelp
         enddo
+        nelao = nelo
+        ioffz = iHeaderSize + 4 + isize*nelo
       else
         mtype = nid
         call crecv(mtype,idum,4)          ! hand-shake
@@ -2446,6 +2840,12 @@ c-----------------------------------------------------------------------
      $         ,   (rdcode1(i),i=1,10)        ! 74+20=94
     1 format('#std',1x,i1,1x,i2,1x,i2,1x,i2,1x,i10,1x,i10,1x,e20.13,
      &       1x,i9,1x,i6,1x,i6,1x,10a)
+      if (izipo.ne.0) then             ! compressed, see mfo_outz
+         hdr(1:4) = '#zip'
+         write(hdr(95:95),'(i1)') izipo
+         if (izipo.eq.4)                ! step, time of its base
+     $      write(hdr(97:127),'(i10,1x,e20.13)') izsto,tzsto
+      endif
 
       ! if we want to switch the bytes for output
       ! switch it again because the hdr is in ASCII
@@ -2467,6 +2867,10 @@ c      if (ibsw_out.ne.0) call set_bytesw_write(ibsw_out)
       endif
 
       call err_chk(ierr,'Error writing header in mfo_write_hdr. $')
+      if (izipo.ge.3) then             ! base of the next delta
+         izsto = istep
+         tzsto = time
+      endif
 
       ! write global element numbering for this group
       if(nid.eq.pid0) then
@@ -2505,3 +2909,491 @@ c      if (ibsw_out.ne.0) call set_bytesw_write(ibsw_out)
       return
       end
 c-----------------------------------------------------------------------
+      subroutine mfo_async_init(nel,nxyz) ! stage output if p140 > 0
+
+c     Asynchronous field output: instead of the handshake and write in
+c     mfo_outs/mfo_outv, every rank copies its part of the file into
+c     uasync and passes it to its i/o node (pid0) with a non-blocking
+c     send.  The i/o node writes the chunks that have arrived at each
+c     call to mfo_async_poll, i.e., once per time step, and the next
+c     checkpoint or the end of the run waits for the remaining ones
+c     (mfo_async_wait).  The file is kept on byte.c handle 2 between
+c     the steps; opening another byte file (mbyte_open) still waits
+c     for the async output to complete.
+c     Requires the byte (non-MPIIO) writer.
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'RESTART'
+
+      ifasyo = .false.
+#ifndef MPIIO
+      if (param(140).le.0) return
+      if (izipo.ne.0) return             ! compressed: synchronous
+
+      ncomp = 0
+      if (ifxyo) ncomp = ncomp + ndim
+      if (ifvo ) ncomp = ncomp + ndim
+      if (ifpo ) ncomp = ncomp + 1
+      if (ifto ) ncomp = ncomp + 1
+      do k=1,ldimt-1
+         if (ifpsco(k)) ncomp = ncomp + 1
+      enddo
+
+      need = ncomp*nxyz*(wdsizo/4)
+      if (if3d) need = need + 2*ncomp     ! min/max meta data
+      need = 2 + nel*need
+      need = iglmax(need,1)
+      if (need.gt.lasync) then
+         if (nio.eq.0) write(6,*) 'WARNING: lasync too small',need,
+     $                  lasync,', write checkpoint synchronously'
+         return
+      endif
+
+      ifasyo = .true.
+      nablk  = 0
+      kasync = 3
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_blk(nwd,nel) ! close a staged block
+
+      include 'SIZE'
+      include 'RESTART'
+
+      nablk = nablk + 1
+      if (nablk.gt.lablk) call exitti('ABORT: lablk too small$',nablk)
+      kablk(nablk) = nwd
+      kasync = kasync + nwd*nel
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_adds(u,nel,nxyz) ! stage a scalar field
+
+      include 'SIZE'
+      include 'RESTART'
+
+      real u(nxyz*nel)
+
+      n = nxyz*nel
+      if (wdsizo.eq.4) then             ! 32-bit output
+         call copyx4(uasync(kasync),u,n)
+      else
+         call copy  (u8async((kasync+1)/2),u,n)
+      endif
+      call mfo_async_blk(nxyz*wdsizo/4,nel)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_addv(u,v,w,nel,nxyz) ! stage a vector field
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'RESTART'
+
+      real u(nxyz,1),v(nxyz,1),w(nxyz,1)
+      integer e
+
+      if (wdsizo.eq.4) then             ! 32-bit output
+         j = kasync
+         do e=1,nel
+            call copyx4   (uasync(j),u(1,e),nxyz)
+            j = j + nxyz
+            call copyx4   (uasync(j),v(1,e),nxyz)
+            j = j + nxyz
+            if(if3d) then
+              call copyx4 (uasync(j),w(1,e),nxyz)
+              j = j + nxyz
+            endif
+         enddo
+      else
+         j = (kasync+1)/2
+         do e=1,nel
+            call copy     (u8async(j),u(1,e),nxyz)
+            j = j + nxyz
+            call copy     (u8async(j),v(1,e),nxyz)
+            j = j + nxyz
+            if(if3d) then
+              call copy   (u8async(j),w(1,e),nxyz)
+              j = j + nxyz
+            endif
+         enddo
+      endif
+      call mfo_async_blk(ndim*nxyz*wdsizo/4,nel)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_addm(u,v,w,nel,ncomp,nxyz) ! stage min/max
+
+      include 'SIZE'
+      include 'RESTART'
+
+      real u(lx1*ly1*lz1,1),v(lx1*ly1*lz1,1),w(lx1*ly1*lz1,1)
+      integer e
+
+      j = kasync
+      do e=1,nel
+         uasync(j+0) = vlmin(u(1,e),nxyz) 
+         uasync(j+1) = vlmax(u(1,e),nxyz)
+         j = j + 2
+         if(ncomp.gt.1) then
+           uasync(j+0) = vlmin(v(1,e),nxyz) 
+           uasync(j+1) = vlmax(v(1,e),nxyz)
+           j = j + 2
+         endif
+         if(ncomp.gt.2) then
+           uasync(j+0) = vlmin(w(1,e),nxyz) 
+           uasync(j+1) = vlmax(w(1,e),nxyz)
+           j = j + 2
+         endif
+      enddo
+      call mfo_async_blk(2*ncomp,nel)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_start ! hand the staged fields to pid0
+
+      include 'SIZE'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      integer*8 ioff,nwd8
+
+      ifasyo    = .false.
+      iasync(1) = nelt
+      iasync(2) = nelB
+
+      if (nid.eq.pid0) then
+         ioff = iHeaderSize + 4 + isize*nelao
+         do k=1,nablk                   ! block k of rank j starts at
+            kaoff(k) = ioff             ! kaoff(k) + 4*kablk(k)*nelB_j
+            nwd8 = kablk(k)
+            ioff = ioff + 4*nwd8*nelao
+         enddo
+         nelbao = nelB
+         nasync = pid1-pid0+1
+         masync = 0                     ! my own chunk is in uasync
+         call byte_move(2,ierr)         ! keep handle 1 for other files
+         if (ierr.ne.0) call exitt0
+      else
+         len    = 4*(kasync-1)
+         masync = isendc(0,uasync,len,pid0,nekcomm_async)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_poll ! progress asynchronous output
+
+c     Write every chunk that has arrived, return at the first one
+c     still in flight
+
+      include 'SIZE'
+      include 'RESTART'
+
+      logical msgtest
+
+      if (masync.ne.0) then
+         if (.not.msgtest(masync)) return
+         masync = 0
+      endif
+      if (nid.ne.pid0) return
+
+      do while (nasync.gt.0)
+         call mfo_async_chunk           ! posts the next receive
+         if (masync.ne.0) then
+            if (.not.msgtest(masync)) return
+            masync = 0
+         endif
+      enddo
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_wait ! complete pending asynchronous output
+
+      include 'SIZE'
+      include 'RESTART'
+
+      if (masync.ne.0) call msgwait(masync)
+      masync = 0
+
+      if (nid.eq.pid0) then
+         n = nasync
+         do i=1,n
+            call mfo_async_chunk
+            if (masync.ne.0) call msgwait(masync)
+            masync = 0
+         enddo
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_async_chunk ! write the chunk in uasync (pid0 only)
+
+      include 'SIZE'
+      include 'TSTEP'
+      include 'RESTART'
+
+      integer*8 ioff,nwd8
+
+      nel  = iasync(1)
+      ielo = iasync(2) - nelbao          ! first element within file
+      ierr = 0
+
+      call byte_select(2)                ! see mfo_async_start
+      j = 3
+      do k=1,nablk
+         n    = kablk(k)*nel
+         nwd8 = kablk(k)
+         ioff = kaoff(k) + 4*nwd8*ielo
+         if (ierr.eq.0) call byte_seek(ioff,ierr)
+         if (ierr.eq.0) call byte_write(uasync(j),n,ierr)
+         j = j + n
+      enddo
+
+      nasync = nasync - 1
+      if (nasync.gt.0) then
+         masync = irecvc(0,uasync,4*lasync,nekcomm_async)
+      else
+         if (ierr.eq.0) call byte_close(ierr)
+         if (nid.eq.0) write(6,1) istep
+    1    format(i9,' done :: asynchronous write checkpoint')
+      endif
+      call byte_select(1)
+
+      if (ierr.ne.0) then
+         write(6,*) nid,' ABORT: Error in asynchronous write',ierr
+         call exitt0
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_zip_init(nel,nxyz) ! compressed output if p143.ne.0
+
+c     Compressed field data (header '#zip', see mfo_outz):
+c
+c        p143 < 0  :  lossless,  izipo = 1
+c        p143 > 0  :  lossy,     izipo = 2, pointwise error of each
+c                     field below p143 times its max. magnitude
+c
+c     restart_save sets izipd = 1 (base) or 2 (delta) for p144 > 0:
+c
+c        izipo = 3 :  lossless, kept as reference for the next file
+c        izipo = 4 :  lossless XOR with the reference (previous file)
+c
+c     Requires the byte (non-MPIIO) writer.  The blocks are packed in
+c     uasync, i.e., lxa must not be reduced in RESTART.
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'RESTART'
+
+      izipo  = 0
+      nzslot = 0
+      dzbyte = 0.
+#ifndef MPIIO
+      if (param(143).eq.0 .and. izipd.eq.0) return
+
+      need = 2 + nel*(2 + ndim*nxyz*wdsizo/4)  ! nel, nwd, index, blocks
+      need = iglmax(need,1)
+      if (need.gt.lasync) then
+         if (nio.eq.0) write(6,*) 'WARNING: lasync too small',need,
+     $                  lasync,', write uncompressed checkpoint'
+         return
+      endif
+
+      izipo = 1
+      if (param(143).gt.0) izipo = 2
+      if (izipd.gt.0) izipo = 2 + izipd
+#endif
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_outz(u,v,w,nel,mx,ncomp) ! output compressed field
+
+c     Each rank packs its elements into independent blocks (mfo_zblk),
+c     in uasync as: nel, # words of blocks, block length of each
+c     element, blocks.  The i/o node writes the block lengths of all
+c     nelao elements of the file, followed by the blocks in element
+c     order, so that any element can be located from the lengths.
+
+      include 'SIZE'
+      include 'INPUT'
+      include 'PARALLEL'
+      include 'RESTART'
+
+      real u(mx**ndim,1),v(mx**ndim,1),w(mx**ndim,1)
+
+      integer e
+      integer*8 ioffi,ioffd,nwd8
+
+      call nekgsync() ! clear outstanding message queues.
+      if(mx.gt.lxo) then
+        if(nid.eq.0) write(6,*) 'ABORT: lxo too small'
+        call exitt
+      endif
+
+      nxyz = mx**ndim
+      n    = nxyz*nel
+
+      q = 0.                           ! lossy: step of modal coeffs.
+      if (izipo.eq.2) then             ! such that nxyz*q/2 < tol*umax
+         umax = glamax(u,n)
+         if (ncomp.gt.1) umax = max(umax,glamax(v,n))
+         if (ncomp.gt.2) umax = max(umax,glamax(w,n))
+         q = 2.*param(143)*umax/nxyz
+         if (q.gt.0) q = 2.**floor(log(q)/log(2.))
+      endif
+
+      nzslot = nzslot + 1              ! reference field, see byte_xref
+      ierr = 0
+      j = 3 + nel
+      do e=1,nel
+         call mfo_zblk(uasync(j),nb,u(1,e),v(1,e),w(1,e),mx,ncomp,q
+     $                ,e,ierr)
+         iasync(2+e) = nb
+         j = j + nb
+      enddo
+      iasync(1) = nel
+      iasync(2) = j - 3 - nel
+      dzbyte = dzbyte + 4.*(j-3)
+
+      idum = 1
+      if (nid.eq.pid0) then
+         ioffi = ioffz                 ! block lengths
+         ioffd = ioffz + 4*nelao       ! blocks
+         do k=pid0,pid1
+            if (k.gt.pid0) then
+               mtype = k
+               call csend(mtype,idum,4,k,0)       ! handshake
+               call crecv(mtype,uasync,4*lasync)
+            endif
+            nelk = iasync(1)
+            nwd8 = iasync(2)
+            if(ierr.eq.0) call byte_seek (ioffi,ierr)
+            if(ierr.eq.0) call byte_write(iasync(3),nelk,ierr)
+            if(ierr.eq.0) call byte_seek (ioffd,ierr)
+            if(ierr.eq.0) call byte_write(uasync(3+nelk),iasync(2),ierr)
+            ioffi = ioffi + 4*nelk
+            ioffd = ioffd + 4*nwd8
+         enddo
+         ioffz = ioffd
+         if(ierr.eq.0) call byte_seek(ioffz,ierr) ! for the meta data
+      else
+         mtype = nid
+         call crecv(mtype,idum,4)            ! hand-shake
+         call csend(mtype,uasync,4*(j-1),pid0,0)
+      endif
+
+      call err_chk(ierr,'Error writing data to .f00 in mfo_outz. $')
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine mfo_zblk(z,nb,u,v,w,mx,ncomp,q,ie,ierr) ! pack element
+
+c     Pack ncomp components of mx**ndim values into the block z of nb
+c     4-byte words (byte_zip).  q > 0: the Legendre modal coefficients
+c     are stored instead, rounded to multiples of q (a power of 2, so
+c     trailing mantissa bits are zero).  Since |L_k| <= 1, the error
+c     is at most nxyz*q/2 pointwise.  izipo = 4: the values are XOR'ed
+c     with those of element ie in the previous file (izipo = 3 or 4).
+
+      include 'SIZE'
+      include 'RESTART'
+
+      real*4 z(1)
+      real u(1),v(1),w(1)
+
+      common /zipw/ uh(lxo*lxo*lxo),uk(lxo*lxo*lxo)
+     $            , x8(ldim*lxo*lxo*lxo)
+      real*8 x8
+      real*4 x4(2*ldim*lxo*lxo*lxo)
+      equivalence (x4,x8)
+
+      nxyz = mx**ndim
+      j    = 1
+      do k=1,ncomp
+         if (k.eq.1) call copy(uh,u,nxyz)
+         if (k.eq.2) call copy(uh,v,nxyz)
+         if (k.eq.3) call copy(uh,w,nxyz)
+         if (q.gt.0) then
+            call zip_modal(uk,uh,mx,1)
+            do i=1,nxyz
+               uh(i) = q*anint(uk(i)/q)
+            enddo
+         endif
+         if (wdsizo.eq.4) then
+            call copyx4(x4(j),uh,nxyz)
+         else
+            call copy  (x8((j+1)/2),uh,nxyz)
+         endif
+         j = j + nxyz*wdsizo/4
+      enddo
+
+      nw   = j-1
+      ixor = 1                         ! XOR neighbor values if nodal
+      if (q.gt.0) ixor = 0
+      if (izipo.ge.3) then
+         ioff = (ie-1)*nw
+         call byte_xref(x4,nw,nzslot,ioff,izipo-3,ier)
+         ierr = max(ierr,ier)
+         if (izipo.eq.4) ixor = 0
+      endif
+      call byte_zip(z,nb,x4,nw,wdsizo,ixor)
+
+      return
+      end
+c-----------------------------------------------------------------------
+      subroutine zip_modal(v,u,n,idir) ! Legendre modal <--> nodal
+
+c     v = (Li x Li x Li) u  for idir > 0  (nodal to modal)
+c     v = (L  x L  x L ) u  otherwise     (modal to nodal)
+c
+c     L(i,k) = L_k(z_i), with z the n GLL points; see mfo_zblk.
+
+      include 'SIZE'
+
+      real v(1),u(1)
+
+      parameter (lxm=lx1+6)            ! as in mapab
+      common /czipl/ zl(lxm*lxm),zlt(lxm*lxm),zli(lxm*lxm),zlit(lxm*lxm)
+     $             , zw(lxm*lxm*lxm),zz(lxm),wz(lxm)
+
+      integer nzip
+      save    nzip
+      data    nzip /0/
+
+      if (n.gt.lxm) call exitti('ABORT: zip_modal, n too large$',n)
+
+      if (n.ne.nzip) then
+         call zwgll(zz,wz,n)
+         call build_legend_transform(zli,zlit,zz,n)
+         j = 1
+         do i=1,n
+            call legendre_poly(zlt(j),zz(i),n-1)
+            j = j+n
+         enddo
+         call transpose(zl,n,zlt,n)
+         nzip = n
+      endif
+
+      if (idir.gt.0) then
+         call tensr3(v,n,u,n,zli,zlit,zlit,zw)
+      else
+         call tensr3(v,n,u,n,zl ,zlt ,zlt ,zw)
+      endif
+
+      return
+      end
+c-----------------------------------------------------------------------
@@ -69,6 +69,13 @@ c     Dummy for singlmesh
 c------------------------------------------------------------------------
       subroutine uglmin(a,n)
 
+c     Dummy for singlmesh 
+
+      return
+      end
+c------------------------------------------------------------------------
+      subroutine neknek_dt
+
 c     Dummy for singlmesh 
 
       return
@@ -92,6 +99,13 @@ c------------------------------------------------------------------------
 
 c     Dummy for singlmesh 
 
+      return
+      end
+c------------------------------------------------------------------------
+      subroutine get_values_wait
+
+c     Dummy for singlmesh
+
       return
       end
 c------------------------------------------------------------------------
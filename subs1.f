@@ -290,7 +290,7 @@ C      endif
       COURNO = DT*UMAX
 
 ! synchronize time step for multiple sessions
-      if (ifneknek) dt=uglmin(dt,1)
+      if (ifneknek) call neknek_dt
 c
       if (iffxdt.and.abs(courno).gt.10.*abs(ctarg)) then
          if (nid.eq.0) write(6,*) 'CFL, Ctarg!',courno,ctarg
@@ -2274,6 +2274,7 @@ c     Setup local SEM-based Neumann operators (for now, just full...)
    44 format(2i9,1pe22.13)
 c     stop
 
+      call set_crs_cache
       call crs_setup(xxth_strs,nekcomm,mp,n,se_to_gcrs,
      $               nnz,ia,ja,a,null_space)
 